@@ -0,0 +1,121 @@
+/**
+ * @file bench/cake_bench.cpp
+ * @brief Measures how fast Cakes get serialized into JSON
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <pizza/endpoint/cake.h>
+#include <pizza/log/logger.h>
+
+namespace
+{
+
+/// How long each measurement runs
+constexpr std::chrono::seconds k_Duration{2};
+
+/** Measure the throughput of serializing a cake
+ *
+ * @tparam Serialize is the type of the serialization function
+ * @param serialize serializes the cake and returns how many bytes it wrote
+ * @returns the throughput in bytes per second
+ */
+template <typename Serialize>
+double_t measure(const Serialize& serialize) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t bytes = 0;
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (elapsed < k_Duration)
+    {
+        for (int iteration = 0; iteration < 64; ++iteration)
+        {
+            bytes += serialize();
+        }
+        elapsed = Clock::now() - start;
+    }
+    return static_cast<double_t>(bytes) / std::chrono::duration<double_t>(elapsed).count();
+}
+
+/** Fill a cake with a typical payload
+ *
+ * @param cake is the cake to fill
+ */
+void fillTypical(pizza::endpoint::Cake& cake) noexcept
+{
+    cake.emplace("id", 1234567);
+    cake.emplace("name", "Margherita");
+    cake.emplace("description", "Tomato, mozzarella and \"fresh\" basil");
+    cake.emplace("price", 9.5);
+    cake.emplace("vegetarian", true);
+    cake.emplace("download_path", "/data/result.html");
+    cake.emplace("time_stamp", std::time(nullptr));
+}
+
+/** Fill a cake with a large payload
+ *
+ * @param cake is the cake to fill
+ * @param text is the large string to put into the cake
+ */
+void fillLarge(pizza::endpoint::Cake& cake, const std::string& text) noexcept
+{
+    cake.emplace("id", 1234567);
+    cake.emplace("first", text);
+    cake.emplace("second", text);
+}
+
+/** Report the throughput of the previous and the current serialization path
+ *
+ * @tparam Fill is the type of the filling function
+ * @param logger is the logger
+ * @param name is the name of the payload
+ * @param fill fills a cake with the payload
+ */
+template <typename Fill>
+void report(const pizza::log::Logger& logger, const std::string_view name,
+            const Fill& fill) noexcept
+{
+    pizza::endpoint::Cake cake;
+    fill(cake);
+
+    // What the previous Response::send did: json into string, and formatted into another string
+    const auto json = cake.toJson();
+    const auto previous = measure(
+        [&json]
+        {
+            const auto body = fmt::vformat("{}", fmt::make_format_args(json.dump()));
+            return body.size();
+        });
+
+    // What Response::send does now: serialized straight into a reused buffer
+    pizza::endpoint::JsonWriter::Buffer buffer;
+    const auto current = measure(
+        [&cake, &buffer]
+        {
+            buffer.clear();
+            cake.dumpTo(buffer);
+            return buffer.size();
+        });
+
+    static constexpr double_t k_MiB = 1024.0 * 1024.0;
+    logger.info("{} payload ({} bytes): previous {:.1f} MiB/s, current {:.1f} MiB/s ({:.2f}x)",
+                name, buffer.size(), previous / k_MiB, current / k_MiB, current / previous);
+}
+
+}  // namespace
+
+int main() noexcept
+{
+    const pizza::log::Logger logger{"cake_bench"};
+
+    report(logger, "Typical", fillTypical);
+
+    // Mostly plain text with the odd character that needs escaping
+    std::string text;
+    for (size_t index = 0; text.size() < 64 * 1024; ++index)
+    {
+        text += (index % 16 == 0) ? "line with a \"quote\"\n" : "plain pizza dough text ";
+    }
+    report(logger, "Large", [&text](pizza::endpoint::Cake& cake) { fillLarge(cake, text); });
+}
@@ -0,0 +1,126 @@
+/**
+ * @file bench/encoding_bench.cpp
+ * @brief Measures how fast Cakes get encoded and decoded in every encoding, and how large they are
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <pizza/endpoint/cake.h>
+#include <pizza/endpoint/encoding.h>
+#include <pizza/log/logger.h>
+
+namespace
+{
+
+/// How long each measurement runs
+constexpr std::chrono::seconds k_Duration{2};
+
+/** Measure the throughput of a coding function
+ *
+ * @tparam Code is the type of the coding function
+ * @param code encodes or decodes the cake and returns how many bytes of encoded cake it went over
+ * @returns the throughput in bytes per second
+ */
+template <typename Code>
+double_t measure(const Code& code) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t bytes = 0;
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (elapsed < k_Duration)
+    {
+        for (int iteration = 0; iteration < 64; ++iteration)
+        {
+            bytes += code();
+        }
+        elapsed = Clock::now() - start;
+    }
+    return static_cast<double_t>(bytes) / std::chrono::duration<double_t>(elapsed).count();
+}
+
+/** Fill a cake with a typical payload
+ *
+ * @param cake is the cake to fill
+ */
+void fillTypical(pizza::endpoint::Cake& cake) noexcept
+{
+    cake.emplace("id", 1234567);
+    cake.emplace("name", "Margherita");
+    cake.emplace("description", "Tomato, mozzarella and \"fresh\" basil");
+    cake.emplace("price", 9.5);
+    cake.emplace("vegetarian", true);
+    cake.emplace("download_path", "/data/result.html");
+    cake.emplace("time_stamp", std::time(nullptr));
+}
+
+/** Fill a cake with a payload of numbers, where binary encodings shine the most
+ *
+ * @param cake is the cake to fill
+ */
+void fillNumeric(pizza::endpoint::Cake& cake) noexcept
+{
+    cake.emplace("id", 1234567);
+    cake.emplace("count", 42U);
+    cake.emplace("offset", -70000);
+    cake.emplace("latitude", 37.566535);
+    cake.emplace("longitude", 126.977969);
+    cake.emplace("time_stamp", std::time(nullptr));
+    cake.emplace("is_open", false);
+    cake.emplace("discount", nullptr);
+}
+
+/** Report the wire size and the throughput of every encoding of a payload
+ *
+ * @tparam Fill is the type of the filling function
+ * @param logger is the logger
+ * @param name is the name of the payload
+ * @param fill fills a cake with the payload
+ */
+template <typename Fill>
+void report(const pizza::log::Logger& logger, const std::string_view name,
+            const Fill& fill) noexcept
+{
+    pizza::endpoint::Cake cake;
+    fill(cake);
+
+    static constexpr double_t k_MiB = 1024.0 * 1024.0;
+    static constexpr auto k_Encodings = std::to_array(
+        {pizza::endpoint::Encoding::Json, pizza::endpoint::Encoding::MessagePack,
+         pizza::endpoint::Encoding::Cbor});
+    for (const auto encoding : k_Encodings)
+    {
+        // What Response::send does: encoded straight into a reused buffer
+        pizza::endpoint::JsonWriter::Buffer buffer;
+        const auto encode = measure(
+            [&cake, &buffer, encoding]
+            {
+                buffer.clear();
+                cake.encodeTo(encoding, buffer);
+                return buffer.size();
+            });
+
+        const std::string encoded{buffer.data(), buffer.size()};
+        // What Request::getBodyJson does
+        const auto decode = measure(
+            [&encoded, encoding]
+            {
+                const auto decoded = pizza::endpoint::Encodings::decode(encoding, encoded);
+                return decoded.is_discarded() ? 0 : encoded.size();
+            });
+
+        logger.info("{} payload in {}: {} bytes, encode {:.1f} MiB/s, decode {:.1f} MiB/s", name,
+                    magic_enum::enum_name(encoding), encoded.size(), encode / k_MiB,
+                    decode / k_MiB);
+    }
+}
+
+}  // namespace
+
+int main() noexcept
+{
+    const pizza::log::Logger logger{"encoding_bench"};
+
+    report(logger, "Typical", fillTypical);
+    report(logger, "Numeric", fillNumeric);
+}
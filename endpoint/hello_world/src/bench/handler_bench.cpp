@@ -0,0 +1,364 @@
+/**
+ * @file bench/handler_bench.cpp
+ * @brief Measures what handlers cost in-process, with no network stack in the way
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <external/cxxopts/all.h>
+#include <pizza/endpoint/binding.h>
+#include <pizza/endpoint/endpoint.h>
+#include <pizza/endpoint/handler.h>
+#include <pizza/log/logger.h>
+
+namespace
+{
+
+/// The allocations made by the process, by the Worker Pool as well as by the bench threads
+std::atomic<size_t> allocations{0};
+
+}  // namespace
+
+// Every allocation of the process is counted
+void* operator new(const std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* const pointer = std::malloc(std::max<std::size_t>(size, 1)))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* const pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* const pointer, const std::size_t /* unused */) noexcept
+{
+    std::free(pointer);
+}
+
+namespace
+{
+
+/// Answers GET /ping with a small cake, which is about the least a handler does
+class PingHandler final : public pizza::endpoint::Handler
+{
+   public:
+    static constexpr std::string_view k_Name = "ping";
+
+    static constexpr auto k_ApiDesc = std::to_array<ApiDesc>({{Request::Method::Get, "/ping"}});
+
+    explicit PingHandler() noexcept : Handler{k_Name} {}
+
+   private:
+    Outcome tryValidateRequest(const Request& /* unused */, Cake& /* unused */) const override
+    {
+        return Outcome::ok();
+    }
+
+    Outcome tryProcessRequest(const Request& /* unused */, Cake& cake) const override
+    {
+        cake.emplace("message", "pong");
+        cake.emplace("time_stamp", std::time(nullptr));
+        return Outcome::ok();
+    }
+
+    void sendResponse(const Cake& cake, Response& response) const override
+    {
+        response.send(Response::Code::Ok, cake);
+    }
+};
+
+/// Represents an order, bound from the path and the body
+struct Order final
+{
+    int64_t id{0};
+    int64_t quantity{0};
+    std::optional<std::string> note;
+
+    static constexpr auto k_Fields =
+        std::make_tuple(pizza::endpoint::fromPath("id", &Order::id),
+                        pizza::endpoint::fromBody("quantity", &Order::quantity),
+                        pizza::endpoint::fromBody("note", &Order::note));
+};
+
+/// Answers POST /orders/:id with the order it binds, which goes through every wrapper there is
+class OrderHandler final : public pizza::endpoint::Handler
+{
+   public:
+    static constexpr std::string_view k_Name = "order";
+
+    static constexpr auto k_ApiDesc =
+        std::to_array<ApiDesc>({{Request::Method::Post, "/orders/:id"}});
+
+    explicit OrderHandler() noexcept : Handler{k_Name} {}
+
+   private:
+    Outcome tryValidateRequest(const Request& request, Cake& cake) const override
+    {
+        Order order;
+        if (auto outcome = pizza::endpoint::Binding::bind(request, order, cake); !outcome)
+        {
+            return outcome;
+        }
+
+        cake.emplace("id", order.id);
+        cake.emplace("quantity", order.quantity);
+        cake.emplace("note", order.note.value_or(""));
+        return Outcome::ok();
+    }
+
+    Outcome tryProcessRequest(const Request& /* unused */, Cake& /* unused */) const override
+    {
+        return Outcome::ok();
+    }
+
+    void sendResponse(const Cake& cake, Response& response) const override
+    {
+        response.send(Response::Code::Created, cake);
+    }
+};
+
+// The handlers of hello_world, along with the metrics and the batches, are linked in as well
+const auto pingName = pizza::endpoint::addHandler<PingHandler>();
+const auto orderName = pizza::endpoint::addHandler<OrderHandler>();
+
+/// Represents what is being benchmarked
+struct Scenario final
+{
+    std::string method;  ///< Represents the request method
+    std::string target;  ///< Represents the request path, along with its query
+    std::string body;    ///< Represents the request body
+};
+
+/// Represents how long the runs of a thread took
+struct Run final
+{
+    std::vector<std::chrono::nanoseconds> latencies;  ///< Represents the latency of every run
+    std::chrono::nanoseconds elapsed{0};              ///< Represents how long all runs took
+    size_t failures{0};                               ///< Represents how many runs were not 2xx
+};
+
+/// Represents the request methods scenarios may have
+constexpr auto k_Methods = std::to_array<std::pair<std::string_view, Pistache::Http::Method>>(
+    {{"GET", Pistache::Http::Method::Get},
+     {"POST", Pistache::Http::Method::Post},
+     {"PUT", Pistache::Http::Method::Put},
+     {"PATCH", Pistache::Http::Method::Patch},
+     {"DELETE", Pistache::Http::Method::Delete}});
+
+/** Find the route serving a scenario
+ *
+ * @param scenario is the scenario
+ * @returns the route if there is one, otherwise nullptr
+ */
+const pizza::endpoint::Route* findRoute(const Scenario& scenario) noexcept
+{
+    const auto method =
+        std::find_if(k_Methods.begin(), k_Methods.end(),
+                     [&scenario](const auto& method_) { return method_.first == scenario.method; });
+    if (method == k_Methods.end())
+    {
+        return nullptr;
+    }
+    const auto path = std::string_view{scenario.target}.substr(0, scenario.target.find('?'));
+    return pizza::endpoint::Endpoint::getEndpoint().findRoute(method->second, path);
+}
+
+/** Run a request on the calling thread
+ *
+ * @param request is the request
+ * @param route is the route serving the request
+ * @param iterations is how many times the request runs, after as many tenths of warming up
+ * @param start lets every thread start at once
+ * @returns the runs
+ */
+Run runRequest(const Pistache::Http::Request& request, const pizza::endpoint::Route& route,
+               const size_t iterations, std::latch& start) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto& handler = route.getHandler();
+    for (size_t iteration = 0; iteration < iterations / 10; ++iteration)
+    {
+        static_cast<void>(handler.handleInProcess(request, route));
+    }
+
+    Run run;
+    run.latencies.resize(iterations);
+    start.arrive_and_wait();
+
+    const auto started = Clock::now();
+    auto last = started;
+    for (auto& latency : run.latencies)
+    {
+        const auto captured = handler.handleInProcess(request, route);
+        run.failures += (static_cast<int>(captured.code) / 100 == 2) ? 0 : 1;
+
+        const auto now = Clock::now();
+        latency = now - last;
+        last = now;
+    }
+    run.elapsed = last - started;
+    return run;
+}
+
+/** Get a percentile of latencies
+ *
+ * @param latencies are the latencies, which get partially sorted
+ * @param percentile is the percentile, between 0 and 1
+ * @returns the latency at the percentile
+ */
+std::chrono::nanoseconds getPercentile(std::vector<std::chrono::nanoseconds>& latencies,
+                                       const double_t percentile) noexcept
+{
+    const auto size = static_cast<double_t>(latencies.size());
+    const auto index = std::min(static_cast<size_t>(percentile * size), latencies.size() - 1);
+    std::nth_element(latencies.begin(), latencies.begin() + static_cast<ptrdiff_t>(index),
+                     latencies.end());
+    return latencies.at(index);
+}
+
+/** Report what a scenario costs
+ *
+ * @param logger is the logger
+ * @param scenario is the scenario
+ * @param threads is how many threads run the scenario at once
+ * @param iterations is how many times each thread runs the scenario
+ *
+ * @details
+ * Requests go through Handler::handleInProcess, hence through the rate limiter, the response
+ * cache, the concurrency limiter and the Worker Pool for blocking handlers, as they would off a
+ * connection, but neither through single flight nor through the response writer of Pistache.
+ * Allocations are those of the whole process, the Worker Pool included.
+ */
+void report(const pizza::log::Logger& logger, const Scenario& scenario, const size_t threads,
+            const size_t iterations) noexcept
+{
+    const auto* const route = findRoute(scenario);
+    if (route == nullptr)
+    {
+        logger.error("No route serves {} {}", scenario.method, scenario.target);
+        return;
+    }
+
+    // Pistache parses the request exactly as it would have parsed it off a connection, once, and
+    // every run on every thread is handed the same request
+    const auto raw = fmt::format("{} {} HTTP/1.1\r\nContent-Type: application/json\r\n"
+                                 "Content-Length: {}\r\n\r\n{}",
+                                 scenario.method, scenario.target, scenario.body.size(),
+                                 scenario.body);
+    Pistache::Http::Private::Parser<Pistache::Http::Request> parser{raw.size()};
+    if (!parser.feed(raw.data(), raw.size()) ||
+        parser.parse() != Pistache::Http::Private::State::Done)
+    {
+        logger.error("{} {} is malformed", scenario.method, scenario.target);
+        return;
+    }
+
+    std::vector<Run> runs(threads);
+    size_t allocated = 0;
+    {
+        // This thread starts along with the others, to count what their runs allocate
+        std::latch start{static_cast<ptrdiff_t>(threads) + 1};
+        std::vector<std::jthread> workers;
+        for (auto& run : runs)
+        {
+            workers.emplace_back([&run, &parser, route, iterations, &start]
+                                 { run = runRequest(parser.request, *route, iterations, start); });
+        }
+        start.arrive_and_wait();
+        allocated = allocations.load(std::memory_order_relaxed);
+    }
+    allocated = allocations.load(std::memory_order_relaxed) - allocated;
+
+    Run total;
+    for (auto& run : runs)
+    {
+        total.latencies.insert(total.latencies.end(), run.latencies.begin(), run.latencies.end());
+        total.elapsed += run.elapsed;
+        total.failures += run.failures;
+    }
+    const auto count = static_cast<double_t>(total.latencies.size());
+    logger.info("{} {} x{}: {:.0f} ns/op, {:.1f} allocs/op, p50 {} ns, p99 {} ns, p999 {} ns{}",
+                scenario.method, scenario.target, threads,
+                static_cast<double_t>(total.elapsed.count()) / count,
+                static_cast<double_t>(allocated) / count,
+                getPercentile(total.latencies, 0.5).count(),
+                getPercentile(total.latencies, 0.99).count(),
+                getPercentile(total.latencies, 0.999).count(),
+                (total.failures == 0) ? "" : fmt::format(", {} not 2xx", total.failures));
+}
+
+}  // namespace
+
+int main(const int argc, const char** argv) noexcept
+{
+    // The handlers keep their logs out of the way of what is measured, but for the bench's own
+    pizza::log::setLevel(pizza::log::Level::Warn);
+    const pizza::log::Logger logger{"handler_bench", pizza::log::Level::Info};
+
+    cxxopts::Options options{"handler_bench", "Measures what handlers cost in-process"};
+    // clang-format off
+    options.add_options()
+        ("method", "Method of the request to benchmark", cxxopts::value<std::string>()->default_value("GET"))
+        ("target", "Path and query of the request to benchmark, whose route picks the handler, all built-in ones if empty", cxxopts::value<std::string>()->default_value(""))
+        ("body", "Body of the request to benchmark", cxxopts::value<std::string>()->default_value(""))
+        ("threads", "Threads to run the requests on, one and every core if zero", cxxopts::value<size_t>()->default_value("0"))
+        ("iterations", "Requests each thread runs", cxxopts::value<size_t>()->default_value("200000"))
+        ("help", "Print usage");
+    // clang-format on
+
+    std::vector<Scenario> scenarios;
+    std::vector<size_t> threads;
+    size_t iterations = 0;
+    try
+    {
+        const auto result = options.parse(argc, argv);
+        if (result.count("help") != 0)
+        {
+            fmt::print(stdout, "\n{}\n", options.help());
+            return 0;
+        }
+
+        if (const auto target = result["target"].as<std::string>(); !target.empty())
+        {
+            scenarios.push_back({result["method"].as<std::string>(), target,
+                                 result["body"].as<std::string>()});
+        }
+        else
+        {
+            // GET /hello downloads from pistache.io, hence is only run when asked for
+            scenarios = {{"GET", "/ping", ""},
+                         {"POST", "/orders/42", R"({"quantity":3,"note":"extra basil"})"},
+                         {"GET", "/metrics", ""},
+                         {"POST", "/batch", R"([{"path":"/ping"},{"path":"/ping"}])"}};
+        }
+
+        if (const auto count = result["threads"].as<size_t>(); count > 0)
+        {
+            threads = {count};
+        }
+        else
+        {
+            threads = {1, std::max<size_t>(std::thread::hardware_concurrency(), 1)};
+        }
+        iterations = std::max<size_t>(result["iterations"].as<size_t>(), 1);
+    }
+    catch (const cxxopts::OptionException& e)
+    {
+        logger.error("{}", e.what());
+        fmt::print(stderr, "\n{}\n", options.help());
+        return 1;
+    }
+
+    for (const auto& scenario : scenarios)
+    {
+        for (const auto count : threads)
+        {
+            report(logger, scenario, count, iterations);
+        }
+    }
+}
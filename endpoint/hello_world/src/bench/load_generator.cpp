@@ -0,0 +1,550 @@
+/**
+ * @file bench/load_generator.cpp
+ * @brief Drives a running endpoint at a fixed rate over keep-alive connections, and measures it
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <external/cxxopts/all.h>
+#include <external/posix/all.h>
+#include <pizza/endpoint/histogram.h>
+#include <pizza/log/logger.h>
+#include <pizza/support.h>
+
+namespace
+{
+
+/// Represents a route of the mix, along with what was measured of it
+struct Route final
+{
+    std::string method;       ///< Represents the request method
+    std::string target;       ///< Represents the request path, along with its query
+    size_t weight{1};         ///< Represents how many requests of the mix go to this route
+    std::string raw;          ///< Represents the whole request, as it goes on the wire
+    bool isIdempotent{true};  ///< Represents whether the request may be sent again
+
+    pizza::endpoint::Histogram latency;      ///< Represents the latencies from intended send times
+    pizza::endpoint::Histogram serviceTime;  ///< Represents the latencies from actual send times
+    std::atomic<uint64_t> succeeded{0};      ///< Represents how many responses were 2xx
+    std::atomic<uint64_t> failed{0};         ///< Represents how many responses were not 2xx
+    std::atomic<uint64_t> errors{0};         ///< Represents how many requests got no response
+};
+
+/// Represents the options of the load
+struct Options final
+{
+    sockaddr_in address{};              ///< Represents the address of the endpoint
+    std::string host;                   ///< Represents the Host header of the requests
+    size_t connections{16};             ///< Represents how many connections stay open
+    double_t rate{1000.0};              ///< Represents how many requests are sent per second
+    std::chrono::seconds duration{10};  ///< Represents how long the load lasts
+    std::string output;                 ///< Represents the file to write to, stdout if empty
+};
+
+/**
+ * A keep-alive connection to the endpoint, carrying one request at a time
+ */
+class Connection final
+{
+    NOT_COPYABLE_CLASS(Connection)
+    IMMOVEABLE_CLASS(Connection)
+
+   public:
+    /** Constructor, connects lazily
+     *
+     * @param address is the address of the endpoint
+     */
+    explicit Connection(const sockaddr_in& address) noexcept : m_address{address} {}
+
+    /// Destructor
+    ~Connection() noexcept { disconnect(); }
+
+    /// Represents how long the endpoint may take to respond
+    static constexpr std::chrono::milliseconds k_Timeout{5000};
+
+    /** Send a request and wait for its response, reconnecting if need be
+     *
+     * @param request is the whole request
+     * @param isIdempotent is whether the request may be sent again
+     * @returns the status code of the response, or nothing if there is none
+     */
+    [[nodiscard]] std::optional<int> roundTrip(const std::string_view request,
+                                               const bool isIdempotent) noexcept
+    {
+        // The endpoint may have closed an idle connection in the meantime, which is only found out
+        // by using it, hence a reused connection gets a second chance on a fresh one, unless the
+        // endpoint may have acted on the request already
+        const auto isReused = (m_socket >= 0);
+        if (auto code = tryRoundTrip(request); code || !isReused || !isIdempotent)
+        {
+            return code;
+        }
+        return tryRoundTrip(request);
+    }
+
+   private:
+    /** Send a request and wait for its response, once
+     *
+     * @param request is the whole request
+     * @returns the status code of the response, or nothing if there is none
+     */
+    [[nodiscard]] std::optional<int> tryRoundTrip(const std::string_view request) noexcept
+    {
+        if (m_socket < 0 && !connect())
+        {
+            return std::nullopt;
+        }
+
+        auto code = (sendAll(request)) ? receive() : std::nullopt;
+        if (!code || m_isClosing)
+        {
+            disconnect();
+        }
+        return code;
+    }
+
+    /** Connect to the endpoint
+     *
+     * @returns true if connected, otherwise false
+     */
+    [[nodiscard]] bool connect() noexcept
+    {
+        m_socket = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_socket < 0)
+        {
+            return false;
+        }
+
+        // Requests are small and go one at a time, Nagle would only hold them back
+        const int noDelay = 1;
+        ::setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        const auto* const address = reinterpret_cast<const sockaddr*>(&m_address);
+        if (::connect(m_socket, address, sizeof(m_address)) != 0)
+        {
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    /// Disconnect from the endpoint
+    void disconnect() noexcept
+    {
+        if (m_socket >= 0)
+        {
+            ::close(m_socket);
+            m_socket = -1;
+        }
+        m_isClosing = false;
+    }
+
+    /** Send all of a request
+     *
+     * @param request is the whole request
+     * @returns true if sent, otherwise false
+     */
+    [[nodiscard]] bool sendAll(std::string_view request) const noexcept
+    {
+        while (!request.empty())
+        {
+            const auto sent = ::send(m_socket, request.data(), request.size(), MSG_NOSIGNAL);
+            if (sent <= 0)
+            {
+                return false;
+            }
+            request.remove_prefix(static_cast<size_t>(sent));
+        }
+        return true;
+    }
+
+    /** Receive a response
+     *
+     * @returns the status code of the response, or nothing if there is none
+     */
+    [[nodiscard]] std::optional<int> receive() noexcept
+    {
+        m_buffer.clear();
+        auto headersEnd = std::string::npos;
+        while ((headersEnd = m_buffer.find("\r\n\r\n")) == std::string::npos)
+        {
+            if (!receiveSome())
+            {
+                return std::nullopt;
+            }
+        }
+
+        // "HTTP/1.1 200 OK"
+        static constexpr size_t k_CodeOffset{9};
+        static constexpr size_t k_CodeSize{3};
+        if (headersEnd < k_CodeOffset + k_CodeSize)
+        {
+            return std::nullopt;
+        }
+        int code = 0;
+        const auto* const codeBegin = m_buffer.data() + k_CodeOffset;
+        if (std::from_chars(codeBegin, codeBegin + k_CodeSize, code).ec != std::errc{})
+        {
+            return std::nullopt;
+        }
+
+        size_t contentLength = 0;
+        auto headers = std::string_view{m_buffer}.substr(0, headersEnd);
+        while (!headers.empty())
+        {
+            const auto lineEnd = std::min(headers.find("\r\n"), headers.size());
+            const auto line = headers.substr(0, lineEnd);
+            headers.remove_prefix(std::min(lineEnd + 2, headers.size()));
+
+            if (const auto value = getHeader(line, "content-length"))
+            {
+                std::from_chars(value->data(), value->data() + value->size(), contentLength);
+            }
+            else if (const auto value_ = getHeader(line, "connection"))
+            {
+                m_isClosing = pystring::lower(std::string{*value_}) == "close";
+            }
+        }
+
+        const auto responseSize = headersEnd + 4 + contentLength;
+        while (m_buffer.size() < responseSize)
+        {
+            if (!receiveSome())
+            {
+                return std::nullopt;
+            }
+        }
+        return code;
+    }
+
+    /** Receive whatever has arrived, waiting for it if nothing has
+     *
+     * @returns true if something arrived, otherwise false
+     */
+    [[nodiscard]] bool receiveSome() noexcept
+    {
+        pollfd descriptor{m_socket, POLLIN, 0};
+        if (::poll(&descriptor, 1, static_cast<int>(k_Timeout.count())) <= 0)
+        {
+            return false;
+        }
+
+        std::array<char, 16384> chunk{};
+        const auto received = ::recv(m_socket, chunk.data(), chunk.size(), 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        m_buffer.append(chunk.data(), static_cast<size_t>(received));
+        return true;
+    }
+
+    /** Get the value of a header line if it is the header asked for
+     *
+     * @param line is the header line
+     * @param name is the name of the header, in lower case
+     * @returns the trimmed value if the line is the header, otherwise nothing
+     */
+    [[nodiscard]] static std::optional<std::string_view> getHeader(
+        const std::string_view line, const std::string_view name) noexcept
+    {
+        if (line.size() <= name.size() || line[name.size()] != ':' ||
+            !std::equal(name.begin(), name.end(), line.begin(),
+                        [](const char lower, const char other)
+                        { return lower == static_cast<char>(std::tolower(other)); }))
+        {
+            return std::nullopt;
+        }
+
+        auto value = line.substr(name.size() + 1);
+        value.remove_prefix(std::min(value.find_first_not_of(' '), value.size()));
+        return value.substr(0, value.find_last_not_of(' ') + 1);
+    }
+
+    /// The address of the endpoint
+    const sockaddr_in m_address;
+
+    /// The socket, negative if disconnected
+    int m_socket{-1};
+
+    /// Indicates if the endpoint closes the connection after the response
+    bool m_isClosing{false};
+
+    /// The bytes received of the response
+    std::string m_buffer;
+};
+
+/** Parse the routes of the mix
+ *
+ * @param specs are the routes, each one as "METHOD TARGET [WEIGHT]"
+ * @param options are the options of the load
+ * @param body is the body of the requests which are not GETs
+ * @param routes are the routes to fill
+ * @returns true if every route is well-formed, otherwise false
+ */
+[[nodiscard]] bool parseRoutes(const std::vector<std::string>& specs, const Options& options,
+                               const std::string& body, std::deque<Route>& routes) noexcept
+{
+    for (const auto& spec : specs)
+    {
+        std::vector<std::string> parts;
+        pystring::split(spec, parts);
+        if (parts.size() < 2 || parts.size() > 3 || !parts.at(1).starts_with('/'))
+        {
+            return false;
+        }
+
+        size_t weight = 1;
+        if (parts.size() == 3)
+        {
+            const auto& text = parts.at(2);
+            const auto [last, errorCode] =
+                std::from_chars(text.data(), text.data() + text.size(), weight);
+            if (errorCode != std::errc{} || weight == 0)
+            {
+                return false;
+            }
+        }
+
+        auto& route = routes.emplace_back();
+        route.method = pystring::upper(parts.at(0));
+        route.target = parts.at(1);
+        route.weight = weight;
+        route.isIdempotent = (route.method == "GET" || route.method == "HEAD" ||
+                              route.method == "PUT" || route.method == "DELETE" ||
+                              route.method == "OPTIONS");
+
+        const auto& content = (route.method == "GET") ? std::string{} : body;
+        route.raw = fmt::format("{} {} HTTP/1.1\r\nHost: {}\r\nContent-Type: application/json\r\n"
+                                "Content-Length: {}\r\n\r\n{}",
+                                route.method, route.target, options.host, content.size(), content);
+    }
+    return !routes.empty();
+}
+
+/** Make the order requests go to routes in, repeating
+ *
+ * @param routes are the routes
+ * @returns the indices of the routes, each one as often as its weight, shuffled
+ */
+[[nodiscard]] std::vector<size_t> makeMix(const std::deque<Route>& routes) noexcept
+{
+    std::vector<size_t> mix;
+    for (size_t index = 0; index < routes.size(); ++index)
+    {
+        mix.insert(mix.end(), routes.at(index).weight, index);
+    }
+
+    // The same seed on every run, so that runs across commits send the same sequence
+    std::mt19937 generator{42};
+    std::shuffle(mix.begin(), mix.end(), generator);
+    return mix;
+}
+
+/** Drive a connection
+ *
+ * @param options are the options of the load
+ * @param routes are the routes
+ * @param mix is the order requests go to routes in
+ * @param connection is the index of the connection
+ * @param start is when the load starts
+ *
+ * @details
+ * The load is open: the n-th request is meant to be sent at start + n / rate, whether or not the
+ * responses before it have come back, and request n goes out over connection n % connections.
+ * A connection which falls behind sends its requests as soon as it can, and their latencies are
+ * measured from when they were meant to be sent, hence a stalled endpoint is charged for every
+ * request it held back rather than only for the one it stalled on. Requests which get no response
+ * count as though they timed out, at the least, so that errors never make latencies look better.
+ */
+void drive(const Options& options, std::deque<Route>& routes, const std::vector<size_t>& mix,
+           const size_t connection, const std::chrono::steady_clock::time_point start) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto seconds = static_cast<double_t>(options.duration.count());
+    const auto total = static_cast<size_t>(options.rate * seconds);
+    const std::chrono::duration<double_t> interval{1.0 / options.rate};
+
+    Connection connection_{options.address};
+    for (auto index = connection; index < total; index += options.connections)
+    {
+        const auto intended = start + std::chrono::duration_cast<Clock::duration>(
+                                          interval * static_cast<double_t>(index));
+        std::this_thread::sleep_until(intended);
+
+        auto& route = routes.at(mix.at(index % mix.size()));
+        const auto sent = Clock::now();
+        const auto code = connection_.roundTrip(route.raw, route.isIdempotent);
+        auto received = Clock::now();
+        if (!code)
+        {
+            received = std::max(received, sent + Connection::k_Timeout);
+            route.latency.record(received - intended);
+            route.serviceTime.record(received - sent);
+            route.errors.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        route.latency.record(received - intended);
+        route.serviceTime.record(received - sent);
+        (*code / 100 == 2 ? route.succeeded : route.failed).fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/** Summarize latencies
+ *
+ * @param counts are the counts of the latencies
+ * @returns the mean and the percentiles in microseconds
+ */
+[[nodiscard]] nlohmann::json summarize(const pizza::endpoint::Histogram::Counts& counts) noexcept
+{
+    const auto total = counts.total();
+    const auto toMicroseconds = [](const uint64_t nanoseconds)
+    { return static_cast<double_t>(nanoseconds) / 1e3; };
+
+    return {{"mean", (total == 0) ? 0.0 : toMicroseconds(counts.sum / total)},
+            {"p50", toMicroseconds(counts.quantile(0.5))},
+            {"p90", toMicroseconds(counts.quantile(0.9))},
+            {"p99", toMicroseconds(counts.quantile(0.99))},
+            {"p999", toMicroseconds(counts.quantile(0.999))}};
+}
+
+/** Report what was measured
+ *
+ * @param options are the options of the load
+ * @param routes are the routes
+ * @param elapsed is how long the load actually lasted
+ * @returns the report
+ */
+[[nodiscard]] nlohmann::json report(const Options& options, const std::deque<Route>& routes,
+                                    const std::chrono::duration<double_t> elapsed) noexcept
+{
+    pizza::endpoint::Histogram::Counts latency;
+    pizza::endpoint::Histogram::Counts serviceTime;
+    uint64_t succeeded = 0;
+    uint64_t failed = 0;
+    uint64_t errors = 0;
+
+    auto routesReport = nlohmann::json::array();
+    for (const auto& route : routes)
+    {
+        pizza::endpoint::Histogram::Counts routeLatency;
+        pizza::endpoint::Histogram::Counts routeServiceTime;
+        route.latency.mergeInto(routeLatency);
+        route.serviceTime.mergeInto(routeServiceTime);
+        route.latency.mergeInto(latency);
+        route.serviceTime.mergeInto(serviceTime);
+
+        const auto routeSucceeded = route.succeeded.load(std::memory_order_relaxed);
+        const auto routeFailed = route.failed.load(std::memory_order_relaxed);
+        const auto routeErrors = route.errors.load(std::memory_order_relaxed);
+        succeeded += routeSucceeded;
+        failed += routeFailed;
+        errors += routeErrors;
+
+        routesReport.push_back({{"method", route.method},
+                                {"target", route.target},
+                                {"weight", route.weight},
+                                {"succeeded", routeSucceeded},
+                                {"failed", routeFailed},
+                                {"errors", routeErrors},
+                                {"latency_us", summarize(routeLatency)},
+                                {"service_time_us", summarize(routeServiceTime)}});
+    }
+
+    const auto completed = succeeded + failed;
+    return {{"host", options.host},
+            {"connections", options.connections},
+            {"rate", options.rate},
+            {"duration_s", options.duration.count()},
+            {"elapsed_s", elapsed.count()},
+            {"achieved_rate", static_cast<double_t>(completed) / elapsed.count()},
+            {"succeeded", succeeded},
+            {"failed", failed},
+            {"errors", errors},
+            {"latency_us", summarize(latency)},
+            {"service_time_us", summarize(serviceTime)},
+            {"routes", std::move(routesReport)}};
+}
+
+}  // namespace
+
+int main(const int argc, const char** argv) noexcept
+{
+    const pizza::log::Logger logger{"load_generator"};
+
+    cxxopts::Options cli{"load_generator", "Drives a running endpoint at a fixed rate"};
+    // clang-format off
+    cli.add_options()
+        ("address", "Address of the endpoint", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+        ("port", "Port of the endpoint", cxxopts::value<uint16_t>()->default_value("8080"))
+        ("connections", "Keep-alive connections to open", cxxopts::value<size_t>()->default_value("16"))
+        ("rate", "Requests to send per second", cxxopts::value<double_t>()->default_value("1000"))
+        ("duration", "Seconds to send requests for", cxxopts::value<uint32_t>()->default_value("10"))
+        ("route", "Route of the mix, as \"METHOD TARGET [WEIGHT]\", repeatable", cxxopts::value<std::vector<std::string>>()->default_value("GET /metrics"))
+        ("body", "Body of the requests which are not GETs", cxxopts::value<std::string>()->default_value(""))
+        ("output", "File to write the JSON report to, stdout if empty", cxxopts::value<std::string>()->default_value(""))
+        ("help", "Print usage");
+    // clang-format on
+
+    Options options;
+    std::deque<Route> routes;
+    try
+    {
+        const auto result = cli.parse(argc, argv);
+        if (result.count("help") != 0)
+        {
+            fmt::print(stdout, "\n{}\n", cli.help());
+            return 0;
+        }
+
+        const auto address = result["address"].as<std::string>();
+        const auto port = result["port"].as<uint16_t>();
+        options.address.sin_family = AF_INET;
+        options.address.sin_port = htons(port);
+        options.host = fmt::format("{}:{}", address, port);
+        options.connections = std::max<size_t>(result["connections"].as<size_t>(), 1);
+        options.rate = result["rate"].as<double_t>();
+        options.duration = std::chrono::seconds{result["duration"].as<uint32_t>()};
+        options.output = result["output"].as<std::string>();
+
+        if (::inet_pton(AF_INET, address.c_str(), &options.address.sin_addr) != 1 ||
+            options.rate <= 0.0 ||
+            !parseRoutes(result["route"].as<std::vector<std::string>>(), options,
+                         result["body"].as<std::string>(), routes))
+        {
+            logger.error("Address, rate or routes are invalid");
+            fmt::print(stderr, "\n{}\n", cli.help());
+            return 1;
+        }
+    }
+    catch (const cxxopts::OptionException& e)
+    {
+        logger.error("{}", e.what());
+        fmt::print(stderr, "\n{}\n", cli.help());
+        return 1;
+    }
+
+    logger.info("Sending {} requests per second to {} over {} connections for {}s", options.rate,
+                options.host, options.connections, options.duration.count());
+
+    const auto mix = makeMix(routes);
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> connections;
+        for (size_t connection = 0; connection < options.connections; ++connection)
+        {
+            connections.emplace_back([&options, &routes, &mix, connection, start]
+                                     { drive(options, routes, mix, connection, start); });
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const auto json = report(options, routes, elapsed).dump(4);
+    if (options.output.empty())
+    {
+        fmt::print(stdout, "{}\n", json);
+        return 0;
+    }
+    std::ofstream{options.output} << json << '\n';
+    logger.info("Report written to {}", options.output);
+}
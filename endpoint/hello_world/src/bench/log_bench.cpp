@@ -0,0 +1,95 @@
+/**
+ * @file bench/log_bench.cpp
+ * @brief Measures what a log costs the thread making it, for every output
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <external/cxxopts/all.h>
+#include <external/posix/all.h>
+#include <pizza/log/logger.h>
+
+namespace
+{
+
+/** Measure what a log costs the thread making it
+ *
+ * @param logger is the logger the logs are made with
+ * @param output is how the logs are written out
+ * @param logs is how many logs are made
+ * @returns the nanoseconds per log
+ *
+ * @note Logs which find the ring full wait for room, hence the backend is measured too as soon as
+ * it falls behind
+ */
+double_t measure(const pizza::log::Logger& logger, const pizza::log::Output output,
+                 const size_t logs) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+
+    pizza::log::setOutput(output);
+
+    // Warms up the ring of this thread, and registers the format of binary logs
+    for (size_t log = 0; log < logs / 10; ++log)
+    {
+        logger.info<"Request {} to {} took {}us, {}">(log, "/hello", 12.5, true);
+    }
+    pizza::log::flush();
+
+    const auto start = Clock::now();
+    for (size_t log = 0; log < logs; ++log)
+    {
+        logger.info<"Request {} to {} took {}us, {}">(log, "/hello", 12.5, true);
+    }
+    const auto elapsed = Clock::now() - start;
+    pizza::log::flush();
+
+    return static_cast<double_t>(std::chrono::nanoseconds{elapsed}.count()) /
+           static_cast<double_t>(logs);
+}
+
+}  // namespace
+
+int main(const int argc, const char** argv) noexcept
+{
+    cxxopts::Options options{"log_bench", "Measures what a log costs the thread making it"};
+    // clang-format off
+    options.add_options()
+        ("logs", "Logs to make for every output", cxxopts::value<size_t>()->default_value("1000000"))
+        ("help", "Print usage");
+    // clang-format on
+
+    size_t logs = 0;
+    try
+    {
+        const auto result = options.parse(argc, argv);
+        if (result.count("help") != 0)
+        {
+            fmt::print(stdout, "\n{}\n", options.help());
+            return 0;
+        }
+        logs = std::max<size_t>(result["logs"].as<size_t>(), 1);
+    }
+    catch (const cxxopts::OptionException& e)
+    {
+        fmt::print(stderr, "{}\n\n{}\n", e.what(), options.help());
+        return 1;
+    }
+
+    // The logs measured go to stdout, which is thrown away, hence the results go to stderr
+    const auto devNull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (devNull < 0 || ::dup2(devNull, STDOUT_FILENO) < 0)
+    {
+        fmt::print(stderr, "Failed to throw stdout away\n");
+        return 1;
+    }
+    ::close(devNull);
+
+    pizza::log::configure({.overflow = pizza::log::Overflow::Block});
+    const pizza::log::Logger logger{"log_bench"};
+    for (const auto output :
+         {pizza::log::Output::Text, pizza::log::Output::Json, pizza::log::Output::Binary})
+    {
+        fmt::print(stderr, "{}: {:.0f} ns/log\n", magic_enum::enum_name(output),
+                   measure(logger, output, logs));
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ * @file bench/route_bench.cpp
+ * @brief Measures how fast requests get matched to their routes
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <pizza/endpoint/route_table.h>
+#include <pizza/log/logger.h>
+
+namespace
+{
+
+/// How many lookups each measurement does
+constexpr size_t k_Lookups{4'000'000};
+
+/// Represents the routes being benchmarked
+using Routes = std::vector<std::pair<Pistache::Http::Method, std::string>>;
+
+/** Make static routes that look like the ones of a real endpoint
+ *
+ * @param count is the number of routes
+ * @returns the routes
+ */
+Routes makeRoutes(const size_t count) noexcept
+{
+    static constexpr std::array k_Methods{Pistache::Http::Method::Get, Pistache::Http::Method::Post,
+                                          Pistache::Http::Method::Put};
+
+    Routes routes;
+    for (size_t index = 0; index < count; ++index)
+    {
+        routes.emplace_back(k_Methods.at(index % k_Methods.size()),
+                            fmt::format("/api/v1/resource_{}/items", index));
+    }
+    return routes;
+}
+
+/** Measure the lookup rate
+ *
+ * @tparam Lookup is the type of the lookup function
+ * @param routes are the routes to look up, in turns
+ * @param lookup looks a route up and returns whether it was found
+ * @returns the number of lookups per second
+ */
+template <typename Lookup>
+double_t measure(const Routes& routes, const Lookup& lookup) noexcept
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t found = 0;
+    const auto start = Clock::now();
+    for (size_t index = 0; index < k_Lookups; ++index)
+    {
+        const auto& [requestMethod, requestPath] = routes[index % routes.size()];
+        found += lookup(requestMethod, requestPath) ? 1 : 0;
+    }
+    const std::chrono::duration<double_t> elapsed = Clock::now() - start;
+
+    RUNTIME_ASSERT(found == k_Lookups && "Route is not found")
+    return static_cast<double_t>(k_Lookups) / elapsed.count();
+}
+
+/** Report the lookup rate of the Pistache router and of the Route Table
+ *
+ * @param logger is the logger
+ * @param count is the number of routes
+ */
+void report(const pizza::log::Logger& logger, const size_t count) noexcept
+{
+    const auto routes = makeRoutes(count);
+
+    // What Pistache's router does: a segment tree per method
+    std::unordered_map<Pistache::Http::Method, Pistache::Rest::SegmentTreeNode> trees;
+    const Pistache::Rest::Route::Handler handler = [](const auto&, auto)
+    { return Pistache::Rest::Route::Result::Ok; };
+    for (const auto& [requestMethod, requestPath] : routes)
+    {
+        // The tree borrows the path, the same as Pistache::Rest::Router::addRoute does
+        const std::shared_ptr<char> resource{new char[requestPath.size()],
+                                             std::default_delete<char[]>()};
+        std::memcpy(resource.get(), requestPath.data(), requestPath.size());
+        trees[requestMethod].addRoute(std::string_view{resource.get(), requestPath.size()},
+                                      handler, resource);
+    }
+    const auto router = measure(routes,
+                                [&trees](const auto requestMethod, const std::string_view path)
+                                {
+                                    const auto tree = trees.find(requestMethod);
+                                    return tree != trees.end() &&
+                                           std::get<0>(tree->second.findRoute(path)) != nullptr;
+                                });
+
+    // What the Dispatcher does: a perfect hash over all static routes
+    std::vector<pizza::endpoint::RouteTable<size_t>::Route> staticRoutes;
+    for (size_t index = 0; index < routes.size(); ++index)
+    {
+        staticRoutes.push_back({routes.at(index).first, routes.at(index).second, index});
+    }
+    const pizza::endpoint::RouteTable<size_t> routeTable{std::move(staticRoutes)};
+    const auto table = measure(routes,
+                               [&routeTable](const auto requestMethod, const std::string_view path)
+                               { return routeTable.find(requestMethod, path) != nullptr; });
+
+    logger.info("{} routes: router {:.1f} M/s, route table {:.1f} M/s ({:.2f}x)", count,
+                router / 1e6, table / 1e6, table / router);
+}
+
+}  // namespace
+
+int main() noexcept
+{
+    const pizza::log::Logger logger{"route_bench"};
+
+    for (const size_t count : {10, 100, 1000})
+    {
+        report(logger, count);
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * @file client_demo.cpp
+ * @brief Checks Pizza's outbound HTTP client against a local stand-in server, and illustrates it
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <external/pistache/all.h>
+#include <pizza/client/client.h>
+#include <pizza/log/logger.h>
+
+namespace
+{
+
+/// Stands in for an upstream service, answering every request with its own resource
+class StandIn final : public Pistache::Http::Handler
+{
+   public:
+    HTTP_PROTOTYPE(StandIn)
+
+    void onRequest(const Pistache::Http::Request& request,
+                   Pistache::Http::ResponseWriter response) override
+    {
+        response.send(Pistache::Http::Code::Ok, request.resource() + request.body());
+    }
+};
+
+/** Check a response
+ *
+ * @param logger is the logger
+ * @param call is what the call was
+ * @param response is the response
+ * @param expected is the body the stand-in answers the call with
+ * @returns true if the response is the one expected, otherwise false
+ */
+bool check(const pizza::log::Logger& logger, const std::string_view call,
+           const cpr::Response& response, const std::string_view expected) noexcept
+{
+    if (response.error || response.status_code != 200 || response.text != expected)
+    {
+        logger.error("{}: expected 200 '{}', got {} '{}' {}", call, expected,
+                     response.status_code, response.text, response.error.message);
+        return false;
+    }
+    logger.info("{}: {} '{}' in {:.3f}s", call, response.status_code, response.text,
+                response.elapsed);
+    return true;
+}
+
+}  // namespace
+
+int main() noexcept
+{
+    static constexpr size_t k_Calls{8};
+
+    const pizza::log::Logger logger{"client_demo"};
+
+    Pistache::Http::Endpoint standIn{
+        Pistache::Address{Pistache::Ipv4::loopback(), Pistache::Port{0}}};
+    standIn.init(Pistache::Http::Endpoint::options().threads(1));
+    standIn.setHandler(Pistache::Http::make_handler<StandIn>());
+    standIn.serveThreaded();
+    const auto port = static_cast<uint16_t>(standIn.getPort());
+    const auto origin = fmt::format("http://127.0.0.1:{}", port);
+
+    // Handlers share the client of the process, and so does this check
+    auto& client = pizza::client::Client::getClient();
+    size_t failures = 0;
+
+    // The first call pays for the connection, the others go out over the pooled one
+    for (size_t call = 0; call < 2; ++call)
+    {
+        if (!check(logger, "GET /blocking", client.get(origin + "/blocking"), "/blocking"))
+        {
+            ++failures;
+        }
+    }
+
+    // Several calls at once, waited for together
+    std::vector<std::future<cpr::Response>> futures;
+    for (size_t call = 0; call < k_Calls; ++call)
+    {
+        futures.emplace_back(client.sendAsync(pizza::client::Client::Method::Post,
+                                              fmt::format("{}/async/{}", origin, call), {},
+                                              "?body"));
+    }
+    for (size_t call = 0; call < k_Calls; ++call)
+    {
+        const auto path = fmt::format("/async/{}", call);
+        if (!check(logger, "POST " + path, futures.at(call).get(), path + "?body"))
+        {
+            ++failures;
+        }
+    }
+
+    standIn.shutdown();
+    if (failures != 0)
+    {
+        logger.error("{} calls failed", failures);
+        return 1;
+    }
+    logger.info("All calls succeeded");
+}
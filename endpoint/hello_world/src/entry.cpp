@@ -9,8 +9,8 @@
 
 int main(const int argc, const char** argv) noexcept
 {
-    const auto [address, port, threads] =
+    const auto options =
         pizza::endpoint::parseOptions("hello_world", "Serves the endpoint", argc, argv);
 
-    pizza::endpoint::serveOn(address, port, threads);
+    pizza::endpoint::serveOn(options);
 }
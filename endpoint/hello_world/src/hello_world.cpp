@@ -4,9 +4,11 @@
  * @copyright Copyleft 2021-2022 "unrealinsanity". All rights reversed.
  */
 
-#include <external/cpr/all.h>
+#include <pizza/client/client.h>
+#include <pizza/endpoint/batch_handler.h>
 #include <pizza/endpoint/endpoint.h>
 #include <pizza/endpoint/handler.h>
+#include <pizza/endpoint/metrics_handler.h>
 #include <pizza/support.h>
 
 namespace
@@ -17,29 +19,41 @@ class HelloHandler : public pizza::endpoint::Handler
    public:
     static constexpr std::string_view k_Name = "hello";
 
+    // Downloads slow down along with pistache.io, shed them rather than queueing them up, do not
+    // let a single client keep downloading, let concurrent GETs share a single download, and give
+    // up on those which take longer than clients are willing to wait
     static constexpr auto k_ApiDesc = std::to_array<ApiDesc>(
-        {{Request::Method::Get, "/hello"}, {Request::Method::Post, "/hello"}});
+        {{Request::Method::Get,
+          "/hello",
+          {.initialLimit = 16, .maxLimit = 64},
+          {.requestsPerSecond = 10.0, .burst = 20},
+          true,
+          {},
+          std::chrono::seconds{10}},
+         {Request::Method::Post, "/hello"}});
 
-    explicit HelloHandler() : Handler{k_Name} {}
+    // Downloading and writing files would block, keep it away from the reactor threads
+    explicit HelloHandler() : Handler{k_Name, IsBlocking::Yes} {}
 
-    void validateRequest(const Request& request, Cake& cake) const override
+    Outcome tryValidateRequest(const Request& request, Cake& cake) const override
     {
         switch (request.getMethod())
         {
             case Request::Method::Get:
             {
-                m_log.info("It works!");
-                return;
+                m_log.info<"It works!">();
+                return Outcome::ok();
             }
             case Request::Method::Post:
             {
-                m_log.info(request.getBody());
+                m_log.info("{}", request.getBody());
                 cake.emplace("message", "Handler for POST requests is not implemented!");
-                throw ErrorResponse{Response::Code::Method_Not_Allowed, cake};
+                return Outcome::fail(Response::Code::Method_Not_Allowed, cake);
             }
             default:
             {
-                throw ErrorResponse{Response::Code::Bad_Request, "Invalid request method."};
+                // Rejecting without throwing is as cheap as accepting
+                return Outcome::badRequest();
             }
         }
     }
@@ -56,27 +70,38 @@ class HelloHandler : public pizza::endpoint::Handler
         // Use cake to pass states to the next phase
         cake.emplace("download_path", k_Destination);
         cake.emplace("time_stamp", std::time(nullptr));
-        m_log.debug("Content of cake is {}", cake.dump());
+        // Dumping a cake costs, only do it if debug logs are written at all
+        m_log.debug("Content of cake is {}", pizza::log::lazy([&cake] { return cake.dump(); }));
     }
 
     void sendResponse(const Cake& cake, Response& response) const override
     {
         response.send(Response::Code::Ok, cake);
 
-        const auto& downloadPath = cake.at<std::string>("download_path");
+        const auto downloadPath = cake.at<std::string_view>("download_path");
         m_log.info("File successfully stored to {} on server", downloadPath);
     }
 
    private:
-    [[nodiscard]] static std::string downloadSomething()
+    [[nodiscard]] std::string downloadSomething() const
     {
-        const auto response = cpr::Get(cpr::Url{"http://pistache.io/"});
+        const auto response = m_client.get("http://pistache.io/");
         return response.text;
     }
+
+    // Every download goes out over a pooled keep-alive connection to pistache.io, of the client
+    // every handler of the process shares
+    pizza::client::Client& m_client{pizza::client::Client::getClient()};
 };
 
 // Let the endpoint be aware of the existence of this handler, and
 // thereby be able to serve it
 const auto handlerName = pizza::endpoint::addHandler<HelloHandler>();
 
+// Serve the metrics of every route on GET /metrics
+const auto metricsName = pizza::endpoint::addHandler<pizza::endpoint::MetricsHandler>();
+
+// Serve many requests in one on POST /batch
+const auto batchName = pizza::endpoint::addHandler<pizza::endpoint::BatchHandler>();
+
 }  // namespace
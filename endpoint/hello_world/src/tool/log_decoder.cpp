@@ -0,0 +1,100 @@
+/**
+ * @file tool/log_decoder.cpp
+ * @brief Turns binary logs back into text logs
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#include <external/cxxopts/all.h>
+#include <pizza/log/decoder.h>
+#include <pizza/log/logger.h>
+#include <pizza/support.h>
+
+namespace
+{
+
+/// Represents how many bytes are read at once
+constexpr size_t k_Chunk{size_t{1} << 16};
+
+/** Decode binary logs, from a file until its end
+ *
+ * @param file is the file
+ * @returns true if decoded to the end, otherwise false as the file is malformed
+ */
+bool decodeFile(std::FILE* file) noexcept
+{
+    const auto print = [](const std::string_view line)
+    { std::fwrite(line.data(), 1, line.size(), stdout); };
+
+    pizza::log::Decoder decoder;
+    std::string pending;
+    std::array<char, k_Chunk> chunk{};
+    while (true)
+    {
+        const auto read = std::fread(chunk.data(), 1, chunk.size(), file);
+        if (read == 0)
+        {
+            break;
+        }
+        pending.append(chunk.data(), read);
+
+        const auto decoded = decoder.decode(pending, print);
+        if (!decoded)
+        {
+            return false;
+        }
+        pending.erase(0, *decoded);
+    }
+    return pending.empty();
+}
+
+}  // namespace
+
+int main(const int argc, const char** argv) noexcept
+{
+    const pizza::log::Logger logger{"log_decoder"};
+
+    cxxopts::Options cli{"log_decoder", "Turns binary logs back into text logs, on stdout"};
+    // clang-format off
+    cli.add_options()
+        ("input", "File to decode, or stdin", cxxopts::value<std::string>()->default_value(""))
+        ("help", "Print usage");
+    // clang-format on
+
+    std::string input;
+    try
+    {
+        const auto result = cli.parse(argc, argv);
+        if (result.count("help") != 0)
+        {
+            fmt::print(stdout, "\n{}\n", cli.help());
+            return 0;
+        }
+        input = result["input"].as<std::string>();
+    }
+    catch (const cxxopts::OptionException& e)
+    {
+        logger.error("{}", e.what());
+        fmt::print(stderr, "\n{}\n", cli.help());
+        return 1;
+    }
+
+    auto* const file = input.empty() ? stdin : std::fopen(input.c_str(), "rb");
+    if (file == nullptr)
+    {
+        logger.error("Failed to open {}", input);
+        return 1;
+    }
+
+    const auto isDecoded = decodeFile(file);
+    if (file != stdin)
+    {
+        std::fclose(file);
+    }
+    if (!isDecoded)
+    {
+        logger.error("{} is malformed, or ends in the middle of a log",
+                     input.empty() ? "stdin" : input);
+        return 1;
+    }
+    return 0;
+}
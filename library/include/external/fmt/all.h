@@ -6,5 +6,6 @@
 
 #pragma once
 
+#include <fmt/args.h>
 #include <fmt/core.h>
 #include <fmt/format.h>
@@ -0,0 +1,21 @@
+/**
+ * @file external/posix/all.h
+ * @brief Enable POSIX
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
@@ -12,25 +12,46 @@
 
 #include <algorithm>
 #include <any>
+#include <array>
+#include <bit>
 #include <cassert>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
+#include <cmath>
 #include <concepts>
+#include <condition_variable>
+#include <csignal>
 #include <cstdint>
 #include <cstdio>
 #include <ctime>
+#include <deque>
 #include <exception>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <initializer_list>
 #include <iterator>
+#include <latch>
+#include <list>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <random>
+#include <shared_mutex>
+#include <source_location>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
@@ -0,0 +1,9 @@
+/**
+ * @file external/zlib/all.h
+ * @brief Enable zlib
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <zlib.h>
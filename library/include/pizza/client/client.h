@@ -0,0 +1,345 @@
+/**
+ * @file pizza/client/client.h
+ * @brief The outbound HTTP Client
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/cpr/all.h>
+#include <pizza/client/dns_cache.h>
+#include <pizza/log/logger.h>
+#include <pizza/support.h>
+#include <pizza/thread.h>
+
+namespace pizza::client
+{
+
+/**
+ * The Client
+ *
+ * @brief
+ * The Client sends requests to upstream services over pooled keep-alive connections, either
+ * blocking or asynchronously, so that a handler may wait for several upstream calls at once
+ *
+ * @details
+ * Every host has its own pool of idle cpr::Session objects, every one of which keeps its
+ * connection open in between requests, hence a request to a known host goes out over a warm
+ * connection with no handshake. Names resolved by any session are shared by all of them through
+ * the DNS Cache.
+ * Asynchronous requests run on threads of the client itself rather than on the Worker Pool, since
+ * handlers waiting for them may well be running on the Worker Pool.
+ * Nothing throws: a request which fails comes back as a cpr::Response with its error set, and its
+ * connection is not reused.
+ * Sessions go from one caller to the next, hence they forget the cookies they were sent once
+ * back in their pool, and URLs are logged without their credentials and queries.
+ *
+ * @note
+ * Every client has threads and connections of its own, hence handlers share the one of the process,
+ * see getClient, rather than making their own. Pointing a client at a local server, such as a
+ * Pistache endpoint standing in for the upstream service, is all it takes to exercise it.
+ */
+class Client final
+{
+    NOT_COPYABLE_CLASS(Client)
+    IMMOVEABLE_CLASS(Client)
+
+   public:
+    /// Represents the options of the client
+    struct Options final
+    {
+        std::chrono::milliseconds connectTimeout{1000};  ///< Represents how long connecting takes
+        std::chrono::milliseconds timeout{10000};        ///< Represents how long a request takes
+        std::chrono::seconds dnsTtl{60};                 ///< Represents how long names stay
+        size_t maxIdlePerHost{8};                        ///< Represents how many idle sessions stay
+        size_t threads{8};                               ///< Represents how many requests run async
+    };
+
+    /// Represents the request methods
+    enum class Method
+    {
+        Get,
+        Post,
+        Put,
+        Patch,
+        Delete
+    };
+
+    /// Constructor, with the default options
+    explicit Client() noexcept : Client{Options{}} {}
+
+    /** Constructor
+     *
+     * @param options are the options of the client
+     */
+    explicit Client(const Options& options) noexcept
+        : m_options{options}, m_dnsCache{options.dnsTtl}
+    {
+        RUNTIME_ASSERT(options.threads > 0 && "Client cannot have zero threads")
+
+        for (size_t index = 0; index < options.threads; ++index)
+        {
+            m_threads.emplace_back(makeThread([this] { work(); }));
+        }
+    }
+
+    /// Destructor, lets the pending requests finish before returning
+    ~Client() noexcept
+    {
+        {
+            const std::scoped_lock lock{m_mutex};
+            m_stopping = true;
+        }
+        m_hasTask.notify_all();
+        m_threads.clear();
+    }
+
+    /** Get the Client shared by the whole process
+     *
+     * @returns the Client, with the default options
+     */
+    [[nodiscard]] static Client& getClient() noexcept
+    {
+        static Client obj;
+        return obj;
+    }
+
+    /** Send a request
+     *
+     * @param method is the request method
+     * @param url is the URL
+     * @param headers are the request headers
+     * @param body is the request body
+     * @returns the response
+     */
+    [[nodiscard]] cpr::Response send(const Method method, const std::string_view url,
+                                     const cpr::Header& headers = {},
+                                     const std::string_view body = {}) noexcept
+    {
+        // Sessions remember their bodies, hence those which have sent one never send another
+        // request without one
+        auto pool = fmt::format("{}{}", getOrigin(url), body.empty() ? "" : " with body");
+        auto session = acquire(pool);
+
+        session->SetUrl(cpr::Url{std::string{url}});
+        session->SetHeader(headers);
+        if (!body.empty())
+        {
+            session->SetBody(cpr::Body{std::string{body}});
+        }
+
+        auto response = perform(*session, method);
+        if (response.error)
+        {
+            m_log.warn("{} failed: {}", redact(url), response.error.message);
+            return response;
+        }
+        release(std::move(pool), std::move(session));
+        return response;
+    }
+
+    /** Send a GET request
+     *
+     * @param url is the URL
+     * @param headers are the request headers
+     * @returns the response
+     */
+    [[nodiscard]] cpr::Response get(const std::string_view url,
+                                    const cpr::Header& headers = {}) noexcept
+    {
+        return send(Method::Get, url, headers);
+    }
+
+    /** Send a request asynchronously
+     *
+     * @param method is the request method
+     * @param url is the URL
+     * @param headers are the request headers
+     * @param body is the request body
+     * @returns the future response
+     */
+    [[nodiscard]] std::future<cpr::Response> sendAsync(const Method method, std::string url,
+                                                       cpr::Header headers = {},
+                                                       std::string body = {}) noexcept
+    {
+        auto promise = std::make_shared<std::promise<cpr::Response>>();
+        auto future = promise->get_future();
+        {
+            const std::scoped_lock lock{m_mutex};
+            m_tasks.emplace_back(
+                [this, promise, method, url = std::move(url), headers = std::move(headers),
+                 body = std::move(body)] { promise->set_value(send(method, url, headers, body)); });
+        }
+        m_hasTask.notify_one();
+        return future;
+    }
+
+    /** Send a GET request asynchronously
+     *
+     * @param url is the URL
+     * @param headers are the request headers
+     * @returns the future response
+     */
+    [[nodiscard]] std::future<cpr::Response> getAsync(std::string url,
+                                                      cpr::Header headers = {}) noexcept
+    {
+        return sendAsync(Method::Get, std::move(url), std::move(headers));
+    }
+
+   private:
+    /// Represents the idle sessions of the pools
+    using Pools = std::unordered_map<std::string, std::vector<std::unique_ptr<cpr::Session>>>;
+
+    /** Get the origin of a URL
+     *
+     * @param url is the URL
+     * @returns the scheme, host and port of the URL
+     */
+    [[nodiscard]] static std::string_view getOrigin(const std::string_view url) noexcept
+    {
+        const auto scheme = url.find("://");
+        const auto host = (scheme == std::string_view::npos) ? 0 : scheme + 3;
+        return url.substr(0, url.find_first_of("/?#", host));
+    }
+
+    /** Redact a URL, to be logged
+     *
+     * @param url is the URL
+     * @returns the scheme, host, port and path of the URL, without its user info, query and
+     * fragment, which may carry credentials or tokens
+     */
+    [[nodiscard]] static std::string redact(const std::string_view url) noexcept
+    {
+        const auto origin = getOrigin(url);
+        const auto scheme = url.find("://");
+        const auto host = (scheme == std::string_view::npos) ? 0 : scheme + 3;
+        const auto userInfo = origin.find('@', host);
+        const auto pathEnd = url.find_first_of("?#", origin.size());
+        const auto path = url.substr(origin.size(), pathEnd - origin.size());
+        if (userInfo == std::string_view::npos)
+        {
+            return fmt::format("{}{}", origin, path);
+        }
+        return fmt::format("{}{}{}", url.substr(0, host), origin.substr(userInfo + 1), path);
+    }
+
+    /** Take an idle session of a pool, or make a new one if there is none
+     *
+     * @param pool is the name of the pool
+     * @returns the session
+     */
+    [[nodiscard]] std::unique_ptr<cpr::Session> acquire(const std::string& pool) noexcept
+    {
+        {
+            const std::scoped_lock lock{m_mutex};
+            const auto iter = m_pools.find(pool);
+            if (iter != m_pools.end() && !iter->second.empty())
+            {
+                auto session = std::move(iter->second.back());
+                iter->second.pop_back();
+                return session;
+            }
+        }
+
+        auto session = std::make_unique<cpr::Session>();
+        session->SetConnectTimeout(cpr::ConnectTimeout{m_options.connectTimeout});
+        session->SetTimeout(cpr::Timeout{m_options.timeout});
+
+        auto* const handle = session->GetCurlHolder()->handle;
+        m_dnsCache.attach(handle);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        return session;
+    }
+
+    /** Put a session back into its pool, unless the pool has enough idle sessions already
+     *
+     * @param pool is the name of the pool
+     * @param session is the session
+     */
+    void release(std::string pool, std::unique_ptr<cpr::Session> session) noexcept
+    {
+        // cpr turns the cookie engine on, and the next caller of the session is someone else
+        curl_easy_setopt(session->GetCurlHolder()->handle, CURLOPT_COOKIELIST, "ALL");
+
+        const std::scoped_lock lock{m_mutex};
+        auto& sessions = m_pools[std::move(pool)];
+        if (sessions.size() < m_options.maxIdlePerHost)
+        {
+            sessions.emplace_back(std::move(session));
+        }
+    }
+
+    /** Perform a request on a session
+     *
+     * @param session is the session
+     * @param method is the request method
+     * @returns the response
+     */
+    [[nodiscard]] static cpr::Response perform(cpr::Session& session,
+                                               const Method method) noexcept
+    {
+        switch (method)
+        {
+            case Method::Post:
+                return session.Post();
+            case Method::Put:
+                return session.Put();
+            case Method::Patch:
+                return session.Patch();
+            case Method::Delete:
+                return session.Delete();
+            default:
+                return session.Get();
+        }
+    }
+
+    /// The loop of the threads running asynchronous requests
+    void work() noexcept
+    {
+        std::unique_lock lock{m_mutex};
+        while (true)
+        {
+            m_hasTask.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+            if (m_tasks.empty())
+            {
+                return;
+            }
+
+            auto task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    /// The options
+    const Options m_options;
+
+    /// The Logger
+    const pizza::log::Logger m_log{"client"};
+
+    /// The DNS Cache, which outlives every session
+    DnsCache m_dnsCache;
+
+    /// Guards everything below but the threads
+    std::mutex m_mutex;
+
+    /// The idle sessions by the pools they belong to
+    Pools m_pools;
+
+    /// Signals that an asynchronous request is pending or the client is stopping
+    std::condition_variable m_hasTask;
+
+    /// The pending asynchronous requests
+    std::deque<std::function<void()>> m_tasks;
+
+    /// Indicates if the client is being destructed
+    bool m_stopping{false};
+
+    /// The threads running asynchronous requests, which go first on destruction
+    std::vector<std::jthread> m_threads;
+};
+
+}  // namespace pizza::client
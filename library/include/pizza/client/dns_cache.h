@@ -0,0 +1,103 @@
+/**
+ * @file pizza/client/dns_cache.h
+ * @brief The DNS Cache of outbound requests
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/cpr/all.h>
+#include <pizza/support.h>
+
+namespace pizza::client
+{
+
+/**
+ * The DNS Cache
+ *
+ * @brief
+ * The DNS Cache lets every connection of a client share the names it has resolved, so that a new
+ * connection to a known host does not wait for a lookup
+ *
+ * @details
+ * libcurl caches names per handle only, hence the cache is a libcurl share of DNS data, which the
+ * handles of every pooled session are attached to. libcurl calls back into the cache to lock the
+ * shared data, with one lock per kind of data.
+ */
+class DnsCache final
+{
+    NOT_COPYABLE_CLASS(DnsCache)
+    IMMOVEABLE_CLASS(DnsCache)
+
+   public:
+    /** Constructor
+     *
+     * @param ttl is how long resolved names stay
+     */
+    explicit DnsCache(const std::chrono::seconds ttl) noexcept
+        : m_ttl{ttl}, m_share{curl_share_init()}
+    {
+        RUNTIME_ASSERT(m_share != nullptr && "Failed to create the DNS cache")
+
+        curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, &DnsCache::lock);
+        curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, &DnsCache::unlock);
+        curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+
+    /// Destructor, to be called once no handle is attached anymore
+    ~DnsCache() noexcept { curl_share_cleanup(m_share); }
+
+    /** Attach a handle to the cache
+     *
+     * @param handle is the libcurl handle
+     */
+    void attach(CURL* const handle) noexcept
+    {
+        curl_easy_setopt(handle, CURLOPT_SHARE, m_share);
+        curl_easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT, static_cast<long>(m_ttl.count()));
+    }
+
+   private:
+    /** Lock shared data, called by libcurl
+     *
+     * @param data is the kind of data
+     * @param self is the cache
+     */
+    static void lock(CURL* /* unused */, const curl_lock_data data, curl_lock_access /* unused */,
+                     void* const self) noexcept
+    {
+        static_cast<DnsCache*>(self)->getMutex(data).lock();
+    }
+
+    /** Unlock shared data, called by libcurl
+     *
+     * @param data is the kind of data
+     * @param self is the cache
+     */
+    static void unlock(CURL* /* unused */, const curl_lock_data data, void* const self) noexcept
+    {
+        static_cast<DnsCache*>(self)->getMutex(data).unlock();
+    }
+
+    /** Get the lock of a kind of data
+     *
+     * @param data is the kind of data
+     * @returns the lock
+     */
+    [[nodiscard]] std::mutex& getMutex(const curl_lock_data data) noexcept
+    {
+        return m_mutexes.at(static_cast<size_t>(data) % m_mutexes.size());
+    }
+
+    /// How long resolved names stay
+    const std::chrono::seconds m_ttl;
+
+    /// The libcurl share
+    CURLSH* const m_share;
+
+    /// The locks, one per kind of data
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> m_mutexes;
+};
+
+}  // namespace pizza::client
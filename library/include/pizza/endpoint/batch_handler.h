@@ -0,0 +1,342 @@
+/**
+ * @file pizza/endpoint/batch_handler.h
+ * @brief The built-in Batch Handler
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/cpr/all.h>
+#include <external/pistache/all.h>
+#include <pizza/endpoint/endpoint.h>
+#include <pizza/endpoint/handler.h>
+#include <pizza/endpoint/json_writer.h>
+#include <pizza/endpoint/worker_pool.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Batch Handler
+ *
+ * @brief
+ * Serves many requests in one on POST /batch, so that a client pays a single round trip for them
+ *
+ * @details
+ * The request body is an array of items, in JSON, MessagePack or CBOR, every one of which is a
+ * request:
+ * `{"method": "GET", "path": "/hello", "query": {"key": "value"}, "body": ..., "headers": {...}}`
+ * where everything but the path is optional, and the query may also be given as a string.
+ * Items are dispatched in-process to the handlers of their routes, which run their phases as they
+ * would for any other request, in parallel on the Worker Pool, and within the deadline of the
+ * batch. The response body is a JSON array of `{"status": 200, "body": ...}`, in the order of the
+ * items, where JSON bodies are embedded as they are and any other body becomes a string. Items
+ * accept JSON only, whatever Accept they give, since MessagePack or CBOR would not be strings.
+ *
+ * @note
+ * This handler is optional, register it like any other handler to serve it:
+ * `pizza::endpoint::addHandler<pizza::endpoint::BatchHandler>()`
+ */
+class BatchHandler final : public Handler
+{
+   public:
+    static constexpr std::string_view k_Name = "batch";
+
+    static constexpr auto k_ApiDesc = std::to_array<ApiDesc>({{Request::Method::Post, "/batch"}});
+
+    /// Constructor, the items may block hence the batch runs on the Worker Pool
+    explicit BatchHandler() noexcept : Handler{k_Name, IsBlocking::Yes} {}
+
+   private:
+    /// Represents the state shared by everything running the items of a batch
+    struct Batch final
+    {
+        /** Constructor
+         *
+         * @param items_ are the items
+         * @param client_ is the request of the batch
+         * @param deadline_ is the deadline of the batch
+         */
+        explicit Batch(nlohmann::json items_, const Pistache::Http::Request& client_,
+                       Deadline deadline_) noexcept
+            : items{std::move(items_)},
+              client{client_},
+              deadline{std::move(deadline_)},
+              responses(items.size())
+        {
+        }
+
+        const nlohmann::json items;                 ///< Represents the items
+        const Pistache::Http::Request& client;      ///< Represents the request of the batch
+        const Deadline deadline;                    ///< Represents the deadline of the batch
+        std::vector<Response::Captured> responses;  ///< Represents the responses of the items
+        std::atomic<size_t> next{0};                ///< Represents the next item to claim
+        std::atomic<size_t> finished{0};            ///< Represents how many items have finished
+    };
+
+    Outcome tryValidateRequest(const Request& request, Cake& cake) const override
+    {
+        auto items = request.getBodyJson();
+        if (!items.is_array() || items.empty() || items.size() > k_MaxItems)
+        {
+            return Outcome::fail(Response::Code::Bad_Request, k_InvalidBatch);
+        }
+
+        cake.emplace("items", items);
+        return Outcome::ok();
+    }
+
+    Outcome tryProcessRequest(const Request& request, Cake& cake) const override
+    {
+        // The items are claimed one by one, by this thread as well as by the helpers, hence
+        // nothing waits on a helper which the Worker Pool has not got around to running, and the
+        // request of the batch outlives every item
+        const auto batch = std::make_shared<Batch>(cake.at("items"), request.getUnderlying(),
+                                                   request.getDeadline());
+        const auto size = batch->items.size();
+        for (size_t helper = 1; helper < std::min(size, k_MaxParallelism); ++helper)
+        {
+            WorkerPool::getWorkerPool().submit([this, batch] { runItems(*batch); });
+        }
+        runItems(*batch);
+
+        // Wait for the items claimed by the helpers, which are running by now
+        for (auto finished = batch->finished.load(std::memory_order_acquire); finished != size;
+             finished = batch->finished.load(std::memory_order_acquire))
+        {
+            batch->finished.wait(finished, std::memory_order_acquire);
+        }
+
+        JsonWriter::Buffer buffer;
+        buffer.push_back('[');
+        for (const auto& [code, mediaType, body, headers] : batch->responses)
+        {
+            if (buffer.size() > 1)
+            {
+                buffer.push_back(',');
+            }
+            fmt::format_to(std::back_inserter(buffer), R"({{"status":{},"body":)",
+                           static_cast<int>(code));
+            if (mediaType == MIME(Application, Json) && !body.empty())
+            {
+                buffer.append(body);
+            }
+            else
+            {
+                JsonWriter::writeString(buffer, body);
+            }
+            buffer.push_back('}');
+        }
+        buffer.push_back(']');
+
+        cake.emplace("responses", std::string_view{buffer.data(), buffer.size()});
+        return Outcome::ok();
+    }
+
+    void sendResponse(const Cake& cake, Response& response) const override
+    {
+        response.sendAs(Response::Code::Ok, MIME(Application, Json),
+                        cake.at<std::string_view>("responses"));
+    }
+
+    /** Run the items of a batch until none is left to claim
+     *
+     * @param batch is the batch
+     */
+    void runItems(Batch& batch) const noexcept
+    {
+        const auto size = batch.items.size();
+        for (auto index = batch.next.fetch_add(1, std::memory_order_relaxed); index < size;
+             index = batch.next.fetch_add(1, std::memory_order_relaxed))
+        {
+            batch.responses[index] = runItem(batch.items[index], batch);
+            if (batch.finished.fetch_add(1, std::memory_order_acq_rel) + 1 == size)
+            {
+                batch.finished.notify_all();
+            }
+        }
+    }
+
+    /** Run an item
+     *
+     * @param item is the item
+     * @param batch is the batch, whose client the item is charged to, and whose deadline the item
+     * cannot outlive
+     * @returns the response of the item
+     */
+    [[nodiscard]] Response::Captured runItem(const nlohmann::json& item,
+                                             const Batch& batch) const noexcept
+    {
+        Response::Captured captured;
+        Response response{captured};
+
+        const auto message = toMessage(item);
+        if (!message)
+        {
+            response.send(Response::Code::Bad_Request, k_InvalidItem);
+            return captured;
+        }
+
+        // Pistache parses the item exactly as it would have parsed it off a connection
+        const auto& [requestMethod, requestPath, raw] = *message;
+        Pistache::Http::Private::Parser<Pistache::Http::Request> parser{raw.size()};
+        if (!parser.feed(raw.data(), raw.size()) ||
+            parser.parse() != Pistache::Http::Private::State::Done)
+        {
+            response.send(Response::Code::Bad_Request, k_InvalidItem);
+            return captured;
+        }
+
+        const auto* const route = Endpoint::getEndpoint().findRoute(requestMethod, requestPath);
+        if (route == nullptr)
+        {
+            response.send(Response::Code::Not_Found, k_NotFound);
+            return captured;
+        }
+        if (&route->getHandler() == this)
+        {
+            response.send(Response::Code::Bad_Request, k_NestedBatch);
+            return captured;
+        }
+        return route->getHandler().handleCaptured(parser.request, *route, batch.client,
+                                                  batch.deadline);
+    }
+
+    /// Represents an item as an HTTP message, along with its method and path
+    using Message = std::tuple<Request::Method, std::string, std::string>;
+
+    /** Make the HTTP message of an item
+     *
+     * @param item is the item
+     * @returns the message if the item is well-formed, otherwise nothing
+     */
+    [[nodiscard]] static std::optional<Message> toMessage(const nlohmann::json& item) noexcept
+    {
+        if (!item.is_object() || !item.contains("path") || !item["path"].is_string())
+        {
+            return std::nullopt;
+        }
+        const auto& path = item["path"].get_ref<const std::string&>();
+        if (!path.starts_with('/') || path.find_first_of("? \r\n") != std::string::npos)
+        {
+            return std::nullopt;
+        }
+
+        const auto methodName = item.value("method", std::string{"GET"});
+        const auto method = std::find_if(k_Methods.begin(), k_Methods.end(),
+                                         [&methodName](const auto& method_)
+                                         { return method_.first == methodName; });
+        if (method == k_Methods.end())
+        {
+            return std::nullopt;
+        }
+
+        std::string query;
+        if (const auto iter = item.find("query"); iter != item.end())
+        {
+            if (iter->is_string())
+            {
+                // Like the path, the query cannot end the request line early
+                query = iter->get<std::string>();
+                if (query.find_first_of(" \r\n") != std::string::npos)
+                {
+                    return std::nullopt;
+                }
+            }
+            else if (iter->is_object())
+            {
+                for (const auto& [key, value] : iter->items())
+                {
+                    fmt::format_to(std::back_inserter(query), "{}{}={}", query.empty() ? "" : "&",
+                                   cpr::util::urlEncode(key),
+                                   cpr::util::urlEncode(value.is_string() ? value.get<std::string>()
+                                                                          : value.dump()));
+                }
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }
+
+        std::string body;
+        if (const auto iter = item.find("body"); iter != item.end())
+        {
+            body = iter->is_string() ? iter->get<std::string>() : iter->dump();
+        }
+
+        std::string headers;
+        if (const auto iter = item.find("headers"); iter != item.end())
+        {
+            if (!iter->is_object())
+            {
+                return std::nullopt;
+            }
+            for (const auto& [name, value] : iter->items())
+            {
+                // A line break would smuggle in headers, or a whole request, of the client's own
+                if (!value.is_string() || name.empty() ||
+                    name.find_first_of(": \t\r\n") != std::string::npos ||
+                    value.get_ref<const std::string&>().find_first_of("\r\n") !=
+                        std::string::npos)
+                {
+                    return std::nullopt;
+                }
+
+                // The body is framed, and its encoding picked, by the batch, not by the client
+                if (isBatchHeader(name))
+                {
+                    continue;
+                }
+                fmt::format_to(std::back_inserter(headers), "{}: {}\r\n", name,
+                               value.get_ref<const std::string&>());
+            }
+        }
+
+        auto raw = fmt::format("{} {}{}{} HTTP/1.1\r\n{}Accept: application/json\r\n"
+                               "Content-Length: {}\r\n\r\n{}",
+                               method->first, path, query.empty() ? "" : "?", query, headers,
+                               body.size(), body);
+        return Message{method->second, path, std::move(raw)};
+    }
+
+    /** Is the header one the batch sets for an item, rather than the client?
+     *
+     * @param name is the name of the header
+     * @returns true if it is Content-Length, Transfer-Encoding or Accept, whatever its case
+     */
+    [[nodiscard]] static bool isBatchHeader(const std::string_view name) noexcept
+    {
+        const auto lower = pystring::lower(std::string{name});
+        return lower == "content-length" || lower == "transfer-encoding" || lower == "accept";
+    }
+
+    /// Represents the request methods items may have
+    static constexpr auto k_Methods = std::to_array<std::pair<std::string_view, Request::Method>>(
+        {{"GET", Request::Method::Get},
+         {"POST", Request::Method::Post},
+         {"PUT", Request::Method::Put},
+         {"PATCH", Request::Method::Patch},
+         {"DELETE", Request::Method::Delete}});
+
+    /// Represents how many items a batch may have
+    static constexpr size_t k_MaxItems{64};
+
+    /// Represents how many threads run the items of a batch at most
+    static constexpr size_t k_MaxParallelism{16};
+
+    /// The response body of a batch which is not a non-empty array of up to k_MaxItems items
+    static constexpr std::string_view k_InvalidBatch{"Batch must be an array of 1 to 64 items"};
+
+    /// The response body of an item which is not a well-formed request
+    static constexpr std::string_view k_InvalidItem{"Invalid Item"};
+
+    /// The response body of an item which is a batch itself
+    static constexpr std::string_view k_NestedBatch{"Batches cannot be nested"};
+
+    /// The response body of an item which no route serves
+    static constexpr std::string_view k_NotFound{"Not Found"};
+};
+
+}  // namespace pizza::endpoint
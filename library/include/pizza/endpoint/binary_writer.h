@@ -0,0 +1,307 @@
+/**
+ * @file pizza/endpoint/binary_writer.h
+ * @brief Writes MessagePack and CBOR straight into a buffer
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/encoding.h>
+#include <pizza/endpoint/json_writer.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * Packages together the functions writing MessagePack and CBOR values into a buffer
+ *
+ * This class is not meant to be constructed, but to hide some details
+ *
+ * @note Numbers take the smallest representation which holds them, as json does
+ */
+class BinaryWriter final
+{
+    STATIC_CLASS(BinaryWriter)
+
+   public:
+    /// Represents the buffer being written to
+    using Buffer = JsonWriter::Buffer;
+
+    /** Write the header of a map
+     *
+     * @tparam Format is the binary encoding
+     * @param buffer is the buffer to append to
+     * @param size is the number of pairs of the map
+     */
+    template <Encoding Format>
+    static void writeMap(Buffer& buffer, const size_t size) noexcept
+    {
+        if constexpr (Format == Encoding::MessagePack)
+        {
+            writeHeader(buffer, size, 0x80, 16, 0, 0xde, 0xdf);
+        }
+        else
+        {
+            writeCborHeader(buffer, k_CborMap, size);
+        }
+    }
+
+    /** Write a string
+     *
+     * @tparam Format is the binary encoding
+     * @param buffer is the buffer to append to
+     * @param string is the string
+     */
+    template <Encoding Format>
+    static void writeString(Buffer& buffer, const std::string_view string) noexcept
+    {
+        if constexpr (Format == Encoding::MessagePack)
+        {
+            writeHeader(buffer, string.size(), 0xa0, 32, 0xd9, 0xda, 0xdb);
+        }
+        else
+        {
+            writeCborHeader(buffer, k_CborString, string.size());
+        }
+        buffer.append(string);
+    }
+
+    /** Write a value
+     *
+     * @tparam Format is the binary encoding
+     * @tparam Type is the type of value
+     * @param buffer is the buffer to append to
+     * @param value is the value
+     */
+    template <Encoding Format, typename Type>
+    static void writeValue(Buffer& buffer, const Type& value) noexcept
+    {
+        static_assert(Format != Encoding::Json, "Use JsonWriter to write JSON");
+
+        constexpr auto k_IsMessagePack = Format == Encoding::MessagePack;
+        if constexpr (std::is_same_v<Type, std::nullptr_t>)
+        {
+            buffer.push_back(k_IsMessagePack ? '\xc0' : '\xf6');
+        }
+        else if constexpr (std::is_same_v<Type, bool>)
+        {
+            if constexpr (k_IsMessagePack)
+            {
+                buffer.push_back(value ? '\xc3' : '\xc2');
+            }
+            else
+            {
+                buffer.push_back(value ? '\xf5' : '\xf4');
+            }
+        }
+        else if constexpr (std::is_integral_v<Type>)
+        {
+            writeInteger<Format>(buffer, value);
+        }
+        else if constexpr (std::is_floating_point_v<Type>)
+        {
+            // Floats take single precision when it holds them exactly, as json does
+            const auto single = static_cast<float>(value);
+            if (static_cast<Type>(single) == value)
+            {
+                buffer.push_back(k_IsMessagePack ? '\xca' : '\xfa');
+                writeBigEndian(buffer, std::bit_cast<uint32_t>(single));
+            }
+            else
+            {
+                buffer.push_back(k_IsMessagePack ? '\xcb' : '\xfb');
+                writeBigEndian(buffer, std::bit_cast<uint64_t>(static_cast<double>(value)));
+            }
+        }
+        else if constexpr (std::is_same_v<Type, nlohmann::json>)
+        {
+            // Anything held as json is rare enough to go through json itself
+            const auto bytes = k_IsMessagePack ? nlohmann::json::to_msgpack(value)
+                                               : nlohmann::json::to_cbor(value);
+            buffer.append(reinterpret_cast<const char*>(bytes.data()),
+                          reinterpret_cast<const char*>(bytes.data() + bytes.size()));
+        }
+        else
+        {
+            writeString<Format>(buffer, std::string_view{value});
+        }
+    }
+
+   private:
+    /** Write an integer
+     *
+     * @tparam Format is the binary encoding
+     * @tparam Type is the type of integer
+     * @param buffer is the buffer to append to
+     * @param value is the integer
+     */
+    template <Encoding Format, typename Type>
+    static void writeInteger(Buffer& buffer, const Type value) noexcept
+    {
+        if constexpr (std::is_signed_v<Type>)
+        {
+            if (value < 0)
+            {
+                return writeNegative<Format>(buffer, static_cast<int64_t>(value));
+            }
+        }
+
+        if constexpr (Format == Encoding::MessagePack)
+        {
+            writeHeader(buffer, static_cast<uint64_t>(value), 0x00, 128, 0xcc, 0xcd, 0xce, 0xcf);
+        }
+        else
+        {
+            writeCborHeader(buffer, k_CborUnsigned, static_cast<uint64_t>(value));
+        }
+    }
+
+    /** Write a negative integer
+     *
+     * @tparam Format is the binary encoding
+     * @param buffer is the buffer to append to
+     * @param value is the integer
+     */
+    template <Encoding Format>
+    static void writeNegative(Buffer& buffer, const int64_t value) noexcept
+    {
+        if constexpr (Format == Encoding::Cbor)
+        {
+            // CBOR keeps negative integers as how far they are below -1
+            writeCborHeader(buffer, k_CborNegative, static_cast<uint64_t>(-(value + 1)));
+        }
+        else if (value >= -32)
+        {
+            buffer.push_back(static_cast<char>(value));
+        }
+        else if (value >= std::numeric_limits<int8_t>::min())
+        {
+            buffer.push_back('\xd0');
+            writeBigEndian(buffer, static_cast<uint8_t>(value));
+        }
+        else if (value >= std::numeric_limits<int16_t>::min())
+        {
+            buffer.push_back('\xd1');
+            writeBigEndian(buffer, static_cast<uint16_t>(value));
+        }
+        else if (value >= std::numeric_limits<int32_t>::min())
+        {
+            buffer.push_back('\xd2');
+            writeBigEndian(buffer, static_cast<uint32_t>(value));
+        }
+        else
+        {
+            buffer.push_back('\xd3');
+            writeBigEndian(buffer, static_cast<uint64_t>(value));
+        }
+    }
+
+    /** Write a MessagePack header, which holds a size or an unsigned integer
+     *
+     * @param buffer is the buffer to append to
+     * @param size is the size
+     * @param fixed is the marker of sizes held by the marker itself
+     * @param fixedLimit is the size from which the marker cannot hold it anymore
+     * @param marker8 is the marker of 8-bit sizes, 0 if there is none
+     * @param marker16 is the marker of 16-bit sizes
+     * @param marker32 is the marker of 32-bit sizes
+     * @param marker64 is the marker of 64-bit sizes, 0 if there is none
+     */
+    static void writeHeader(Buffer& buffer, const uint64_t size, const u_char fixed,
+                            const uint64_t fixedLimit, const u_char marker8,
+                            const u_char marker16, const u_char marker32,
+                            const u_char marker64 = 0) noexcept
+    {
+        if (size < fixedLimit)
+        {
+            buffer.push_back(static_cast<char>(fixed | size));
+        }
+        else if (size <= std::numeric_limits<uint8_t>::max() && marker8 != 0)
+        {
+            buffer.push_back(static_cast<char>(marker8));
+            writeBigEndian(buffer, static_cast<uint8_t>(size));
+        }
+        else if (size <= std::numeric_limits<uint16_t>::max())
+        {
+            buffer.push_back(static_cast<char>(marker16));
+            writeBigEndian(buffer, static_cast<uint16_t>(size));
+        }
+        else if (size <= std::numeric_limits<uint32_t>::max() || marker64 == 0)
+        {
+            buffer.push_back(static_cast<char>(marker32));
+            writeBigEndian(buffer, static_cast<uint32_t>(size));
+        }
+        else
+        {
+            buffer.push_back(static_cast<char>(marker64));
+            writeBigEndian(buffer, size);
+        }
+    }
+
+    /** Write a CBOR header, which holds a size or an unsigned integer
+     *
+     * @param buffer is the buffer to append to
+     * @param majorType is the major type of the item, in the top 3 bits
+     * @param size is the size
+     */
+    static void writeCborHeader(Buffer& buffer, const u_char majorType,
+                                const uint64_t size) noexcept
+    {
+        if (size < 24)
+        {
+            buffer.push_back(static_cast<char>(majorType | size));
+        }
+        else if (size <= std::numeric_limits<uint8_t>::max())
+        {
+            buffer.push_back(static_cast<char>(majorType | 24));
+            writeBigEndian(buffer, static_cast<uint8_t>(size));
+        }
+        else if (size <= std::numeric_limits<uint16_t>::max())
+        {
+            buffer.push_back(static_cast<char>(majorType | 25));
+            writeBigEndian(buffer, static_cast<uint16_t>(size));
+        }
+        else if (size <= std::numeric_limits<uint32_t>::max())
+        {
+            buffer.push_back(static_cast<char>(majorType | 26));
+            writeBigEndian(buffer, static_cast<uint32_t>(size));
+        }
+        else
+        {
+            buffer.push_back(static_cast<char>(majorType | 27));
+            writeBigEndian(buffer, size);
+        }
+    }
+
+    /** Write an unsigned integer in big-endian order
+     *
+     * @tparam Type is the type of integer
+     * @param buffer is the buffer to append to
+     * @param value is the integer
+     */
+    template <typename Type>
+    static void writeBigEndian(Buffer& buffer, const Type value) noexcept
+    {
+        std::array<char, sizeof(Type)> bytes;
+        for (size_t index = 0; index < sizeof(Type); ++index)
+        {
+            bytes.at(index) = static_cast<char>(value >> (8 * (sizeof(Type) - 1 - index)));
+        }
+        buffer.append(bytes.data(), bytes.data() + bytes.size());
+    }
+
+    /// The CBOR major type of unsigned integers
+    static constexpr u_char k_CborUnsigned{0x00};
+
+    /// The CBOR major type of negative integers
+    static constexpr u_char k_CborNegative{0x20};
+
+    /// The CBOR major type of text strings
+    static constexpr u_char k_CborString{0x60};
+
+    /// The CBOR major type of maps
+    static constexpr u_char k_CborMap{0xa0};
+};
+
+}  // namespace pizza::endpoint
@@ -0,0 +1,622 @@
+/**
+ * @file pizza/endpoint/binding.h
+ * @brief Typed bindings of requests
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/cake.h>
+#include <pizza/endpoint/outcome.h>
+#include <pizza/endpoint/request.h>
+#include <pizza/endpoint/response.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/// Represents where the value of a field comes from
+enum class Source
+{
+    Query,  ///< The value is the query parameter of the same name
+    Path,   ///< The value is the path parameter of the same name, as in ":name" of the route
+    Body    ///< The value is the member of the same name of the object in the body
+};
+
+/**
+ * Describes a field of a request struct
+ *
+ * @tparam Owner is the request struct
+ * @tparam Value is the type of field, which is a boolean, a number or a std::string, or a
+ * std::optional of one of them if the field may be left out
+ */
+template <typename Owner, typename Value>
+struct Field final
+{
+    /// Represents the type of field, without std::optional
+    template <typename Wrapped>
+    struct Unwrap final
+    {
+        using Type = Wrapped;  ///< Represents the type
+    };
+
+    /// Represents the type of optional field, without std::optional
+    template <typename Wrapped>
+    struct Unwrap<std::optional<Wrapped>> final
+    {
+        using Type = Wrapped;  ///< Represents the type
+    };
+
+    /// Represents the type of field, without std::optional
+    using Type = typename Unwrap<Value>::Type;
+
+    static_assert(std::is_same_v<Type, bool> || std::is_arithmetic_v<Type> ||
+                      std::is_same_v<Type, std::string>,
+                  "Type of field is not supported");
+
+    /// Indicates whether the field may be left out
+    static constexpr bool k_IsOptional = !std::is_same_v<Type, Value>;
+
+    const std::string_view name;  ///< Represents the name of the value
+    Value Owner::*const member;   ///< Represents the field
+    const Source source;          ///< Represents where the value comes from
+};
+
+/** Describe a field bound to a query parameter
+ *
+ * @param name is the name of the query parameter
+ * @param member is the field
+ * @returns the field descriptor
+ */
+template <typename Owner, typename Value>
+[[nodiscard]] consteval auto fromQuery(const std::string_view name, Value Owner::*member) noexcept
+{
+    return Field<Owner, Value>{name, member, Source::Query};
+}
+
+/** Describe a field bound to a path parameter
+ *
+ * @param name is the name of the path parameter
+ * @param member is the field
+ * @returns the field descriptor
+ */
+template <typename Owner, typename Value>
+[[nodiscard]] consteval auto fromPath(const std::string_view name, Value Owner::*member) noexcept
+{
+    return Field<Owner, Value>{name, member, Source::Path};
+}
+
+/** Describe a field bound to a member of the body
+ *
+ * @param name is the name of the member
+ * @param member is the field
+ * @returns the field descriptor
+ */
+template <typename Owner, typename Value>
+[[nodiscard]] consteval auto fromBody(const std::string_view name, Value Owner::*member) noexcept
+{
+    return Field<Owner, Value>{name, member, Source::Body};
+}
+
+namespace concepts
+{
+
+/**
+ * Represents a request struct
+ *
+ * @details
+ * Type::k_Fields is a tuple of field descriptors, made with fromQuery, fromPath and fromBody
+ */
+template <typename Type>
+concept Bindable = std::is_default_constructible_v<Type> &&
+    requires { std::tuple_size<std::remove_cvref_t<decltype(Type::k_Fields)>>::value; };
+
+}  // namespace concepts
+
+/**
+ * Binds requests to request structs
+ *
+ * @details
+ * A handler declares what it wants out of a request as a struct, and binds requests to it rather
+ * than pulling values out one by one:
+ * @code
+ * struct Order
+ * {
+ *     std::string id;
+ *     uint32_t quantity{0};
+ *     std::optional<std::string> note;
+ *
+ *     static constexpr auto k_Fields = std::make_tuple(fromPath("id", &Order::id),
+ *                                                      fromBody("quantity", &Order::quantity),
+ *                                                      fromBody("note", &Order::note));
+ * };
+ *
+ * Order order;
+ * if (auto outcome = Binding::bind(request, order, cake); !outcome)
+ * {
+ *     return outcome;
+ * }
+ * @endcode
+ * The body is parsed with the SAX parser straight into the struct, with no json in between,
+ * in JSON, MessagePack or CBOR as its Content-Type tells, and members of the body which are not
+ * fields are skipped.
+ * Whatever goes wrong, be it a field left out, a value of the wrong type or a malformed body,
+ * fails the outcome with 400 Bad Request, and the cake tells which field and why.
+ */
+class Binding final
+{
+    STATIC_CLASS(Binding)
+
+   public:
+    /** Bind a request to a request struct
+     *
+     * @tparam Type is the request struct
+     * @param request is the Request object
+     * @param target is the request struct
+     * @param cake is the Cake object, which tells what went wrong if anything did
+     * @returns the outcome of binding
+     */
+    template <concepts::Bindable Type>
+    [[nodiscard]] static Outcome bind(const Request& request, Type& target, Cake& cake) noexcept
+    {
+        constexpr auto k_Size = std::tuple_size_v<std::remove_cvref_t<decltype(Type::k_Fields)>>;
+
+        std::array<bool, k_Size> isBound{};
+        std::string_view error;
+        std::string_view failedField;
+        const auto fail = [&error, &failedField](const std::string_view why,
+                                                 const std::string_view name)
+        {
+            error = why;
+            failedField = name;
+        };
+
+        // Query and path parameters, one after the other
+        forEachField<Type>(
+            [&](const auto& field, const size_t index)
+            {
+                if (!error.empty() || field.source == Source::Body)
+                {
+                    return;
+                }
+
+                const auto isQuery = field.source == Source::Query;
+                if (isQuery ? !request.hasQuery(field.name) : !request.hasParameter(field.name))
+                {
+                    return;
+                }
+                const auto text = isQuery ? request.getQuery(field.name)
+                                          : request.getParameter(field.name);
+                if (!parseText(text, target.*field.member))
+                {
+                    return fail(k_InvalidValue, field.name);
+                }
+                isBound.at(index) = true;
+            });
+
+        // The body, in one go
+        if (error.empty() && hasBodyFields<Type>() && !request.getBody().empty())
+        {
+            BodyReader<Type> reader{target, isBound};
+            const auto body = request.getBody();
+            if (!nlohmann::json::sax_parse(body.begin(), body.end(), &reader,
+                                           toInputFormat(request.getBodyEncoding())))
+            {
+                fail(reader.getError(), reader.getFailedField());
+            }
+        }
+
+        forEachField<Type>(
+            [&](const auto& field, const size_t index)
+            {
+                if (error.empty() && !isBound.at(index) && !field.k_IsOptional)
+                {
+                    fail(k_MissingValue, field.name);
+                }
+            });
+
+        if (error.empty())
+        {
+            return Outcome::ok();
+        }
+        cake.emplace("error", error);
+        if (!failedField.empty())
+        {
+            cake.emplace("field", failedField);
+        }
+        return Outcome::fail(Response::Code::Bad_Request, cake);
+    }
+
+   private:
+    /** Call a function with every field descriptor of a request struct
+     *
+     * @tparam Type is the request struct
+     * @tparam Function is the type of function
+     * @param function is the function, called with the descriptor and the index of every field
+     */
+    template <typename Type, typename Function>
+    static void forEachField(const Function& function) noexcept
+    {
+        std::apply(
+            [&function](const auto&... fields)
+            {
+                size_t index = 0;
+                (function(fields, index++), ...);
+            },
+            Type::k_Fields);
+    }
+
+    /** Does a request struct have fields bound to the body?
+     *
+     * @tparam Type is the request struct
+     * @returns true if there is a field bound to the body, otherwise false
+     */
+    template <typename Type>
+    [[nodiscard]] static constexpr bool hasBodyFields() noexcept
+    {
+        return std::apply([](const auto&... fields)
+                          { return ((fields.source == Source::Body) || ...); },
+                          Type::k_Fields);
+    }
+
+    /** Get the input format of the parser for an encoding
+     *
+     * @param encoding is the encoding of the body
+     * @returns the input format
+     */
+    [[nodiscard]] static constexpr nlohmann::detail::input_format_t toInputFormat(
+        const Encoding encoding) noexcept
+    {
+        switch (encoding)
+        {
+            case Encoding::MessagePack:
+                return nlohmann::detail::input_format_t::msgpack;
+            case Encoding::Cbor:
+                return nlohmann::detail::input_format_t::cbor;
+            default:
+                return nlohmann::detail::input_format_t::json;
+        }
+    }
+
+    /** Parse the text of a query or path parameter
+     *
+     * @tparam Value is the type of field
+     * @param text is the text
+     * @param value is the field
+     * @returns true if the text is a value of the type of field, otherwise false
+     */
+    template <typename Value>
+    [[nodiscard]] static bool parseText(const std::string_view text, Value& value) noexcept
+    {
+        if constexpr (requires { value.emplace(); })
+        {
+            return parseText(text, value.emplace());
+        }
+        else if constexpr (std::is_same_v<Value, std::string>)
+        {
+            value.assign(text);
+            return true;
+        }
+        else if constexpr (std::is_same_v<Value, bool>)
+        {
+            value = (text == "true" || text == "1");
+            return value || text == "false" || text == "0";
+        }
+        else
+        {
+            const auto* const end = text.data() + text.size();
+            const auto [last, errorCode] = std::from_chars(text.data(), end, value);
+            return errorCode == std::errc{} && last == end;
+        }
+    }
+
+    /**
+     * Reads a body straight into a request struct
+     *
+     * @details
+     * Only the members of the top-level object are looked at, anything nested in a member which is
+     * not a field is skipped over
+     */
+    template <typename Type>
+    class BodyReader final
+    {
+        DEFAULT_DESTRUCTIBLE_FINAL_CLASS(BodyReader)
+
+       public:
+        /// Represents the fields which have been bound
+        using IsBound = std::array<bool, std::tuple_size_v<decltype(Type::k_Fields)>>;
+
+        /** Constructor
+         *
+         * @param target is the request struct
+         * @param isBound are the fields which have been bound, which the body may add to
+         */
+        explicit BodyReader(Type& target, IsBound& isBound) noexcept
+            : m_target{target}, m_isBound{isBound}
+        {
+        }
+
+        /** Get what went wrong
+         *
+         * @returns what went wrong, if anything did
+         */
+        [[nodiscard]] std::string_view getError() const noexcept { return m_error; }
+
+        /** Get the field which went wrong
+         *
+         * @returns the name of the field, empty if it is the body as a whole which went wrong
+         */
+        [[nodiscard]] std::string_view getFailedField() const noexcept { return m_failedField; }
+
+        // The SAX interface of nlohmann::json
+        // NOLINTBEGIN(readability-identifier-naming)
+
+        bool null() noexcept { return setValue(nullptr); }
+
+        bool boolean(const bool value) noexcept { return setValue(value); }
+
+        bool number_integer(const int64_t value) noexcept { return setValue(value); }
+
+        bool number_unsigned(const uint64_t value) noexcept { return setValue(value); }
+
+        bool number_float(const double_t value, const std::string& /* unused */) noexcept
+        {
+            return setValue(value);
+        }
+
+        bool string(std::string& value) noexcept { return setValue(std::move(value)); }
+
+        bool binary(nlohmann::json::binary_t& /* unused */) noexcept { return skipValue(); }
+
+        bool start_object(const size_t /* unused */) noexcept
+        {
+            if (m_depth == 0)
+            {
+                ++m_depth;
+                return true;
+            }
+            return startNested();
+        }
+
+        bool key(std::string& name) noexcept
+        {
+            if (m_depth == 1)
+            {
+                m_field = findField(name);
+            }
+            return true;
+        }
+
+        bool end_object() noexcept
+        {
+            --m_depth;
+            return true;
+        }
+
+        bool start_array(const size_t /* unused */) noexcept
+        {
+            if (m_depth == 0)
+            {
+                return fail(k_MalformedBody);
+            }
+            return startNested();
+        }
+
+        bool end_array() noexcept
+        {
+            --m_depth;
+            return true;
+        }
+
+        bool parse_error(const size_t /* unused */, const std::string& /* unused */,
+                         const nlohmann::detail::exception& /* unused */) noexcept
+        {
+            return fail(k_MalformedBody);
+        }
+
+        // NOLINTEND(readability-identifier-naming)
+
+       private:
+        /// Represents that the current member is not a field
+        static constexpr size_t k_NoField{std::numeric_limits<size_t>::max()};
+
+        /** Find the field bound to a member of the body
+         *
+         * @param name is the name of the member
+         * @returns the index of the field, k_NoField if there is none
+         */
+        [[nodiscard]] static size_t findField(const std::string_view name) noexcept
+        {
+            auto result = k_NoField;
+            forEachField<Type>(
+                [name, &result](const auto& field, const size_t index)
+                {
+                    if (field.source == Source::Body && field.name == name)
+                    {
+                        result = index;
+                    }
+                });
+            return result;
+        }
+
+        /** Set the field of the current member
+         *
+         * @tparam Value is the type of value
+         * @param value is the value
+         * @returns true if parsing may go on, otherwise false
+         */
+        template <typename Value>
+        bool setValue(Value&& value) noexcept
+        {
+            if (m_depth == 0)
+            {
+                return fail(k_MalformedBody);
+            }
+            if (m_depth > 1 || m_field == k_NoField)
+            {
+                return true;
+            }
+
+            auto isSet = true;
+            std::string_view name;
+            forEachField<Type>(
+                [&](const auto& field, const size_t index)
+                {
+                    if (index == m_field)
+                    {
+                        name = field.name;
+                        isSet = assign(m_target.*field.member, std::forward<Value>(value));
+                        m_isBound.at(index) = isSet;
+                    }
+                });
+            m_field = k_NoField;
+            return isSet || fail(k_InvalidValue, name);
+        }
+
+        /// Skip the current member, unless it is a field, which cannot be binary
+        bool skipValue() noexcept
+        {
+            if (m_depth == 1 && m_field != k_NoField)
+            {
+                return failField();
+            }
+            return true;
+        }
+
+        /// Go into an object or an array, which no field can be, not even an optional one
+        bool startNested() noexcept
+        {
+            // Whatever is nested is kept apart from the members of the top-level object
+            ++m_depth;
+            if (m_depth == 2 && m_field != k_NoField)
+            {
+                return failField();
+            }
+            return true;
+        }
+
+        /** Fail parsing, as the current member is a field whose value is of no type a field has
+         *
+         * @returns false, which stops parsing
+         */
+        bool failField() noexcept
+        {
+            std::string_view name;
+            forEachField<Type>(
+                [this, &name](const auto& field, const size_t index)
+                {
+                    if (index == m_field)
+                    {
+                        name = field.name;
+                    }
+                });
+            m_isBound.at(m_field) = false;
+            return fail(k_InvalidValue, name);
+        }
+
+        /** Assign a value to a field
+         *
+         * @tparam Field is the type of field
+         * @tparam Value is the type of value
+         * @param field is the field
+         * @param value is the value
+         * @returns true if the value is of the type of field, otherwise false
+         */
+        template <typename Field, typename Value>
+        [[nodiscard]] static bool assign(Field& field, Value&& value) noexcept
+        {
+            using Decayed = std::remove_cvref_t<Value>;
+            if constexpr (requires { field.emplace(); })
+            {
+                // Null leaves an optional field out
+                if constexpr (std::is_same_v<Decayed, std::nullptr_t>)
+                {
+                    field.reset();
+                    return true;
+                }
+                else
+                {
+                    return assign(field.emplace(), std::forward<Value>(value));
+                }
+            }
+            else if constexpr (std::is_same_v<Field, std::string>)
+            {
+                if constexpr (std::is_same_v<Decayed, std::string>)
+                {
+                    field = std::forward<Value>(value);
+                    return true;
+                }
+                return false;
+            }
+            else if constexpr (std::is_same_v<Field, bool> || std::is_same_v<Decayed, bool>)
+            {
+                if constexpr (std::is_same_v<Field, Decayed>)
+                {
+                    field = value;
+                    return true;
+                }
+                return false;
+            }
+            else if constexpr (std::is_integral_v<Field> && std::is_integral_v<Decayed>)
+            {
+                if (!std::in_range<Field>(value))
+                {
+                    return false;
+                }
+                field = static_cast<Field>(value);
+                return true;
+            }
+            else if constexpr (std::is_floating_point_v<Field> && std::is_arithmetic_v<Decayed>)
+            {
+                field = static_cast<Field>(value);
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        /** Fail parsing
+         *
+         * @param error is what went wrong
+         * @param failedField is the name of the field which went wrong, if it is one
+         * @returns false, which stops parsing
+         */
+        bool fail(const std::string_view error, const std::string_view failedField = {}) noexcept
+        {
+            m_error = error;
+            m_failedField = failedField;
+            return false;
+        }
+
+        /// The request struct
+        Type& m_target;
+
+        /// The fields which have been bound
+        IsBound& m_isBound;
+
+        /// How deep into the body the parser is
+        size_t m_depth{0};
+
+        /// The field of the current member of the top-level object
+        size_t m_field{k_NoField};
+
+        /// What went wrong, if anything did
+        std::string_view m_error;
+
+        /// The field which went wrong, if it is one
+        std::string_view m_failedField;
+    };
+
+    /// Represents a field left out
+    static constexpr std::string_view k_MissingValue{"Value is missing"};
+
+    /// Represents a value of the wrong type
+    static constexpr std::string_view k_InvalidValue{"Value is invalid"};
+
+    /// Represents a body which is not an object
+    static constexpr std::string_view k_MalformedBody{"Body is not an object"};
+};
+
+}  // namespace pizza::endpoint
@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <pizza/endpoint/binary_writer.h>
+#include <pizza/endpoint/encoding.h>
+#include <pizza/endpoint/json_writer.h>
 #include <pizza/support.h>
 
 namespace pizza::endpoint
@@ -15,9 +18,14 @@ namespace pizza::endpoint
  * The Cake
  *
  * @details
- * This is a wrapper to json with restricted set of operations.
+ * This is a flat map of typed slots, which is serialized into JSON only when it is sent.
  * This is a binding. This is not a lie. :P
  *
+ * @details
+ * The first few slots, as well as the strings they hold, live inside the Cake itself. Everything
+ * beyond that comes from a per-request arena that is released all at once with the Cake, hence
+ * emplacing into a Cake does not touch the global allocator in the common case.
+ *
  * @note
  * Objects of Cake are used to pass states between different phases of request processing.
  */
@@ -26,73 +34,436 @@ class Cake final
     DEFAULT_DESTRUCTIBLE_FINAL_CLASS(Cake)
 
    public:
+    /**
+     * Represents a key of the Cake
+     *
+     * @note Keys are interned at compile-time, that is, their hashes are computed by the compiler
+     * and their names must be string literals or constants
+     */
+    class Key final
+    {
+       public:
+        /** Constructor
+         *
+         * @tparam Size is the size of the string literal
+         * @param name is the name of the key
+         */
+        template <size_t Size>
+        consteval Key(const char (&name)[Size]) noexcept  // NOLINT(google-explicit-constructor)
+            : Key{std::string_view{name, Size - 1}}
+        {
+        }
+
+        /** Constructor
+         *
+         * @param name is the name of the key
+         */
+        consteval Key(const std::string_view name) noexcept  // NOLINT(google-explicit-constructor)
+            : m_name{name}, m_hash{hash(name)}
+        {
+        }
+
+        /** Get the name of the key
+         *
+         * @returns the name of the key
+         */
+        [[nodiscard]] constexpr std::string_view getName() const noexcept { return m_name; }
+
+        /** Is it the same key?
+         *
+         * @param other is the other key
+         * @returns true if both keys are the same, otherwise false
+         */
+        [[nodiscard]] constexpr bool operator==(const Key& other) const noexcept
+        {
+            return m_hash == other.m_hash && m_name == other.m_name;
+        }
+
+       private:
+        /** Hash the name of a key with FNV-1a
+         *
+         * @param name is the name of the key
+         * @returns the hash
+         */
+        [[nodiscard]] static constexpr uint64_t hash(const std::string_view name) noexcept
+        {
+            uint64_t result = 14695981039346656037ULL;
+            for (const auto character : name)
+            {
+                result = (result ^ static_cast<u_char>(character)) * 1099511628211ULL;
+            }
+            return result;
+        }
+
+        /// The name of the key
+        std::string_view m_name;
+
+        /// The hash of the name
+        uint64_t m_hash;
+    };
+
+    /// Represents a value held by a slot
+    using SlotValue = std::variant<std::nullptr_t, bool, intmax_t, uintmax_t, double_t,
+                               std::pmr::string, nlohmann::json>;
+
     /// Constructor
-    explicit Cake() noexcept : m_self{nlohmann::json::object()}
+    explicit Cake() noexcept : m_arena{m_inline.data(), m_inline.size()}, m_slots{&m_arena}
     {
-        RUNTIME_ASSERT(m_self.is_object() && "Cake is not an object")
+        m_slots.reserve(k_InlineSlots);
     }
 
     /** The emplace method
      *
      * @tparam Args are the types of arguments
      * @param key is the key
-     * @param value is the value
+     * @param value is the value, which is formatted with the arguments if there are any
      * @param args are the arguments
      */
     template <typename... Args>
-    void emplace(const std::string_view key, const std::string_view value,
-                 const Args&... args) noexcept
+    void emplace(const Key key, const std::string_view value, const Args&... args) noexcept
     {
-        m_self.emplace(key.data(), fmt::vformat(value, fmt::make_format_args(args...)));
+        if (find(key) != nullptr)
+        {
+            return;
+        }
+
+        std::pmr::string string{&m_arena};
+        if constexpr (sizeof...(Args) == 0)
+        {
+            string.assign(value);
+        }
+        else
+        {
+            fmt::vformat_to(std::back_inserter(string), value, fmt::make_format_args(args...));
+        }
+        m_slots.push_back(Slot{key, std::move(string)});
     }
 
     /** The emplace method
      *
-     * @tparam Value is the value type to cast (default: json)
+     * @tparam Value is the type of value
      * @param key is the key
      * @param value is the value
+     *
+     * @note Booleans, numbers and strings get typed slots, anything else is kept as json
      */
-    template <typename Value = nlohmann::json>
-    void emplace(const std::string_view key, const Value& value) noexcept
+    template <typename Value>
+    void emplace(const Key key, const Value& value) noexcept
     {
-        m_self.emplace(key.data(), value);
+        if (find(key) != nullptr)
+        {
+            return;
+        }
+        m_slots.push_back(Slot{key, makeValue(value)});
     }
 
+    /** Does the cake have the key?
+     *
+     * @param key is the key
+     * @returns true if the cake has the key, otherwise false
+     */
+    [[nodiscard]] bool contains(const Key key) const noexcept { return find(key) != nullptr; }
+
     /** The read-only at const-method
      *
      * @tparam Value is the value type to cast (default: json)
      * @param key is the key (intolerant if the key does not exist)
-     * @returns the value for key in the cake
+     * @returns the value for key in the cake, or a value-initialized one if the value is not of the
+     * type asked for, see tryAt
+     *
+     * @note Getting a std::string_view borrows the string held by the cake
      */
     template <typename Value = nlohmann::json>
-    [[nodiscard]] const Value& at(const std::string_view key) const noexcept
+    [[nodiscard]] Value at(const Key key) const noexcept
     {
-        const auto& value = m_self.at(key.data());
-        if constexpr (std::is_same_v<Value, nlohmann::json>)
+        const auto* const slot = find(key);
+        RUNTIME_ASSERT(slot != nullptr && "Key does not exist in the cake")
+        if (slot == nullptr)
         {
-            return value;
+            std::terminate();
         }
-        else
+
+        auto value = toValue<Value>(slot->value);
+        RUNTIME_ASSERT(value.has_value() && "Value is not of the type asked for")
+        return value.value_or(Value{});
+    }
+
+    /** The read-only at const-method, tolerant of keys which do not exist and of values of other
+     * types
+     *
+     * @tparam Value is the value type to cast
+     * @param key is the key
+     * @returns the value for key in the cake, or nothing if there is none or it is not of the type
+     * asked for
+     *
+     * @note Getting a std::string_view borrows the string held by the cake
+     */
+    template <typename Value>
+    [[nodiscard]] std::optional<Value> tryAt(const Key key) const noexcept
+    {
+        const auto* const slot = find(key);
+        if (slot == nullptr)
         {
-            return value.get_ref<const Value&>();
+            return std::nullopt;
         }
+        return toValue<Value>(slot->value);
     }
 
     /** Dump the Cake into JSON-serialized string
      *
      * @returns the JSON-serialized string
      */
-    [[nodiscard]] std::string dump() const noexcept { return m_self.dump(); }
+    [[nodiscard]] std::string dump() const noexcept
+    {
+        JsonWriter::Buffer buffer;
+        dumpTo(buffer);
+        return fmt::to_string(buffer);
+    }
+
+    /** Dump the Cake into the end of a buffer as JSON
+     *
+     * @param buffer is the buffer to append to
+     */
+    void dumpTo(JsonWriter::Buffer& buffer) const noexcept
+    {
+        buffer.push_back('{');
+        for (const auto& slot : m_slots)
+        {
+            if (&slot != m_slots.data())
+            {
+                buffer.push_back(',');
+            }
+            JsonWriter::writeString(buffer, slot.key.getName());
+            buffer.push_back(':');
+            const auto writeValue = [&buffer](const auto& value)
+            { JsonWriter::writeValue(buffer, value); };
+            std::visit(writeValue, slot.value);
+        }
+        buffer.push_back('}');
+    }
 
-    /** Get a const-reference of the cake
+    /** Encode the Cake into the end of a buffer
      *
-     * @returns a const-reference of the cake
+     * @param encoding is the encoding
+     * @param buffer is the buffer to append to
      */
-    [[nodiscard]] const nlohmann::json& operator*() const noexcept { return m_self; }
+    void encodeTo(const Encoding encoding, JsonWriter::Buffer& buffer) const noexcept
+    {
+        switch (encoding)
+        {
+            case Encoding::MessagePack:
+                return encodeTo<Encoding::MessagePack>(buffer);
+            case Encoding::Cbor:
+                return encodeTo<Encoding::Cbor>(buffer);
+            default:
+                return dumpTo(buffer);
+        }
+    }
+
+    /** Convert the Cake into json
+     *
+     * @returns the json object
+     */
+    [[nodiscard]] nlohmann::json toJson() const noexcept
+    {
+        auto result = nlohmann::json::object();
+        for (const auto& slot : m_slots)
+        {
+            const auto toJson = [](const auto& value) { return makeJson(value); };
+            result.emplace(slot.key.getName(), std::visit(toJson, slot.value));
+        }
+        return result;
+    }
 
    private:
+    /// Represents a slot
+    struct Slot final
+    {
+        Key key;          ///< Represents the key
+        SlotValue value;  ///< Represents the value
+    };
+
+    /** Encode the Cake into the end of a buffer as a binary map
+     *
+     * @tparam Format is the binary encoding
+     * @param buffer is the buffer to append to
+     */
+    template <Encoding Format>
+    void encodeTo(JsonWriter::Buffer& buffer) const noexcept
+    {
+        BinaryWriter::writeMap<Format>(buffer, m_slots.size());
+        for (const auto& slot : m_slots)
+        {
+            BinaryWriter::writeString<Format>(buffer, slot.key.getName());
+            const auto writeValue = [&buffer](const auto& value)
+            { BinaryWriter::writeValue<Format>(buffer, value); };
+            std::visit(writeValue, slot.value);
+        }
+    }
+
+    /** Find the slot of a key
+     *
+     * @param key is the key
+     * @returns the slot if the cake has the key, otherwise nullptr
+     */
+    [[nodiscard]] const Slot* find(const Key key) const noexcept
+    {
+        for (const auto& slot : m_slots)
+        {
+            if (slot.key == key)
+            {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    /** Make the value of a slot
+     *
+     * @tparam Type is the type of value
+     * @param value is the value
+     * @returns the value of the slot
+     */
+    template <typename Type>
+    [[nodiscard]] SlotValue makeValue(const Type& value) noexcept
+    {
+        if constexpr (std::is_same_v<Type, std::nullptr_t>)
+        {
+            return nullptr;
+        }
+        else if constexpr (std::is_same_v<Type, bool>)
+        {
+            return value;
+        }
+        else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>)
+        {
+            return static_cast<intmax_t>(value);
+        }
+        else if constexpr (std::is_integral_v<Type>)
+        {
+            return static_cast<uintmax_t>(value);
+        }
+        else if constexpr (std::is_floating_point_v<Type>)
+        {
+            return static_cast<double_t>(value);
+        }
+        else if constexpr (std::is_same_v<Type, nlohmann::json>)
+        {
+            return value;
+        }
+        else if constexpr (std::is_convertible_v<const Type&, std::string_view>)
+        {
+            return std::pmr::string{std::string_view{value}, &m_arena};
+        }
+        else
+        {
+            return nlohmann::json(value);
+        }
+    }
+
+    /** Convert the value of a slot into the type asked for
+     *
+     * @tparam Value is the type asked for
+     * @param slotValue is the value of the slot
+     * @returns the value, or nothing if it is not of the type asked for
+     *
+     * @note Values kept as json are converted too, as long as they hold the type asked for
+     */
+    template <typename Value>
+    [[nodiscard]] static std::optional<Value> toValue(const SlotValue& slotValue) noexcept
+    {
+        return std::visit(
+            [](const auto& value) -> std::optional<Value>
+            {
+                using Type = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<Value, nlohmann::json>)
+                {
+                    return makeJson(value);
+                }
+                else if constexpr (std::is_same_v<Value, std::string_view> ||
+                                   std::is_same_v<Value, std::string>)
+                {
+                    if constexpr (std::is_same_v<Type, std::pmr::string>)
+                    {
+                        return Value{value.data(), value.size()};
+                    }
+                    else if constexpr (std::is_same_v<Type, nlohmann::json>)
+                    {
+                        if (value.is_string())
+                        {
+                            return Value{value.template get_ref<const std::string&>()};
+                        }
+                    }
+                    return std::nullopt;
+                }
+                else if constexpr (std::is_same_v<Value, bool>)
+                {
+                    if constexpr (std::is_same_v<Type, bool>)
+                    {
+                        return value;
+                    }
+                    else if constexpr (std::is_same_v<Type, nlohmann::json>)
+                    {
+                        if (value.is_boolean())
+                        {
+                            return value.template get<bool>();
+                        }
+                    }
+                    return std::nullopt;
+                }
+                else
+                {
+                    static_assert(std::is_arithmetic_v<Value>, "Value type is not supported");
+                    if constexpr (std::is_arithmetic_v<Type>)
+                    {
+                        return static_cast<Value>(value);
+                    }
+                    else if constexpr (std::is_same_v<Type, nlohmann::json>)
+                    {
+                        if (value.is_number())
+                        {
+                            return value.template get<Value>();
+                        }
+                    }
+                    return std::nullopt;
+                }
+            },
+            slotValue);
+    }
+
+    /** Convert a value into json
+     *
+     * @tparam Type is the type of value
+     * @param value is the value
+     * @returns the json value
+     */
+    template <typename Type>
+    [[nodiscard]] static nlohmann::json makeJson(const Type& value) noexcept
+    {
+        if constexpr (std::is_same_v<Type, std::pmr::string>)
+        {
+            return std::string_view{value};
+        }
+        else
+        {
+            return value;
+        }
+    }
+
+    /// The number of slots that live inside the Cake itself
+    static constexpr size_t k_InlineSlots{8};
+
+    /// The number of bytes that live inside the Cake itself, room for strings included
+    static constexpr size_t k_InlineBytes{k_InlineSlots * sizeof(Slot) + 512};
+
+    /// The inline storage
+    alignas(std::max_align_t) std::array<std::byte, k_InlineBytes> m_inline;
+
+    /// The per-request arena, which starts with the inline storage
+    std::pmr::monotonic_buffer_resource m_arena;
+
     /// The Cake itself
-    nlohmann::json m_self;
+    std::pmr::vector<Slot> m_slots;
 };
 
 }  // namespace pizza::endpoint
@@ -0,0 +1,216 @@
+/**
+ * @file pizza/endpoint/concurrency_limiter.h
+ * @brief The adaptive Concurrency Limiter
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Concurrency Limiter
+ *
+ * @brief
+ * The Concurrency Limiter bounds how many requests of a route are processed at once, and adapts
+ * the bound to the latency it observes, so that a slow dependency sheds load instead of piling up
+ * requests until every thread is stuck
+ *
+ * @details
+ * This is the gradient algorithm: the limit shrinks as the recent latency grows beyond the
+ * latency of an idle route (the lowest one seen), and grows by a little headroom (the square root
+ * of the limit) otherwise, hence it settles where requests just start queueing up.
+ * Latencies are averaged over short windows, and only the thread closing a window updates the
+ * limit, hence acquiring and releasing costs a couple of atomic operations.
+ */
+class ConcurrencyLimiter final
+{
+    NOT_COPYABLE_CLASS(ConcurrencyLimiter)
+    IMMOVEABLE_CLASS(ConcurrencyLimiter)
+
+   public:
+    /// Represents the options of the limiter
+    struct Options final
+    {
+        size_t initialLimit{0};  ///< Represents the limit to start with, zero disables the limiter
+        size_t minLimit{1};      ///< Represents the limit the limiter never shrinks below
+        size_t maxLimit{1000};   ///< Represents the limit the limiter never grows beyond
+    };
+
+    /// Represents the clock measuring latencies
+    using Clock = std::chrono::steady_clock;
+
+    /** Constructor
+     *
+     * @param options are the options of the limiter
+     *
+     * @note The limit starts within the minimum and the maximum, whatever the initial one
+     */
+    explicit ConcurrencyLimiter(const Options& options) noexcept
+        : m_options{options},
+          m_limit{std::clamp(options.initialLimit, options.minLimit, options.maxLimit)},
+          m_estimate{static_cast<double_t>(m_limit.load(std::memory_order_relaxed))}
+    {
+        RUNTIME_ASSERT(options.minLimit <= options.maxLimit && "Minimum limit exceeds maximum")
+    }
+
+    /** Is the limiter enabled?
+     *
+     * @returns true if the limiter is enabled, otherwise false
+     */
+    [[nodiscard]] bool isEnabled() const noexcept { return m_options.initialLimit != 0; }
+
+    /** Try to let a request in
+     *
+     * @returns true if the request may be processed, otherwise false, in which case it is shed
+     */
+    [[nodiscard]] bool tryAcquire() noexcept
+    {
+        if (!isEnabled())
+        {
+            return true;
+        }
+
+        const auto inFlight = m_inFlight.fetch_add(1, std::memory_order_relaxed);
+        if (inFlight < m_limit.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+
+        m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+        m_shed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /** Let a request out
+     *
+     * @param latency is how long the request took
+     */
+    void release(const std::chrono::nanoseconds latency) noexcept
+    {
+        if (!isEnabled())
+        {
+            return;
+        }
+
+        const auto inFlight = m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+        m_windowSum.fetch_add(latency.count(), std::memory_order_relaxed);
+        const auto samples = m_windowSamples.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        const auto now = Clock::now().time_since_epoch().count();
+        if (samples < k_MinSamples || now < m_windowEnd.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        // Whoever else is closing the window at the same time takes care of it
+        if (m_updating.test_and_set(std::memory_order_acquire))
+        {
+            return;
+        }
+        const auto sum = m_windowSum.exchange(0, std::memory_order_relaxed);
+        const auto count = m_windowSamples.exchange(0, std::memory_order_relaxed);
+        if (count > 0)
+        {
+            update(static_cast<double_t>(sum) / static_cast<double_t>(count), inFlight);
+        }
+        m_windowEnd.store(now + std::chrono::duration_cast<Clock::duration>(k_Window).count(),
+                          std::memory_order_relaxed);
+        m_updating.clear(std::memory_order_release);
+    }
+
+    /** Get the limit
+     *
+     * @returns the current limit, zero if the limiter is disabled
+     */
+    [[nodiscard]] size_t getLimit() const noexcept
+    {
+        return m_limit.load(std::memory_order_relaxed);
+    }
+
+    /** Get the number of requests shed
+     *
+     * @returns the number of requests shed so far
+     */
+    [[nodiscard]] uint64_t getShed() const noexcept
+    {
+        return m_shed.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /** Update the limit with the latency of a window
+     *
+     * @param latency is the average latency of the window, in nanoseconds
+     * @param inFlight is how many requests were in flight when the window closed
+     */
+    void update(const double_t latency, const size_t inFlight) noexcept
+    {
+        // The lowest latency creeps up, so that it follows a route which has become slower for good
+        m_idleLatency = (m_idleLatency == 0.0) ? latency
+                                               : std::min(m_idleLatency * k_IdleDrift, latency);
+
+        const auto gradient = std::clamp(k_Tolerance * m_idleLatency / latency, 0.5, 1.0);
+        auto target = m_estimate * gradient + std::sqrt(m_estimate);
+
+        // Do not grow the limit of a route that is nowhere near using it, yet shrink it all the
+        // same when its latency rises
+        if (static_cast<double_t>(inFlight) < m_estimate / 2.0)
+        {
+            target = std::min(target, m_estimate * gradient);
+        }
+        m_estimate = std::clamp(m_estimate * (1.0 - k_Smoothing) + target * k_Smoothing,
+                                static_cast<double_t>(m_options.minLimit),
+                                static_cast<double_t>(m_options.maxLimit));
+        m_limit.store(static_cast<size_t>(m_estimate), std::memory_order_relaxed);
+    }
+
+    /// Represents how long a window of latencies lasts at least
+    static constexpr std::chrono::milliseconds k_Window{100};
+
+    /// Represents how many latencies a window holds at least
+    static constexpr uint64_t k_MinSamples{10};
+
+    /// Represents how much the lowest latency creeps up with each window
+    static constexpr double_t k_IdleDrift{1.01};
+
+    /// Represents how much slower than the lowest latency a window may be before shrinking
+    static constexpr double_t k_Tolerance{1.1};
+
+    /// Represents how much the limit follows each window
+    static constexpr double_t k_Smoothing{0.2};
+
+    /// The options
+    const Options m_options;
+
+    /// The limit
+    std::atomic<size_t> m_limit;
+
+    /// How many requests are in flight
+    std::atomic<size_t> m_inFlight{0};
+
+    /// How many requests have been shed
+    std::atomic<uint64_t> m_shed{0};
+
+    /// The sum of latencies of the current window, in nanoseconds
+    std::atomic<int64_t> m_windowSum{0};
+
+    /// The number of latencies of the current window
+    std::atomic<uint64_t> m_windowSamples{0};
+
+    /// When the current window ends, in ticks of the clock
+    std::atomic<Clock::rep> m_windowEnd{0};
+
+    /// Indicates if a thread is updating the limit
+    std::atomic_flag m_updating = ATOMIC_FLAG_INIT;
+
+    /// The limit before rounding, only touched by the thread updating the limit
+    double_t m_estimate;
+
+    /// The lowest latency seen, only touched by the thread updating the limit
+    double_t m_idleLatency{0.0};
+};
+
+}  // namespace pizza::endpoint
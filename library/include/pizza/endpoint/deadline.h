@@ -0,0 +1,101 @@
+/**
+ * @file pizza/endpoint/deadline.h
+ * @brief The Deadline of a request
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/timer_wheel.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * Represents the deadline of a request
+ *
+ * @details
+ * A deadline is set when the request comes in, from the budget of its route or from the budget
+ * the client asks for, whichever is shorter, and expires on the Timer Wheel. Handlers may look at
+ * it as often as they like, as it is no more than an atomic load, to give up on work whose
+ * response nobody waits for anymore, or to bound the calls they make upstream.
+ *
+ * @note Copies share the same timer, which is cancelled once the last of them goes
+ */
+class Deadline final
+{
+   public:
+    /// Represents the clock of deadlines
+    using Clock = TimerWheel::Clock;
+
+    /// Constructor, of no deadline
+    explicit Deadline() noexcept = default;
+
+    /** Make a deadline
+     *
+     * @param budget is how long from now the deadline is
+     * @returns the deadline
+     */
+    [[nodiscard]] static Deadline after(const std::chrono::milliseconds budget) noexcept
+    {
+        // Allocated apart from its control block, which is all the wheel keeps once it is cancelled
+        Deadline deadline;
+        deadline.m_timer.reset(new TimerWheel::Timer{Clock::now() + budget});  // NOLINT
+        TimerWheel::getTimerWheel().schedule(deadline.m_timer);
+        return deadline;
+    }
+
+    /** Get the earlier of two deadlines
+     *
+     * @param lhs is a deadline
+     * @param rhs is another deadline
+     * @returns the deadline which expires first, the one which is set if only one is, otherwise no
+     * deadline
+     */
+    [[nodiscard]] static Deadline earlier(Deadline lhs, Deadline rhs) noexcept
+    {
+        if (!rhs.isSet() || (lhs.isSet() && lhs.m_timer->expires <= rhs.m_timer->expires))
+        {
+            return lhs;
+        }
+        return rhs;
+    }
+
+    /** Is there a deadline?
+     *
+     * @returns true if there is a deadline, otherwise false
+     */
+    [[nodiscard]] bool isSet() const noexcept { return m_timer != nullptr; }
+
+    /** Has the deadline expired?
+     *
+     * @returns true if the deadline has expired, otherwise false
+     */
+    [[nodiscard]] bool isExpired() const noexcept
+    {
+        return m_timer != nullptr && m_timer->isExpired.load(std::memory_order_acquire);
+    }
+
+    /** Get the time left
+     *
+     * @returns the time left until the deadline, zero if it has passed, or nothing if there is no
+     * deadline
+     */
+    [[nodiscard]] std::optional<std::chrono::milliseconds> getRemaining() const noexcept
+    {
+        if (m_timer == nullptr)
+        {
+            return std::nullopt;
+        }
+        const auto remaining = m_timer->expires - Clock::now();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::max(remaining, Clock::duration::zero()));
+    }
+
+   private:
+    /// The timer, nullptr if there is no deadline
+    std::shared_ptr<TimerWheel::Timer> m_timer;
+};
+
+}  // namespace pizza::endpoint
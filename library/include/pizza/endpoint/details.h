@@ -8,6 +8,7 @@
 
 #include <external/pistache/all.h>
 #include <pizza/endpoint/handler.h>
+#include <pizza/endpoint/route_table.h>
 #include <pizza/log/logger.h>
 #include <pizza/support.h>
 
@@ -17,46 +18,92 @@ namespace pizza::endpoint::details
 /** Append a new router record
  *
  * @param pistacheRouter is the Pistache router
- * @param pizzaHandler is the handler object
- * @param requestMethod is the request method
- * @param requestPath is the request path
+ * @param route is the route, which must outlive the router
  *
  * @private
  */
-inline void addHandler(Pistache::Rest::Router& pistacheRouter, Handler& pizzaHandler,
-                       const Request::Method requestMethod,
-                       const std::string_view requestPath) noexcept
+inline void addHandler(Pistache::Rest::Router& pistacheRouter, const Route& route) noexcept
 {
-    switch (requestMethod)
+    const auto handler = [&route](const Pistache::Rest::Request& request,
+                                  Pistache::Http::ResponseWriter response)
+    {
+        route.getHandler().handleRequest(request, std::move(response), route);
+        return Pistache::Rest::Route::Result::Ok;
+    };
+
+    const std::string requestPath{route.getPath()};
+    switch (route.getMethod())
     {
         case Request::Method::Get:
-            return Pistache::Rest::Routes::Get(
-                pistacheRouter, requestPath.data(),
-                Pistache::Rest::Routes::bind(&Handler::handleRequest, &pizzaHandler));
+            return Pistache::Rest::Routes::Get(pistacheRouter, requestPath, handler);
 
         case Request::Method::Post:
-            return Pistache::Rest::Routes::Post(
-                pistacheRouter, requestPath.data(),
-                Pistache::Rest::Routes::bind(&Handler::handleRequest, &pizzaHandler));
+            return Pistache::Rest::Routes::Post(pistacheRouter, requestPath, handler);
 
         case Request::Method::Put:
-            return Pistache::Rest::Routes::Put(
-                pistacheRouter, requestPath.data(),
-                Pistache::Rest::Routes::bind(&Handler::handleRequest, &pizzaHandler));
+            return Pistache::Rest::Routes::Put(pistacheRouter, requestPath, handler);
 
         case Request::Method::Patch:
-            return Pistache::Rest::Routes::Patch(
-                pistacheRouter, requestPath.data(),
-                Pistache::Rest::Routes::bind(&Handler::handleRequest, &pizzaHandler));
+            return Pistache::Rest::Routes::Patch(pistacheRouter, requestPath, handler);
 
         case Request::Method::Delete:
-            return Pistache::Rest::Routes::Delete(
-                pistacheRouter, requestPath.data(),
-                Pistache::Rest::Routes::bind(&Handler::handleRequest, &pizzaHandler));
+            return Pistache::Rest::Routes::Delete(pistacheRouter, requestPath, handler);
 
         default:
             RUNTIME_ASSERT(false && "Use of unsupported request method")
     }
 }
 
+/**
+ * Dispatches requests of static routes straight to their handlers
+ *
+ * @details
+ * Requests that do not match any static route, for example those of parameterized routes, fall
+ * back to the Pistache router
+ *
+ * @private
+ */
+class Dispatcher final : public Pistache::Http::Handler
+{
+   public:
+    HTTP_PROTOTYPE(Dispatcher)
+
+    /// Represents the Route Table of static routes
+    using StaticRoutes = RouteTable<const Route*>;
+
+    /** Constructor
+     *
+     * @param routeTable is the Route Table of static routes
+     * @param fallback is the handler of the Pistache router
+     */
+    explicit Dispatcher(std::shared_ptr<const StaticRoutes> routeTable,
+                        std::shared_ptr<Pistache::Http::Handler> fallback) noexcept
+        : m_routeTable{std::move(routeTable)}, m_fallback{std::move(fallback)}
+    {
+    }
+
+    /** Dispatch the request
+     *
+     * @param request is the Pistache::Http::Request object
+     * @param response is the Pistache::Http::ResponseWriter object
+     */
+    void onRequest(const Pistache::Http::Request& request,
+                   Pistache::Http::ResponseWriter response) override
+    {
+        const auto* const route = m_routeTable->find(request.method(), request.resource());
+        if (route != nullptr)
+        {
+            return (*route)->getHandler().handleRequest(request, std::move(response), **route);
+        }
+        m_fallback->onRequest(request, std::move(response));
+    }
+
+   private:
+    /// The Route Table of static routes
+    std::shared_ptr<const StaticRoutes> m_routeTable;
+
+    /// The handler of the Pistache router
+    std::shared_ptr<Pistache::Http::Handler> m_fallback;
+};
+
 }  // namespace pizza::endpoint::details
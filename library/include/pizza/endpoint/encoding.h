@@ -0,0 +1,197 @@
+/**
+ * @file pizza/endpoint/encoding.h
+ * @brief The encodings of bodies
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/pistache/all.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/// Represents the encoding of a body
+enum class Encoding
+{
+    Json,         ///< application/json, the default
+    MessagePack,  ///< application/msgpack
+    Cbor          ///< application/cbor
+};
+
+/**
+ * Packages together the functions negotiating the encodings of bodies
+ *
+ * This class is not meant to be constructed, but to hide some details
+ */
+class Encodings final
+{
+    STATIC_CLASS(Encodings)
+
+   public:
+    /** Get the media type of an encoding
+     *
+     * @param encoding is the encoding
+     * @returns the media type
+     */
+    [[nodiscard]] static const Pistache::Http::Mime::MediaType& getMediaType(
+        const Encoding encoding) noexcept
+    {
+        static const auto k_Json = MIME(Application, Json);
+        static const auto k_MessagePack =
+            Pistache::Http::Mime::MediaType::fromString(std::string{k_MessagePackType});
+        static const auto k_Cbor =
+            Pistache::Http::Mime::MediaType::fromString(std::string{k_CborType});
+
+        switch (encoding)
+        {
+            case Encoding::MessagePack:
+                return k_MessagePack;
+            case Encoding::Cbor:
+                return k_Cbor;
+            default:
+                return k_Json;
+        }
+    }
+
+    /** Get the encoding of a body from its Content-Type
+     *
+     * @param contentType is the value of the Content-Type header
+     * @returns the binary encoding named by the header, otherwise JSON
+     *
+     * @note Anything but the binary encodings is taken as JSON, as bodies always have been
+     */
+    [[nodiscard]] static Encoding fromContentType(const std::string_view contentType) noexcept
+    {
+        return fromMediaRange(trim(contentType.substr(0, contentType.find(';'))))
+            .value_or(Encoding::Json);
+    }
+
+    /** Decode bytes in an encoding
+     *
+     * @param encoding is the encoding
+     * @param bytes are the bytes
+     * @returns the decoded value, or a discarded json if the bytes are malformed
+     */
+    [[nodiscard]] static nlohmann::json decode(const Encoding encoding,
+                                               const std::string_view bytes) noexcept
+    {
+        switch (encoding)
+        {
+            case Encoding::MessagePack:
+                return nlohmann::json::from_msgpack(bytes, true, false);
+            case Encoding::Cbor:
+                return nlohmann::json::from_cbor(bytes, true, false);
+            default:
+                return nlohmann::json::parse(bytes, nullptr, false);
+        }
+    }
+
+    /** Negotiate the encoding of a response from the Accept header of its request
+     *
+     * @param accept is the value of the Accept header
+     * @returns the supported encoding of highest quality, JSON if none is acceptable
+     *
+     * @note Wildcards stand for JSON, and the first of the encodings of the same quality wins
+     */
+    [[nodiscard]] static Encoding negotiate(std::string_view accept) noexcept
+    {
+        auto result = Encoding::Json;
+        auto resultQuality = 0.0;
+        while (!accept.empty())
+        {
+            const auto size = std::min(accept.find(','), accept.size());
+            const auto item = accept.substr(0, size);
+            accept.remove_prefix(std::min(size + 1, accept.size()));
+
+            const auto parameters = std::min(item.find(';'), item.size());
+            const auto encoding = fromMediaRange(trim(item.substr(0, parameters)));
+            const auto quality = getQuality(item.substr(parameters));
+            if (encoding && quality > resultQuality)
+            {
+                result = *encoding;
+                resultQuality = quality;
+            }
+        }
+        return result;
+    }
+
+   private:
+    /** Get the encoding of a media range
+     *
+     * @param mediaRange is the media range, without parameters
+     * @returns the encoding if it is supported, JSON for wildcards, otherwise nothing
+     */
+    [[nodiscard]] static std::optional<Encoding> fromMediaRange(
+        const std::string_view mediaRange) noexcept
+    {
+        const auto isSame = [mediaRange](const std::string_view type)
+        {
+            return std::equal(mediaRange.begin(), mediaRange.end(), type.begin(), type.end(),
+                              [](const char left, const char right)
+                              { return std::tolower(static_cast<u_char>(left)) == right; });
+        };
+
+        if (isSame(k_MessagePackType) || isSame("application/x-msgpack") ||
+            isSame("application/vnd.msgpack"))
+        {
+            return Encoding::MessagePack;
+        }
+        if (isSame(k_CborType))
+        {
+            return Encoding::Cbor;
+        }
+        if (isSame("application/json") || isSame("application/*") || isSame("*/*"))
+        {
+            return Encoding::Json;
+        }
+        return std::nullopt;
+    }
+
+    /** Get the quality of an item of the Accept header
+     *
+     * @param parameters are the parameters of the item, as in ";q=0.5"
+     * @returns the quality, 1 if there is none or if it is malformed
+     */
+    [[nodiscard]] static double_t getQuality(std::string_view parameters) noexcept
+    {
+        while (!parameters.empty())
+        {
+            parameters.remove_prefix(1);
+            const auto size = std::min(parameters.find(';'), parameters.size());
+            const auto parameter = trim(parameters.substr(0, size));
+            parameters.remove_prefix(size);
+
+            if (parameter.starts_with("q=") || parameter.starts_with("Q="))
+            {
+                auto quality = 1.0;
+                const auto value = parameter.substr(2);
+                std::from_chars(value.data(), value.data() + value.size(), quality);
+                return quality;
+            }
+        }
+        return 1.0;
+    }
+
+    /** Trim the spaces around a string
+     *
+     * @param string is the string
+     * @returns the string without surrounding spaces
+     */
+    [[nodiscard]] static std::string_view trim(std::string_view string) noexcept
+    {
+        string.remove_prefix(std::min(string.find_first_not_of(" \t"), string.size()));
+        string.remove_suffix(string.size() -
+                             std::min(string.find_last_not_of(" \t") + 1, string.size()));
+        return string;
+    }
+
+    /// The media type of MessagePack
+    static constexpr std::string_view k_MessagePackType{"application/msgpack"};
+
+    /// The media type of CBOR
+    static constexpr std::string_view k_CborType{"application/cbor"};
+};
+
+}  // namespace pizza::endpoint
@@ -12,12 +12,34 @@
 #include <pizza/endpoint/concepts.h>
 #include <pizza/endpoint/details.h>
 #include <pizza/endpoint/handler.h>
+#include <pizza/endpoint/lifecycle.h>
+#include <pizza/endpoint/route.h>
+#include <pizza/endpoint/route_table.h>
+#include <pizza/endpoint/topology.h>
+#include <pizza/endpoint/worker_pool.h>
 #include <pizza/log/logger.h>
 #include <pizza/support.h>
 
 namespace pizza::endpoint
 {
 
+/// Represents the options to serve the endpoint with
+struct Options final
+{
+    const std::string address;         ///< Represents the IP address the server listens on
+    const uint16_t port;               ///< Represents the port on which the server listens on
+    const int threads;                 ///< Represents how many Pistache threads to open
+    const size_t minWorkers{0};        ///< Represents how many workers blocking handlers keep
+    const size_t maxWorkers{64};       ///< Represents how many workers blocking handlers grow to
+    const bool staticDispatch{false};  ///< Represents whether static routes skip the router
+    const bool threadPerCore{false};   ///< Represents whether every core gets its own listener
+    const std::chrono::seconds drainTimeout{30};  ///< Represents how long requests may drain for
+    const log::Level logLevel{log::Level::Debug};  ///< Represents the lowest level logged
+    const log::Output logOutput{log::Output::Text};  ///< Represents how logs are written out
+    const log::Sampling logSampling{.rate = 100};  ///< Represents how many logs a call site writes
+    const log::File logFile{};  ///< Represents the file logs are written to, if any
+};
+
 /**
  * The Endpoint
  *
@@ -42,18 +64,123 @@ class Endpoint final
     [[nodiscard]] std::string_view addHandler() noexcept
     {
         auto pizzaHandler = std::make_unique<Handler>();
-        for (const auto& [requestMethod, requestPath] : Handler::k_ApiDesc)
+        for (const auto& [requestMethod, requestPath, concurrencyLimit, rateLimit, singleFlight,
+                          cache, deadline] : Handler::k_ApiDesc)
         {
             m_log.debug("Registering {} on {} {}", Handler::k_Name,
                         magic_enum::enum_name(requestMethod), requestPath);
 
-            details::addHandler(m_pistacheRouter, *pizzaHandler, requestMethod, requestPath);
+            const auto& route =
+                m_routes.emplace_back(*pizzaHandler, requestMethod, requestPath, concurrencyLimit,
+                                      rateLimit, singleFlight, cache, deadline);
+            details::addHandler(m_pistacheRouter, route);
+            if (StaticRoutes::isStatic(requestPath))
+            {
+                m_staticRoutes.push_back({requestMethod, requestPath, &route});
+            }
         }
 
         m_self.emplace_back(std::move(pizzaHandler));
         return Handler::k_Name;
     }
 
+    /** Find the route serving a request
+     *
+     * @param requestMethod is the request method
+     * @param requestPath is the request path, without the query
+     * @returns the route if there is one, otherwise nullptr
+     */
+    [[nodiscard]] const Route* findRoute(const Request::Method requestMethod,
+                                         const std::string_view requestPath) const noexcept
+    {
+        const auto iter = std::find_if(m_routes.begin(), m_routes.end(),
+                                       [requestMethod, requestPath](const Route& route)
+                                       { return route.matches(requestMethod, requestPath); });
+        return (iter == m_routes.end()) ? nullptr : &*iter;
+    }
+
+    /** Serve the endpoint, until told to shut down or to restart
+     *
+     * @param options are the options to serve the endpoint with
+     *
+     * @details
+     * SIGTERM and SIGINT stop accepting connections, drain the requests in flight and shut down.
+     * SIGHUP first starts a successor listening on the same port, and only once it is serving does
+     * the same, hence restarts never refuse a connection. Should the successor fail, this process
+     * keeps serving.
+     */
+    void serveOn(const Options& options) noexcept
+    {
+        // Every thread spawned from here on inherits the mask, so only this one takes the signals
+        auto& lifecycle = Lifecycle::getLifecycle();
+        lifecycle.blockSignals();
+
+        WorkerPool::getWorkerPool().configure(options.minWorkers, options.maxWorkers);
+        log::setLevel(options.logLevel);
+        log::setOutput(options.logOutput);
+        log::setSampling(options.logSampling);
+        log::setFile(options.logFile);
+
+        // The port is shared with the other cores, or with the predecessor, and with no one else
+        auto flags = Pistache::Tcp::Options::ReuseAddr;
+        if (options.threadPerCore || lifecycle.isSuccessor())
+        {
+            flags = flags | Pistache::Tcp::Options::ReusePort;
+        }
+
+        std::vector<Listener> listeners;
+        if (!options.threadPerCore)
+        {
+            m_log.info("Serving on {}:{} with {} threads", options.address, options.port,
+                       options.threads);
+            listeners.emplace_back(serve(options, options.threads, flags));
+        }
+        else
+        {
+            // Every core accepts its own connections, and keeps them to itself from then on
+            const auto cores = Topology::getCores();
+            m_log.info("Serving on {}:{} with a thread on each of {} cores", options.address,
+                       options.port, cores.size());
+            for (const auto core : cores)
+            {
+                // The threads spawned by Pistache inherit the pinning
+                if (!Topology::pinTo(core))
+                {
+                    m_log.warn("Failed to pin to core {}", core);
+                }
+                listeners.emplace_back(serve(options, 1, flags));
+            }
+            if (!Topology::pinTo(cores))
+            {
+                m_log.warn("Failed to unpin from the last core");
+            }
+        }
+        lifecycle.notifyReady();
+
+        std::vector<int> descriptors;
+        for (const auto& listener : listeners)
+        {
+            descriptors.insert(descriptors.end(), listener.descriptors.begin(),
+                               listener.descriptors.end());
+        }
+        while (lifecycle.waitForSignal() == Lifecycle::Next::Restart &&
+               !lifecycle.spawnSuccessor(descriptors, k_SuccessorTimeout))
+        {
+            m_log.warn("Keeping on serving without a successor");
+        }
+
+        lifecycle.stopListening(descriptors);
+        lifecycle.drain(options.drainTimeout);
+
+        // Whatever is left once draining gave up still writes to its connection
+        WorkerPool::getWorkerPool().join();
+        for (auto& listener : listeners)
+        {
+            listener.endpoint->shutdown();
+        }
+        m_log.info("Shut down");
+    }
+
     /** Serve the endpoint
      *
      * @param address is the IP address on which the server listens on
@@ -62,18 +189,64 @@ class Endpoint final
      */
     void serveOn(const std::string_view address, const uint16_t port, const int threads) noexcept
     {
-        const Pistache::Address pistacheAddress{address.data(), port};
-        Pistache::Http::Endpoint pistacheEndpoint{pistacheAddress};
+        serveOn({.address = std::string{address}, .port = port, .threads = threads});
+    }
 
-        const auto pistacheOptions = Pistache::Http::Endpoint::options().threads(threads);
-        pistacheEndpoint.init(pistacheOptions);
-        pistacheEndpoint.setHandler(m_pistacheRouter.handler());
+   private:
+    /// Represents a Pistache endpoint which is serving, along with the sockets it listens on
+    struct Listener final
+    {
+        std::unique_ptr<Pistache::Http::Endpoint> endpoint;  ///< Represents the Pistache endpoint
+        std::vector<int> descriptors;  ///< Represents the sockets the Pistache endpoint opened
+    };
 
-        m_log.info("Serving on {}:{} with {} threads", address, port, threads);
-        pistacheEndpoint.serve();
+    /** Serve a Pistache endpoint, in the background
+     *
+     * @param options are the options to serve the endpoint with
+     * @param threads means how many threads to open
+     * @param flags are the flags of the listening socket
+     * @returns the Pistache endpoint, which is serving, along with the sockets it listens on
+     *
+     * @note What the Pistache endpoint allocates, its reactor included, is first touched by the
+     * calling thread, hence lives on its NUMA node. The handlers, the routes and what hangs off
+     * them, such as the caches, the limiters and the metrics, are built once and shared by every
+     * core, wherever they were first touched.
+     */
+    [[nodiscard]] Listener serve(const Options& options, const int threads,
+                                 const Pistache::Tcp::Options flags) const noexcept
+    {
+        const Pistache::Address pistacheAddress{options.address, options.port};
+        auto pistacheEndpoint = std::make_unique<Pistache::Http::Endpoint>(pistacheAddress);
+
+        const auto pistacheOptions =
+            Pistache::Http::Endpoint::options().threads(threads).flags(flags);
+        pistacheEndpoint->init(pistacheOptions);
+        if (options.staticDispatch)
+        {
+            // Static routes are looked up in the Route Table, the rest falls back to the router
+            auto routeTable = std::make_shared<const StaticRoutes>(m_staticRoutes);
+            m_log.debug("Dispatching {} static routes without the router", routeTable->size());
+            pistacheEndpoint->setHandler(std::make_shared<details::Dispatcher>(
+                std::move(routeTable), m_pistacheRouter.handler()));
+        }
+        else
+        {
+            pistacheEndpoint->setHandler(m_pistacheRouter.handler());
+        }
+
+        // Pistache keeps its listening sockets to itself, hence they are told apart from the ones
+        // of the other cores by being the ones which were not there before it bound
+        const auto before = Lifecycle::findListeners(options.port);
+        pistacheEndpoint->serveThreaded();
+        auto descriptors = Lifecycle::findListeners(options.port);
+        std::erase_if(descriptors, [&before](const int fd)
+                      { return std::find(before.begin(), before.end(), fd) != before.end(); });
+        return {.endpoint = std::move(pistacheEndpoint), .descriptors = std::move(descriptors)};
     }
 
-   private:
+    /// Represents how long a successor may take to start serving
+    static constexpr std::chrono::seconds k_SuccessorTimeout{30};
+
     /// The Logger
     const pizza::log::Logger m_log{"endpoint"};
 
@@ -82,6 +255,15 @@ class Endpoint final
 
     /// The Pistache REST Router
     Pistache::Rest::Router m_pistacheRouter;
+
+    /// The routes, which never move once added
+    std::deque<Route> m_routes;
+
+    /// Represents the Route Table of static routes
+    using StaticRoutes = RouteTable<const Route*>;
+
+    /// The static routes, which are gathered into the Route Table when serving
+    std::vector<StaticRoutes::Route> m_staticRoutes;
 };
 
 /** Add handler to endpoint
@@ -96,6 +278,16 @@ template <concepts::PizzaHandler Handler>
     return endpoint.addHandler<Handler>();
 }
 
+/** Serve the endpoint
+ *
+ * @param options are the options to serve the endpoint with
+ */
+inline void serveOn(const Options& options) noexcept
+{
+    auto& endpoint = Endpoint::getEndpoint();
+    endpoint.serveOn(options);
+}
+
 /** Serve the endpoint
  *
  * @param address is the IP address on which the server listens on
@@ -108,6 +300,21 @@ inline void serveOn(const std::string_view address, const uint16_t port, const i
     endpoint.serveOn(address, port, threads);
 }
 
+/** Exit on invalid command-line options, which are the user's to fix rather than an assertion
+ *
+ * @param options are the command-line options, whose usage is printed
+ * @param what is what is invalid
+ *
+ * @private
+ */
+[[noreturn]] inline void exitWithUsage(const cxxopts::Options& options,
+                                       const std::string_view what) noexcept
+{
+    pizza::log::fatal("endpoint", "{}", what);
+    fmt::print(stderr, "\n{}\n", options.help());
+    std::exit(1);  // NOLINT(concurrency-mt-unsafe)
+}
+
 /** Parse command-line options
  *
  * @param endpointName is the name of the endpoint
@@ -117,36 +324,92 @@ inline void serveOn(const std::string_view address, const uint16_t port, const i
  *
  * @returns the parsed options
  */
-[[nodiscard]] inline auto parseOptions(const std::string_view endpointName,
-                                       const std::string_view endpointDescription,
-                                       const int mainArgc, const char** mainArgv) noexcept
+[[nodiscard]] inline Options parseOptions(const std::string_view endpointName,
+                                          const std::string_view endpointDescription,
+                                          const int mainArgc, const char** mainArgv) noexcept
 {
     cxxopts::Options options{endpointName.data(), endpointDescription.data()};
     {
+        // One thread per core the process may run on, rather than whatever the machine has
+        const auto cores = std::to_string(Topology::getCores().size());
+
         // clang-format off
         options.add_options()
             ("address", "Address to listen", cxxopts::value<std::string>()->default_value("127.0.0.1"))
             ("port", "Port to listen", cxxopts::value<uint16_t>()->default_value("8080"))
-            ("threads", "Threads to serve", cxxopts::value<int>()->default_value("32"))
+            ("threads", "Threads to serve", cxxopts::value<int>()->default_value(cores))
+            ("min-workers", "Workers to keep for blocking handlers", cxxopts::value<size_t>()->default_value("0"))
+            ("max-workers", "Workers to grow up to for blocking handlers", cxxopts::value<size_t>()->default_value("64"))
+            ("static-dispatch", "Dispatch static routes with a perfect hash", cxxopts::value<bool>()->default_value("false"))
+            ("thread-per-core", "Listen with a pinned thread on each core", cxxopts::value<bool>()->default_value("false"))
+            ("drain-timeout", "Seconds to drain requests for when shutting down", cxxopts::value<uint32_t>()->default_value("30"))
+            ("log-level", "Lowest level to log: Debug, Info, Warn, Error or Fatal", cxxopts::value<std::string>()->default_value("Debug"))
+            ("log-output", "How to write logs: Text, Json, or Binary to stdout for log_decoder", cxxopts::value<std::string>()->default_value("Text"))
+            ("log-rate", "Logs every call site writes per second, 0 for no limit", cxxopts::value<uint32_t>()->default_value("100"))
+            ("log-sample", "Write one in so many logs past the rate, 0 for none", cxxopts::value<uint32_t>()->default_value("0"))
+            ("log-file", "File to write logs to, stdout and stderr if empty", cxxopts::value<std::string>()->default_value(""))
+            ("log-rotate-size", "Megabytes to rotate the log file at, 0 for never", cxxopts::value<size_t>()->default_value("64"))
+            ("log-rotate-age", "Seconds to rotate the log file after, 0 for never", cxxopts::value<uint32_t>()->default_value("0"))
+            ("log-compress", "Gzip rotated log files in the background", cxxopts::value<bool>()->default_value("false"))
             ("help", "Print usage");
         // clang-format on
     }
     try
     {
         const auto result = options.parse(mainArgc, mainArgv);
-        if (result.count("help") == 0)
+        if (result.count("help") != 0)
+        {
+            fmt::print(stdout, "\n{}\n", options.help());
+            std::exit(0);  // NOLINT(concurrency-mt-unsafe)
+        }
+
+        const auto logLevel =
+            magic_enum::enum_cast<log::Level>(result["log-level"].as<std::string>());
+        if (!logLevel)
         {
-            return std::make_tuple(result["address"].as<std::string>(),
-                                   result["port"].as<uint16_t>(), result["threads"].as<int>());
+            exitWithUsage(options, "Unknown log level");
         }
-        fmt::print(stdout, "\n{}\n", options.help());
-        std::exit(0);  // NOLINT(concurrency-mt-unsafe)
+        const auto logOutput =
+            magic_enum::enum_cast<log::Output>(result["log-output"].as<std::string>());
+        if (!logOutput)
+        {
+            exitWithUsage(options, "Unknown log output");
+        }
+        const auto threads = result["threads"].as<int>();
+        if (threads <= 0)
+        {
+            exitWithUsage(options, "Threads must be at least 1");
+        }
+        const auto minWorkers = result["min-workers"].as<size_t>();
+        const auto maxWorkers = result["max-workers"].as<size_t>();
+        if (maxWorkers == 0 || minWorkers > maxWorkers)
+        {
+            exitWithUsage(options, "Max workers must be at least 1, and at least min workers");
+        }
+
+        return {
+            .address = result["address"].as<std::string>(),
+            .port = result["port"].as<uint16_t>(),
+            .threads = threads,
+            .minWorkers = minWorkers,
+            .maxWorkers = maxWorkers,
+            .staticDispatch = result["static-dispatch"].as<bool>(),
+            .threadPerCore = result["thread-per-core"].as<bool>(),
+            .drainTimeout = std::chrono::seconds{result["drain-timeout"].as<uint32_t>()},
+            .logLevel = *logLevel,
+            .logOutput = *logOutput,
+            .logSampling = {.rate = result["log-rate"].as<uint32_t>(),
+                            .every = result["log-sample"].as<uint32_t>()},
+            .logFile = {.path = result["log-file"].as<std::string>(),
+                        .rotateSize = result["log-rotate-size"].as<size_t>() << 20U,
+                        .rotateAge = std::chrono::seconds{result["log-rotate-age"].as<uint32_t>()},
+                        .isCompressed = result["log-compress"].as<bool>()},
+        };
     }
-    catch (const cxxopts::option_not_exists_exception& e)
+    catch (const cxxopts::OptionException& e)
     {
-        pizza::log::fatal("endpoint", e.what());
-        fmt::print(stderr, "\n{}\n", options.help());
-        std::exit(1);  // NOLINT(concurrency-mt-unsafe)
+        // Unknown options as well as values which do not parse, such as a port out of range
+        exitWithUsage(options, e.what());
     }
 }
 
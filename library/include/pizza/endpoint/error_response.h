@@ -45,7 +45,7 @@ class ErrorResponse final : public std::runtime_error
         : std::runtime_error{cake.dump()}, m_code{code}
     {
         m_cake.emplace("code", static_cast<uintmax_t>(code));
-        m_cake.emplace("what", *cake);
+        m_cake.emplace("what", cake.toJson());
     }
 
     /** Get the response code
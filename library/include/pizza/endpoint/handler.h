@@ -7,9 +7,18 @@
 #pragma once
 
 #include <pizza/endpoint/cake.h>
+#include <pizza/endpoint/concurrency_limiter.h>
 #include <pizza/endpoint/error_response.h>
+#include <pizza/endpoint/lifecycle.h>
+#include <pizza/endpoint/metrics.h>
+#include <pizza/endpoint/outcome.h>
+#include <pizza/endpoint/rate_limiter.h>
 #include <pizza/endpoint/request.h>
 #include <pizza/endpoint/response.h>
+#include <pizza/endpoint/response_cache.h>
+#include <pizza/endpoint/route.h>
+#include <pizza/endpoint/single_flight.h>
+#include <pizza/endpoint/worker_pool.h>
 #include <pizza/log/logger.h>
 #include <pizza/support.h>
 
@@ -20,6 +29,8 @@ namespace pizza::endpoint
  * The base class of all handlers
  *
  * @note Remember, this is a multithreaded class - Mark everything as const!
+ * @note Handlers that block (e.g. on I/O) should declare themselves blocking, so that their phases
+ * run on the Worker Pool rather than on the Pistache reactor threads
  */
 class Handler
 {
@@ -48,6 +59,34 @@ class Handler
         m_log.warn("`processRequest` is not implemented!");
     }
 
+    /** Prepare the handler, without throwing
+     *
+     * @param request is the Request object
+     * @param cake is the data generated in processRequest
+     * @returns the outcome of the phase
+     *
+     * @note Override this instead of validateRequest to reject requests without throwing
+     */
+    virtual pizza::endpoint::Outcome tryValidateRequest(const Request& request, Cake& cake) const
+    {
+        validateRequest(request, cake);
+        return Outcome::ok();
+    }
+
+    /** Process the request, prepare for the response, without throwing
+     *
+     * @param request is the Request object
+     * @param cake is the data generated in processRequest
+     * @returns the outcome of the phase
+     *
+     * @note Override this instead of processRequest to fail requests without throwing
+     */
+    virtual pizza::endpoint::Outcome tryProcessRequest(const Request& request, Cake& cake) const
+    {
+        processRequest(request, cake);
+        return Outcome::ok();
+    }
+
     /** Send the response
      *
      * @param cake is the data generated in processRequest
@@ -72,90 +111,508 @@ class Handler
     /// Allow Handler::Cake alias to pizza::endpoint::Cake
     using Cake = pizza::endpoint::Cake;
 
+    /// Allow Handler::Outcome alias to pizza::endpoint::Outcome
+    using Outcome = pizza::endpoint::Outcome;
+
+    /// Indicates whether the phases of a handler may block
+    enum class IsBlocking : bool
+    {
+        No,  ///< Phases run inline on the Pistache reactor thread
+        Yes  ///< Phases run on the Worker Pool, the response is sent asynchronously
+    };
+
     /// The API description
     struct ApiDesc
     {
         const Request::Method requestMethod;  ///< Represents the request method
         const std::string_view requestPath;   ///< Represents the request path
+        const ConcurrencyLimiter::Options concurrencyLimit{};  ///< Represents the limiter options
+        const RateLimiter::Options rateLimit{};  ///< Represents the per-client rate limiter options
+        const bool singleFlight{false};  ///< Represents whether identical GETs share one run
+        const ResponseCache::Options cache{};  ///< Represents the response cache options
+        const std::chrono::milliseconds deadline{0};  ///< Represents the time budget, zero for none
     };
 
     /** Handle the request
      *
      * @param request is the Pistache::Http::Request object
      * @param response is the Pistache::Http::ResponseWriter object
+     * @param route is the route the request is for
      */
-    void handleRequest(const Pistache::Rest::Request& request,
-                       Pistache::Http::ResponseWriter response) noexcept
+    void handleRequest(const Pistache::Http::Request& request,
+                       Pistache::Http::ResponseWriter response, const Route& route) noexcept
     {
-        const Request request_{request};
-        Response response_{response};
-        Cake cake;
+        route.getMetrics().start();
+        if (Lifecycle::getLifecycle().isDraining())
+        {
+            // Clients move over to the successor, or elsewhere, once their request is done
+            response.headers().addRaw(Pistache::Http::Header::Raw{"Connection", "close"});
+        }
+        if (!route.getRateLimiter().tryAcquire(request))
+        {
+            return limitRate(response, route);
+        }
 
-        try
+        // Fresh responses are sent from the cache, without running any phase
+        Keys keys;
+        if (route.getCache().isEnabled(request))
         {
-            validateRequest(request_, cake);
+            keys.cache = route.getCache().makeKey(request);
+            if (const auto entry = route.getCache().find(keys.cache))
+            {
+                return sendCached(request, response, route, *entry);
+            }
         }
-        catch (const ErrorResponse& e)
+
+        // Followers neither run the handler nor take a slot of the concurrency limiter
+        if (route.getSingleFlight().isEnabled(request))
         {
-            response_.send(e.getCode(), e.getCake());
-            m_log.error("ErrorResponse caught: {}", e.what());
-            return;
+            // Requests which differ by a header the cache varies on cannot share a response either
+            keys.flight = keys.cache.empty() ? SingleFlight::makeKey(request) : keys.cache;
+            if (route.getSingleFlight().join(keys.flight, response))
+            {
+                return;
+            }
         }
-        catch (const std::runtime_error& e)
+        if (!route.getLimiter().tryAcquire())
         {
-            response_.send(Response::Code::Bad_Request, "Bad Request");
-            m_log.error("std::runtime_error caught: {}", e.what());
-            return;
+            for (auto& waiter : route.getSingleFlight().land(keys.flight))
+            {
+                shed(waiter, route);
+            }
+            return shed(response, route);
         }
-        catch (const std::invalid_argument& e)
+
+        const auto started = ConcurrencyLimiter::Clock::now();
+        auto deadline = makeDeadline(request, route);
+        if (m_isBlocking == IsBlocking::No)
         {
-            response_.send(Response::Code::Bad_Request, "Bad Request");
-            m_log.error("std::invalid_argument caught: {}", e.what());
-            return;
+            return runRequest(request, response, route, started, keys, std::move(deadline));
         }
-        catch (const std::logic_error& e)
+
+        // Pistache only lends the request for the duration of this call, so the phases running on
+        // the Worker Pool get their own copy, and the response writer is moved along with it
+        using Pending = std::pair<Pistache::Http::Request, Pistache::Http::ResponseWriter>;
+        auto pending = std::make_shared<Pending>(request, std::move(response));
+        WorkerPool::getWorkerPool().submit(
+            [this, pending, &route, started, keys = std::move(keys), deadline = std::move(deadline)]
+            { runRequest(pending->first, pending->second, route, started, keys, deadline); });
+    }
+
+    /** Handle the request in-process, capturing the response rather than sending it
+     *
+     * @param request is the Pistache::Http::Request object
+     * @param route is the route the request is for
+     * @param client is the request which carried this one in, whose client the rate limiter of
+     * the route charges
+     * @param clientDeadline is the deadline of the request which carried this one in, which this
+     * one cannot outlive
+     * @returns the captured response
+     *
+     * @note The phases run on the calling thread
+     */
+    [[nodiscard]] Response::Captured handleCaptured(const Pistache::Http::Request& request,
+                                                    const Route& route,
+                                                    const Pistache::Http::Request& client,
+                                                    const Deadline& clientDeadline) const noexcept
+    {
+        route.getMetrics().start();
+        Response::Captured captured;
+        Response response{captured};
+
+        // The request carries neither the address nor the headers its client is told apart by
+        if (!route.getRateLimiter().tryAcquire(client))
         {
-            response_.send(Response::Code::Bad_Request, "Bad Request");
-            m_log.error("std::logic_error caught: {}", e.what());
-            return;
+            limitRate(response, route);
+            return captured;
         }
-        catch (const std::exception& e)
+        if (!route.getLimiter().tryAcquire())
         {
-            response_.send(Response::Code::Bad_Request, "Bad Request");
-            m_log.error("std::exception caught: {}", e.what());
+            shed(response, route);
+            return captured;
+        }
+
+        runRequest(request, response, route, ConcurrencyLimiter::Clock::now(),
+                   Deadline::earlier(makeDeadline(request, route), clientDeadline));
+        return captured;
+    }
+
+    /** Handle the request in-process as it would be handled off a connection, capturing the
+     * response rather than sending it
+     *
+     * @param request is the Pistache::Http::Request object
+     * @param route is the route the request is for
+     * @returns the captured response
+     *
+     * @note Everything handleRequest does is done, the response cache and the Worker Pool
+     * included, but for single flight, which only ever holds on to Pistache response writers, and
+     * for the response writer itself, hence nothing but the handler and the wrappers is measured
+     */
+    [[nodiscard]] Response::Captured handleInProcess(const Pistache::Http::Request& request,
+                                                     const Route& route) const noexcept
+    {
+        route.getMetrics().start();
+        Response::Captured captured;
+        Response response{captured};
+        if (!route.getRateLimiter().tryAcquire(request))
+        {
+            limitRate(response, route);
+            return captured;
+        }
+
+        std::string cacheKey;
+        if (route.getCache().isEnabled(request))
+        {
+            cacheKey = route.getCache().makeKey(request);
+            if (const auto entry = route.getCache().find(cacheKey))
+            {
+                route.getMetrics().finish(entry->response.code);
+                return entry->response;
+            }
+        }
+        if (!route.getLimiter().tryAcquire())
+        {
+            shed(response, route);
+            return captured;
+        }
+
+        const auto started = ConcurrencyLimiter::Clock::now();
+        auto deadline = makeDeadline(request, route);
+        if (m_isBlocking == IsBlocking::No)
+        {
+            runRequest(request, response, route, started, std::move(deadline));
+        }
+        else
+        {
+            // The calling thread waits, like the reactor thread would not, for the phases to run
+            std::latch hasRun{1};
+            WorkerPool::getWorkerPool().submit(
+                [this, &request, &response, &route, started, &deadline, &hasRun]
+                {
+                    runRequest(request, response, route, started, std::move(deadline));
+                    hasRun.count_down();
+                });
+            hasRun.wait();
+        }
+
+        if (!cacheKey.empty())
+        {
+            static_cast<void>(route.getCache().store(cacheKey, captured));
+        }
+        return captured;
+    }
+
+   private:
+    /// Represents the keys the response to a request is shared by, empty if it is not shared
+    struct Keys final
+    {
+        std::string cache;   ///< Represents the key of the response cache
+        std::string flight;  ///< Represents the key of the flight the request leads
+    };
+
+    /** Run the request
+     *
+     * @param request is the Pistache::Http::Request object
+     * @param response is the Pistache::Http::ResponseWriter object
+     * @param route is the route the request is for
+     * @param started is when the request was let in
+     * @param keys are the keys the response is shared by
+     * @param deadline is the deadline of the request
+     */
+    void runRequest(const Pistache::Http::Request& request,
+                    Pistache::Http::ResponseWriter& response, const Route& route,
+                    const ConcurrencyLimiter::Clock::time_point started, const Keys& keys,
+                    Deadline deadline) const noexcept
+    {
+        if (keys.cache.empty() && keys.flight.empty())
+        {
+            Response response_{response};
+            return runRequest(request, response_, route, started, std::move(deadline));
+        }
+
+        // The response is serialized once, sent as it is to every request of the flight, and kept
+        // for the requests to come
+        Response::Captured captured;
+        Response response_{captured};
+        runRequest(request, response_, route, started, std::move(deadline));
+
+        // Followers cannot be left hanging, even by a handler which sends no response
+        response_.send(Response::Code::Internal_Server_Error, Response::k_ServerError);
+
+        const auto entry =
+            keys.cache.empty() ? nullptr : route.getCache().store(keys.cache, captured);
+        const auto etag = (entry == nullptr) ? std::string_view{} : std::string_view{entry->etag};
+        sendCaptured(response, captured, etag);
+        for (auto& waiter : route.getSingleFlight().land(keys.flight))
+        {
+            sendCaptured(waiter, captured, etag);
+            route.getMetrics().finish(captured.code);
+        }
+    }
+
+    /** Send a cached response, or 304 Not Modified if the client has it already
+     *
+     * @param request is the Pistache::Http::Request object
+     * @param response is the Pistache::Http::ResponseWriter object
+     * @param route is the route the request is for
+     * @param entry is the cached response
+     */
+    static void sendCached(const Pistache::Http::Request& request,
+                           Pistache::Http::ResponseWriter& response, const Route& route,
+                           const ResponseCache::Entry& entry) noexcept
+    {
+        if (const auto ifNoneMatch = request.headers().tryGetRaw("If-None-Match");
+            !ifNoneMatch.isEmpty() && ResponseCache::isMatch(ifNoneMatch.get().value(), entry.etag))
+        {
+            static constexpr auto k_Code = Response::Code::Not_Modified;
+
+            // Along with the ETag, whatever the response varies by, as a 200 would have said
+            for (const auto& [name, value] : entry.response.headers)
+            {
+                if (name == "Vary")
+                {
+                    response.headers().addRaw(Pistache::Http::Header::Raw{name, value});
+                }
+            }
+            response.headers().addRaw(Pistache::Http::Header::Raw{"ETag", entry.etag});
+            response.send(k_Code);
+            route.getMetrics().finish(k_Code);
             return;
         }
 
+        sendCaptured(response, entry.response, entry.etag);
+        route.getMetrics().finish(entry.response.code);
+    }
+
+    /** Send a captured response, along with its headers
+     *
+     * @param response is the Pistache::Http::ResponseWriter object
+     * @param captured is the captured response
+     * @param etag is the ETag of the response, empty if it has none
+     */
+    static void sendCaptured(Pistache::Http::ResponseWriter& response,
+                             const Response::Captured& captured,
+                             const std::string_view etag) noexcept
+    {
+        const auto& [code, mediaType, body, headers] = captured;
+        for (const auto& [name, value] : headers)
+        {
+            response.headers().addRaw(Pistache::Http::Header::Raw{name, value});
+        }
+        if (!etag.empty())
+        {
+            response.headers().addRaw(Pistache::Http::Header::Raw{"ETag", std::string{etag}});
+        }
+        response.send(code, body.data(), body.size(), mediaType);
+    }
+
+    /** Run the request
+     *
+     * @param request is the Pistache::Http::Request object
+     * @param response is the Response object
+     * @param route is the route the request is for
+     * @param started is when the request was let in
+     * @param deadline is the deadline of the request
+     */
+    void runRequest(const Pistache::Http::Request& request, Response& response, const Route& route,
+                    const ConcurrencyLimiter::Clock::time_point started,
+                    Deadline deadline) const noexcept
+    {
+        const Request request_{request, route.getPath(), std::move(deadline)};
+        response.setEncoding(request_.getAcceptedEncoding());
+        Cake cake;
+
+        runPhases(request_, response, cake, route.getMetrics());
+        route.getMetrics().finish(response.getCode());
+        route.getLimiter().release(ConcurrencyLimiter::Clock::now() - started);
+    }
+
+    /** Shed the request, before any of its phases runs
+     *
+     * @param response is the Pistache::Http::ResponseWriter object
+     * @param route is the route the request is for
+     */
+    static void shed(Pistache::Http::ResponseWriter& response, const Route& route) noexcept
+    {
+        static constexpr auto k_Code = Response::Code::Service_Unavailable;
+
+        response.headers().addRaw(Pistache::Http::Header::Raw{"Retry-After", "1"});
+        response.send(k_Code, Response::k_ServiceUnavailable.data(),
+                      Response::k_ServiceUnavailable.size());
+        route.getMetrics().finish(k_Code);
+    }
+
+    /** Reject the request of a client over its rate limit, before any of its phases runs
+     *
+     * @param response is the Pistache::Http::ResponseWriter object
+     * @param route is the route the request is for
+     */
+    static void limitRate(Pistache::Http::ResponseWriter& response, const Route& route) noexcept
+    {
+        static constexpr auto k_Code = Response::Code::Too_Many_Requests;
+
+        const auto retryAfter = route.getRateLimiter().getRetryAfter();
+        response.headers().addRaw(
+            Pistache::Http::Header::Raw{"Retry-After", std::string{retryAfter}});
+        response.send(k_Code, Response::k_TooManyRequests.data(),
+                      Response::k_TooManyRequests.size());
+        route.getMetrics().finish(k_Code);
+    }
+
+    /** Shed the request handled in-process, before any of its phases runs
+     *
+     * @param response is the Response object, which captures the response
+     * @param route is the route the request is for
+     */
+    static void shed(Response& response, const Route& route) noexcept
+    {
+        static constexpr auto k_Code = Response::Code::Service_Unavailable;
+
+        response.setHeader("Retry-After", "1");
+        response.send(k_Code, Response::k_ServiceUnavailable);
+        route.getMetrics().finish(k_Code);
+    }
+
+    /** Reject the request handled in-process of a client over its rate limit, before any of its
+     * phases runs
+     *
+     * @param response is the Response object, which captures the response
+     * @param route is the route the request is for
+     */
+    static void limitRate(Response& response, const Route& route) noexcept
+    {
+        static constexpr auto k_Code = Response::Code::Too_Many_Requests;
+
+        response.setHeader("Retry-After", route.getRateLimiter().getRetryAfter());
+        response.send(k_Code, Response::k_TooManyRequests);
+        route.getMetrics().finish(k_Code);
+    }
+
+    /** Run the phases of the handler
+     *
+     * @param request is the Request object
+     * @param response is the Response object
+     * @param cake is the Cake object
+     * @param metrics are the metrics of the route, which every phase is recorded into
+     */
+    void runPhases(const Request& request, Response& response, Cake& cake,
+                   RouteMetrics& metrics) const noexcept
+    {
+        // The deadline is checked in between phases, nobody waits for what comes after it
+        if (request.getDeadline().isExpired())
+        {
+            return timeOut(response);
+        }
+
         try
         {
-            processRequest(request_, cake);
-            sendResponse(cake, response_);
+            PhaseTimer timer{metrics, Phase::Validate};
+            if (const auto outcome = tryValidateRequest(request, cake); !outcome)
+            {
+                timer.next(Phase::Send);
+                return reject(outcome, response);
+            }
         }
         catch (const ErrorResponse& e)
         {
-            response_.send(e.getCode(), e.getCake());
-            m_log.error("ErrorResponse caught: {}", e.what());
+            response.send(e.getCode(), e.getCake());
+            m_log.error<"ErrorResponse caught: {}">(e.what());
+            return;
+        }
+        catch (const std::exception& e)
+        {
+            response.send(Response::Code::Bad_Request, Response::k_BadRequest);
+            m_log.error<"std::exception caught: {}">(e.what());
+            return;
         }
-        catch (const std::runtime_error& e)
+        if (request.getDeadline().isExpired())
         {
-            response_.send(Response::Code::Internal_Server_Error, "Server Error");
-            m_log.error("std::runtime_error caught: {}", e.what());
+            return timeOut(response);
         }
-        catch (const std::invalid_argument& e)
+
+        try
         {
-            response_.send(Response::Code::Internal_Server_Error, "Server Error");
-            m_log.error("std::invalid_argument caught: {}", e.what());
+            PhaseTimer timer{metrics, Phase::Process};
+            const auto outcome = tryProcessRequest(request, cake);
+            timer.next(Phase::Send);
+            if (!outcome)
+            {
+                return reject(outcome, response);
+            }
+            if (request.getDeadline().isExpired())
+            {
+                return timeOut(response);
+            }
+            sendResponse(cake, response);
         }
-        catch (const std::logic_error& e)
+        catch (const ErrorResponse& e)
         {
-            response_.send(Response::Code::Internal_Server_Error, "Server Error");
-            m_log.error("std::logic_error caught: {}", e.what());
+            response.send(e.getCode(), e.getCake());
+            m_log.error<"ErrorResponse caught: {}">(e.what());
         }
         catch (const std::exception& e)
         {
-            response_.send(Response::Code::Internal_Server_Error, "Server Error");
-            m_log.error("std::exception caught: {}", e.what());
+            response.send(Response::Code::Internal_Server_Error, Response::k_ServerError);
+            m_log.error<"std::exception caught: {}">(e.what());
+        }
+    }
+
+    /** Reject the request with a failed outcome
+     *
+     * @param outcome is the failed outcome
+     * @param response is the Response object
+     */
+    void reject(const Outcome& outcome, Response& response) const noexcept
+    {
+        outcome.sendTo(response);
+
+        // Rejecting a bad request is business as usual, failing to serve a good one is not
+        const auto code = static_cast<int>(outcome.getCode());
+        if (code >= 500)
+        {
+            return m_log.warn<"Outcome failed with code {}">(code);
         }
+        m_log.debug<"Outcome failed with code {}">(code);
+    }
+
+    /** Give up on the request, its deadline has expired
+     *
+     * @param response is the Response object
+     */
+    void timeOut(Response& response) const noexcept
+    {
+        response.send(Response::Code::Gateway_Timeout, Response::k_GatewayTimeout);
+        m_log.warn<"Deadline expired, gave up on the request">();
+    }
+
+    /** Make the deadline of a request
+     *
+     * @param request is the Pistache::Http::Request object
+     * @param route is the route the request is for
+     * @returns the deadline, after the budget of the route or the one the client asks for in
+     * milliseconds with the X-Request-Timeout header, whichever is shorter
+     *
+     * @note A budget of zero asked for by the client is ignored, rather than lifting the budget of
+     * the route
+     */
+    [[nodiscard]] static Deadline makeDeadline(const Pistache::Http::Request& request,
+                                               const Route& route) noexcept
+    {
+        auto budget = route.getDeadline();
+        if (const auto header = request.headers().tryGetRaw("X-Request-Timeout");
+            !header.isEmpty())
+        {
+            const auto& value = header.get().value();
+            uint32_t milliseconds = 0;
+            const auto [last, errorCode] =
+                std::from_chars(value.data(), value.data() + value.size(), milliseconds);
+            if (errorCode == std::errc{} && milliseconds > 0 &&
+                (budget.count() == 0 || budget.count() > milliseconds))
+            {
+                budget = std::chrono::milliseconds{milliseconds};
+            }
+        }
+        return (budget.count() > 0) ? Deadline::after(budget) : Deadline{};
     }
 
    protected:
@@ -163,10 +620,24 @@ class Handler
      *
      * @param name is the name of this handler
      */
-    explicit Handler(const std::string_view name) noexcept : m_log{name} {}
+    explicit Handler(const std::string_view name) noexcept : Handler{name, IsBlocking::No} {}
+
+    /** Constructor
+     *
+     * @param name is the name of this handler
+     * @param isBlocking indicates whether the phases of this handler may block
+     */
+    explicit Handler(const std::string_view name, const IsBlocking isBlocking) noexcept
+        : m_log{name}, m_isBlocking{isBlocking}
+    {
+    }
 
     /// The Logger
     const pizza::log::Logger m_log;
+
+   private:
+    /// Indicates whether the phases of this handler may block
+    const IsBlocking m_isBlocking;
 };
 
 }  // namespace pizza::endpoint
@@ -0,0 +1,161 @@
+/**
+ * @file pizza/endpoint/histogram.h
+ * @brief The latency Histogram
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The latency Histogram
+ *
+ * @brief
+ * The Histogram counts durations into log-linear buckets, the same way HDR histograms do: every
+ * power of two is split into a few linear sub-buckets, so that the relative error stays the same
+ * from nanoseconds up to seconds, while recording costs one bucket lookup and one atomic add
+ *
+ * @note
+ * Histograms are meant to be written by one thread (or a few) and read by a scraping thread,
+ * hence they only promise that every count is eventually seen, not a consistent snapshot
+ */
+class Histogram final
+{
+    DEFAULT_DESTRUCTIBLE_FINAL_CLASS(Histogram)
+
+   public:
+    /// Represents how many sub-buckets, as a power of two, every power of two is split into
+    static constexpr size_t k_SubBucketBits{3};
+
+    /// Represents the largest power of two of nanoseconds being told apart (2^35ns = 34s)
+    static constexpr size_t k_MaxExponent{35};
+
+    /// Represents the number of buckets
+    static constexpr size_t k_Buckets{(k_MaxExponent - k_SubBucketBits + 2) << k_SubBucketBits};
+
+    /// Represents the counts of a histogram
+    struct Counts final
+    {
+        std::array<uint64_t, k_Buckets> buckets{};  ///< Represents the counts of each bucket
+        uint64_t sum{0};                            ///< Represents the sum of durations in ns
+
+        /** Get the total count
+         *
+         * @returns the total count
+         */
+        [[nodiscard]] uint64_t total() const noexcept
+        {
+            return std::accumulate(buckets.begin(), buckets.end(), uint64_t{0});
+        }
+
+        /** Get the count of durations shorter than a power of two of nanoseconds
+         *
+         * @param exponent is the power of two, from k_SubBucketBits up to k_MaxExponent
+         * @returns the count of durations shorter than 2^exponent ns
+         */
+        [[nodiscard]] uint64_t below(const size_t exponent) const noexcept
+        {
+            const auto end = buckets.begin() + static_cast<ptrdiff_t>(bucketOf(1ULL << exponent));
+            return std::accumulate(buckets.begin(), end, uint64_t{0});
+        }
+
+        /** Get a quantile
+         *
+         * @param quantile is the quantile, between 0 and 1
+         * @returns the duration in nanoseconds, as the upper bound of its bucket
+         */
+        [[nodiscard]] uint64_t quantile(const double_t quantile) const noexcept
+        {
+            const auto rank = static_cast<uint64_t>(std::ceil(quantile * total()));
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < k_Buckets; ++bucket)
+            {
+                seen += buckets.at(bucket);
+                if (seen >= rank && seen > 0)
+                {
+                    return lowerBoundOf(bucket + 1);
+                }
+            }
+            return 0;
+        }
+    };
+
+    /// Constructor
+    explicit Histogram() noexcept = default;
+
+    /** Record a duration
+     *
+     * @param duration is the duration
+     */
+    void record(const std::chrono::nanoseconds duration) noexcept
+    {
+        const auto nanoseconds = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+        m_buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    /** Add the counts of this histogram to others
+     *
+     * @param counts are the counts to add to
+     */
+    void mergeInto(Counts& counts) const noexcept
+    {
+        for (size_t bucket = 0; bucket < k_Buckets; ++bucket)
+        {
+            counts.buckets.at(bucket) += m_buckets.at(bucket).load(std::memory_order_relaxed);
+        }
+        counts.sum += m_sum.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /** Get the bucket of a duration
+     *
+     * @param nanoseconds is the duration in nanoseconds
+     * @returns the bucket index, durations beyond the range fall into the last bucket
+     */
+    [[nodiscard]] static constexpr size_t bucketOf(const uint64_t nanoseconds) noexcept
+    {
+        constexpr uint64_t k_SubBuckets = 1ULL << k_SubBucketBits;
+        if (nanoseconds < k_SubBuckets)
+        {
+            return nanoseconds;
+        }
+
+        const auto exponent = static_cast<size_t>(std::bit_width(nanoseconds)) - 1;
+        if (exponent > k_MaxExponent)
+        {
+            return k_Buckets - 1;
+        }
+        const auto shift = exponent - k_SubBucketBits;
+        return ((shift + 1) << k_SubBucketBits) + ((nanoseconds >> shift) - k_SubBuckets);
+    }
+
+    /** Get the lower bound of a bucket
+     *
+     * @param bucket is the bucket index
+     * @returns the shortest duration in nanoseconds falling into the bucket
+     */
+    [[nodiscard]] static constexpr uint64_t lowerBoundOf(const size_t bucket) noexcept
+    {
+        constexpr uint64_t k_SubBuckets = 1ULL << k_SubBucketBits;
+        if (bucket < k_SubBuckets)
+        {
+            return bucket;
+        }
+
+        const auto shift = (bucket >> k_SubBucketBits) - 1;
+        return (k_SubBuckets + (bucket & (k_SubBuckets - 1))) << shift;
+    }
+
+    /// The counts of each bucket
+    std::array<std::atomic<uint64_t>, k_Buckets> m_buckets{};
+
+    /// The sum of durations in nanoseconds
+    std::atomic<uint64_t> m_sum{0};
+};
+
+}  // namespace pizza::endpoint
@@ -0,0 +1,91 @@
+/**
+ * @file pizza/endpoint/json_writer.h
+ * @brief Writes JSON straight into a buffer
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/json_escape.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * Packages together the functions writing JSON values into a buffer
+ *
+ * This class is not meant to be constructed, but to hide some details
+ */
+class JsonWriter final
+{
+    STATIC_CLASS(JsonWriter)
+
+   public:
+    /// Represents the buffer being written to
+    using Buffer = fmt::memory_buffer;
+
+    /** Write a string as JSON
+     *
+     * @param buffer is the buffer to append to
+     * @param string is the string
+     */
+    static void writeString(Buffer& buffer, const std::string_view string) noexcept
+    {
+        json_escape::JsonEscape::writeString(buffer, string);
+    }
+
+    /** Write a value as JSON
+     *
+     * @tparam Type is the type of value
+     * @param buffer is the buffer to append to
+     * @param value is the value
+     */
+    template <typename Type>
+    static void writeValue(Buffer& buffer, const Type& value) noexcept
+    {
+        if constexpr (std::is_same_v<Type, std::nullptr_t>)
+        {
+            buffer.append(k_Null);
+        }
+        else if constexpr (std::is_same_v<Type, bool>)
+        {
+            buffer.append(value ? k_True : k_False);
+        }
+        else if constexpr (std::is_floating_point_v<Type>)
+        {
+            // JSON has no representation of infinity and NaN, same as what json does
+            if (!std::isfinite(value))
+            {
+                buffer.append(k_Null);
+                return;
+            }
+            fmt::format_to(std::back_inserter(buffer), "{}", value);
+        }
+        else if constexpr (std::is_arithmetic_v<Type>)
+        {
+            fmt::format_to(std::back_inserter(buffer), "{}", value);
+        }
+        else if constexpr (std::is_convertible_v<const Type&, std::string_view>)
+        {
+            writeString(buffer, value);
+        }
+        else
+        {
+            const auto dumped = value.dump();
+            buffer.append(dumped);
+        }
+    }
+
+   private:
+    /// Represents the JSON null
+    static constexpr std::string_view k_Null{"null"};
+
+    /// Represents the JSON true
+    static constexpr std::string_view k_True{"true"};
+
+    /// Represents the JSON false
+    static constexpr std::string_view k_False{"false"};
+};
+
+}  // namespace pizza::endpoint
@@ -0,0 +1,368 @@
+/**
+ * @file pizza/endpoint/lifecycle.h
+ * @brief The Lifecycle of the serving process
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/posix/all.h>
+#include <pizza/endpoint/metrics.h>
+#include <pizza/log/logger.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Lifecycle
+ *
+ * @brief
+ * The Lifecycle takes care of signals, of draining requests before shutting down, and of handing
+ * the port over to a successor process on restart
+ *
+ * @details
+ * SIGTERM and SIGINT drain and shut down. SIGHUP turns SO_REUSEPORT on for the listeners, then
+ * spawns the same binary with the same arguments, which binds the same port alongside and tells
+ * when it is serving, and only then drains and shuts down, hence there is no moment where the
+ * port refuses connections. Listeners share their port with no one otherwise, so a second process
+ * started by mistake fails to bind rather than splitting the traffic.
+ */
+class Lifecycle final
+{
+    SINGLETON_CLASS(Lifecycle)
+
+   public:
+    /// Represents what the serving process should do next
+    enum class Next
+    {
+        Shutdown,  ///< Drain and shut down
+        Restart    ///< Hand over to a successor, then drain and shut down
+    };
+
+    /// Block the handled signals, to be called before any thread is spawned
+    void blockSignals() const noexcept
+    {
+        const auto signals = getSignals();
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    }
+
+    /** Wait for a signal
+     *
+     * @returns what the serving process should do next
+     */
+    [[nodiscard]] Next waitForSignal() const noexcept
+    {
+        const auto signals = getSignals();
+        int signal = 0;
+        while (sigwait(&signals, &signal) != 0)
+        {
+        }
+        m_log.info("Received signal {}", signal);
+        return (signal == SIGHUP) ? Next::Restart : Next::Shutdown;
+    }
+
+    /** Is this process a successor?
+     *
+     * @returns true if a predecessor is waiting for this process to serve, otherwise false
+     *
+     * @note This holds only until the predecessor is notified
+     */
+    [[nodiscard]] bool isSuccessor() const noexcept
+    {
+        return std::getenv(k_ReadyFd.data()) != nullptr;
+    }
+
+    /** Find the sockets listening on a port
+     *
+     * @param port is the port
+     * @returns the file descriptors of the sockets
+     */
+    [[nodiscard]] static std::vector<int> findListeners(const uint16_t port) noexcept
+    {
+        std::vector<int> listeners;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator{"/proc/self/fd", error})
+        {
+            const auto fd = std::atoi(entry.path().filename().c_str());
+            if (isListeningOn(fd, port))
+            {
+                listeners.emplace_back(fd);
+            }
+        }
+        return listeners;
+    }
+
+    /// Tell the predecessor, if there is one, that this process is serving
+    void notifyReady() const noexcept
+    {
+        const auto* const readyFd = std::getenv(k_ReadyFd.data());
+        if (readyFd == nullptr)
+        {
+            return;
+        }
+
+        const auto fd = std::atoi(readyFd);
+        static constexpr char k_Ready = 1;
+        if (write(fd, &k_Ready, sizeof(k_Ready)) != sizeof(k_Ready))
+        {
+            m_log.warn("Failed to notify the predecessor");
+        }
+        close(fd);
+        unsetenv(k_ReadyFd.data());
+    }
+
+    /** Spawn a successor, and wait until it is serving
+     *
+     * @param listeners are the sockets this process listens on, which the successor binds alongside
+     * @param timeout is how long to wait for the successor
+     * @returns true if the successor is serving, otherwise false
+     */
+    [[nodiscard]] bool spawnSuccessor(const std::span<const int> listeners,
+                                      const std::chrono::milliseconds timeout) const noexcept
+    {
+        // The port is shared only from now on, which the kernel allows of a socket listening
+        // already, as the successor is the only process meant to bind it
+        static constexpr int k_IsShared = 1;
+        for (const auto fd : listeners)
+        {
+            if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &k_IsShared, sizeof(k_IsShared)) != 0)
+            {
+                m_log.error("Failed to share listener {} with the successor", fd);
+                return false;
+            }
+        }
+
+        std::array<int, 2> readyPipe{-1, -1};
+        if (pipe(readyPipe.data()) != 0)
+        {
+            m_log.error("Failed to create the pipe to the successor");
+            return false;
+        }
+        const auto [readEnd, writeEnd] = readyPipe;
+
+        // The successor is the binary at the path this process started from, which is the new one
+        // after a deploy, with the same arguments, only told where to notify
+        auto arguments = readCommandLine();
+        auto environment = readEnvironment();
+        environment.emplace_back(fmt::format("{}={}", k_ReadyFd, k_ReadyDescriptor));
+
+        // Neither the listeners nor the connections of this process may leak into the successor,
+        // hence they are closed in the child, since Pistache keeps opening them in this one
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        const auto isPrepared =
+            posix_spawn_file_actions_adddup2(&actions, writeEnd, k_ReadyDescriptor) == 0 &&
+            posix_spawn_file_actions_addclosefrom_np(&actions, k_ReadyDescriptor + 1) == 0;
+
+        const auto argv = toPointers(arguments);
+        const auto envp = toPointers(environment);
+        pid_t pid = 0;
+        const auto spawned = isPrepared && posix_spawn(&pid, m_executable.c_str(), &actions,
+                                                       nullptr, argv.data(), envp.data()) == 0;
+        posix_spawn_file_actions_destroy(&actions);
+        close(writeEnd);
+        if (!spawned)
+        {
+            close(readEnd);
+            m_log.error("Failed to spawn the successor");
+            return false;
+        }
+
+        pollfd readyPoll{.fd = readEnd, .events = POLLIN, .revents = 0};
+        char ready = 0;
+        const auto isReady = poll(&readyPoll, 1, static_cast<int>(timeout.count())) == 1 &&
+                             read(readEnd, &ready, sizeof(ready)) == sizeof(ready);
+        close(readEnd);
+        if (!isReady)
+        {
+            m_log.error("Successor {} is not serving after {}ms", pid, timeout.count());
+            return false;
+        }
+        m_log.info("Successor {} is serving", pid);
+        return true;
+    }
+
+    /** Stop accepting connections, while keeping the accepted ones
+     *
+     * @param listeners are the sockets to stop listening on
+     *
+     * @details
+     * Pistache neither exposes its listening sockets nor stops listening short of shutting down
+     * its reactor, which would drop the requests in flight, hence the listeners are the ones every
+     * Pistache endpoint opened when it bound, and each gets replaced with an unbound socket.
+     * Closing a listener takes it out of the epoll of Pistache and out of the SO_REUSEPORT group,
+     * and Pistache closes the unbound socket when it shuts down.
+     */
+    void stopListening(const std::span<const int> listeners) const noexcept
+    {
+        for (const auto fd : listeners)
+        {
+            const auto placeholder = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (placeholder < 0 || dup2(placeholder, fd) < 0)
+            {
+                m_log.error("Failed to stop listening on {}", fd);
+            }
+            close(placeholder);
+        }
+        m_log.info("Stopped {} listeners", listeners.size());
+    }
+
+    /** Drain the requests in flight
+     *
+     * @param timeout is how long to wait for them at most
+     */
+    void drain(const std::chrono::milliseconds timeout) noexcept
+    {
+        m_isDraining.store(true, std::memory_order_relaxed);
+
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        auto inFlight = Metrics::getMetrics().getInFlight();
+        while (inFlight > 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(k_DrainInterval);
+            inFlight = Metrics::getMetrics().getInFlight();
+        }
+
+        if (inFlight > 0)
+        {
+            m_log.warn("Gave up on {} requests in flight", inFlight);
+            return;
+        }
+        m_log.info("Drained all requests in flight");
+    }
+
+    /** Is the process draining?
+     *
+     * @returns true if the process is draining, in which case connections should not be kept
+     */
+    [[nodiscard]] bool isDraining() const noexcept
+    {
+        return m_isDraining.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /** Get the handled signals
+     *
+     * @returns the handled signals
+     */
+    [[nodiscard]] static sigset_t getSignals() noexcept
+    {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGTERM);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGHUP);
+        return signals;
+    }
+
+    /** Is the file descriptor a socket listening on a port?
+     *
+     * @param fd is the file descriptor
+     * @param port is the port
+     * @returns true if the file descriptor is a socket listening on the port, otherwise false
+     */
+    [[nodiscard]] static bool isListeningOn(const int fd, const uint16_t port) noexcept
+    {
+        int isListening = 0;
+        socklen_t size = sizeof(isListening);
+        if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &isListening, &size) != 0 ||
+            isListening == 0)
+        {
+            return false;
+        }
+
+        sockaddr_storage address{};
+        size = sizeof(address);
+        if (getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) != 0)
+        {
+            return false;
+        }
+        switch (address.ss_family)
+        {
+            case AF_INET:
+                return ntohs(reinterpret_cast<const sockaddr_in&>(address).sin_port) == port;
+            case AF_INET6:
+                return ntohs(reinterpret_cast<const sockaddr_in6&>(address).sin6_port) == port;
+            default:
+                return false;
+        }
+    }
+
+    /** Resolve the executable of this process, which /proc/self/exe stops pointing to the path of
+     * once the binary is replaced
+     *
+     * @returns the path of the executable
+     */
+    [[nodiscard]] static std::string readExecutable() noexcept
+    {
+        std::error_code error;
+        auto path = std::filesystem::read_symlink("/proc/self/exe", error);
+        return error ? std::string{"/proc/self/exe"} : path.string();
+    }
+
+    /** Read the command line of this process
+     *
+     * @returns the arguments
+     */
+    [[nodiscard]] static std::vector<std::string> readCommandLine() noexcept
+    {
+        std::ifstream stream{"/proc/self/cmdline", std::ios::binary};
+        std::vector<std::string> arguments;
+        for (std::string argument; std::getline(stream, argument, '\0');)
+        {
+            arguments.emplace_back(std::move(argument));
+        }
+        return arguments;
+    }
+
+    /** Read the environment of this process
+     *
+     * @returns the environment variables
+     */
+    [[nodiscard]] static std::vector<std::string> readEnvironment() noexcept
+    {
+        std::vector<std::string> environment;
+        for (auto* const* variable = environ; *variable != nullptr; ++variable)
+        {
+            environment.emplace_back(*variable);
+        }
+        return environment;
+    }
+
+    /** Get the pointers to strings, as exec wants them
+     *
+     * @param strings are the strings
+     * @returns the pointers, ending with nullptr
+     */
+    [[nodiscard]] static std::vector<char*> toPointers(std::vector<std::string>& strings) noexcept
+    {
+        std::vector<char*> pointers;
+        for (auto& string : strings)
+        {
+            pointers.emplace_back(string.data());
+        }
+        pointers.emplace_back(nullptr);
+        return pointers;
+    }
+
+    /// Represents the environment variable telling a successor where to notify its predecessor
+    static constexpr std::string_view k_ReadyFd{"PIZZA_READY_FD"};
+
+    /// Represents the file descriptor a successor notifies its predecessor through
+    static constexpr int k_ReadyDescriptor{STDERR_FILENO + 1};
+
+    /// Represents how often draining checks the requests in flight
+    static constexpr std::chrono::milliseconds k_DrainInterval{10};
+
+    /// The Logger
+    const pizza::log::Logger m_log{"lifecycle"};
+
+    /// The path of the executable, resolved when the process starts
+    const std::string m_executable{readExecutable()};
+
+    /// Indicates if the process is draining
+    std::atomic<bool> m_isDraining{false};
+};
+
+}  // namespace pizza::endpoint
@@ -0,0 +1,643 @@
+/**
+ * @file pizza/endpoint/metrics.h
+ * @brief The per-route Metrics
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/concurrency_limiter.h>
+#include <pizza/endpoint/histogram.h>
+#include <pizza/endpoint/rate_limiter.h>
+#include <pizza/endpoint/response_cache.h>
+#include <pizza/endpoint/request.h>
+#include <pizza/endpoint/response.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/// Represents a phase of request processing
+enum class Phase : size_t
+{
+    Validate,  ///< Represents validateRequest
+    Process,   ///< Represents processRequest
+    Send       ///< Represents sendResponse, or whatever sends the response instead
+};
+
+/**
+ * The Metrics of a route
+ *
+ * @brief
+ * Counts requests, in-flight requests and responses per status code, and records the latency of
+ * each phase into histograms
+ *
+ * @details
+ * Everything is kept in per-thread shards, which are allocated the first time a thread records
+ * anything, so that threads never write to the same cache lines. Shards are only merged when the
+ * metrics are scraped.
+ */
+class RouteMetrics final
+{
+    NOT_COPYABLE_CLASS(RouteMetrics)
+    IMMOVEABLE_CLASS(RouteMetrics)
+
+   public:
+    /// Represents every phase, in order
+    static constexpr std::array k_Phases{Phase::Validate, Phase::Process, Phase::Send};
+
+    /// Represents the counts of responses of a status code
+    using StatusCount = std::pair<Response::Code, uint64_t>;
+
+    /// Represents the merged metrics of a route
+    struct Snapshot final
+    {
+        uint64_t started{0};                                  ///< Represents requests
+        uint64_t finished{0};                                 ///< Represents finished requests
+        std::vector<StatusCount> statuses;                    ///< Represents responses
+        std::array<Histogram::Counts, k_Phases.size()> phases;  ///< Represents latencies
+        size_t concurrencyLimit{0};                           ///< Represents the limit, if any
+        uint64_t shed{0};                                     ///< Represents requests shed
+        std::optional<uint64_t> rateLimited;                  ///< Represents requests rejected
+        std::optional<uint64_t> cacheHits;                    ///< Represents cached responses
+        uint64_t cacheMisses{0};                              ///< Represents uncached responses
+    };
+
+    /** Constructor
+     *
+     * @param requestMethod is the request method
+     * @param requestPath is the request path
+     */
+    explicit RouteMetrics(const Request::Method requestMethod,
+                          const std::string_view requestPath) noexcept
+        : m_requestMethod{requestMethod}, m_requestPath{requestPath}
+    {
+    }
+
+    /// Destructor
+    ~RouteMetrics() noexcept
+    {
+        for (auto& shard : m_shards)
+        {
+            const std::unique_ptr<Shard> owned{shard.load(std::memory_order_acquire)};
+        }
+    }
+
+    /// Count a request which has started
+    void start() noexcept { getShard().started.fetch_add(1, std::memory_order_relaxed); }
+
+    /** Count a request which has finished
+     *
+     * @param code is the response code, if a response has been sent
+     */
+    void finish(const std::optional<Response::Code> code) noexcept
+    {
+        auto& shard = getShard();
+        shard.finished.fetch_add(1, std::memory_order_relaxed);
+        if (code)
+        {
+            shard.countStatus(*code);
+        }
+    }
+
+    /** Record how long a phase took
+     *
+     * @param phase is the phase
+     * @param duration is how long the phase took
+     */
+    void record(const Phase phase, const std::chrono::nanoseconds duration) noexcept
+    {
+        getShard().phases.at(static_cast<size_t>(phase)).record(duration);
+    }
+
+    /** Watch the concurrency limiter of the route
+     *
+     * @param limiter is the concurrency limiter, which must outlive the metrics
+     */
+    void watch(const ConcurrencyLimiter& limiter) noexcept { m_limiter = &limiter; }
+
+    /** Watch the rate limiter of the route
+     *
+     * @param rateLimiter is the rate limiter, which must outlive the metrics
+     */
+    void watch(const RateLimiter& rateLimiter) noexcept { m_rateLimiter = &rateLimiter; }
+
+    /** Watch the response cache of the route
+     *
+     * @param cache is the response cache, which must outlive the metrics
+     */
+    void watch(const ResponseCache& cache) noexcept { m_cache = &cache; }
+
+    /** Get the request method
+     *
+     * @returns the request method
+     */
+    [[nodiscard]] Request::Method getMethod() const noexcept { return m_requestMethod; }
+
+    /** Get the request path
+     *
+     * @returns the request path
+     */
+    [[nodiscard]] std::string_view getPath() const noexcept { return m_requestPath; }
+
+    /** Get the number of requests in flight
+     *
+     * @returns the number of requests which have started but not finished
+     */
+    [[nodiscard]] uint64_t getInFlight() const noexcept
+    {
+        uint64_t started = 0;
+        uint64_t finished = 0;
+        for (const auto& atomicShard : m_shards)
+        {
+            const auto* const shard = atomicShard.load(std::memory_order_acquire);
+            if (shard != nullptr)
+            {
+                started += shard->started.load(std::memory_order_relaxed);
+                finished += shard->finished.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Shards are read one after the other, hence finished may be ahead of started a bit
+        return started - std::min(started, finished);
+    }
+
+    /** Merge the shards
+     *
+     * @returns the merged metrics
+     */
+    [[nodiscard]] Snapshot snapshot() const noexcept
+    {
+        Snapshot result;
+        for (const auto& atomicShard : m_shards)
+        {
+            const auto* const shard = atomicShard.load(std::memory_order_acquire);
+            if (shard == nullptr)
+            {
+                continue;
+            }
+
+            result.started += shard->started.load(std::memory_order_relaxed);
+            result.finished += shard->finished.load(std::memory_order_relaxed);
+            for (const auto& [code, count] : shard->statuses)
+            {
+                const auto codeValue = code.load(std::memory_order_acquire);
+                if (codeValue == 0)
+                {
+                    break;
+                }
+                addStatus(result.statuses, static_cast<Response::Code>(codeValue),
+                          count.load(std::memory_order_relaxed));
+            }
+            for (size_t phase = 0; phase < result.phases.size(); ++phase)
+            {
+                shard->phases.at(phase).mergeInto(result.phases.at(phase));
+            }
+        }
+        std::sort(result.statuses.begin(), result.statuses.end());
+
+        if (m_limiter != nullptr && m_limiter->isEnabled())
+        {
+            result.concurrencyLimit = m_limiter->getLimit();
+            result.shed = m_limiter->getShed();
+        }
+        if (m_rateLimiter != nullptr && m_rateLimiter->isEnabled())
+        {
+            result.rateLimited = m_rateLimiter->getLimited();
+        }
+        if (m_cache != nullptr && m_cache->isEnabled())
+        {
+            result.cacheHits = m_cache->getHits();
+            result.cacheMisses = m_cache->getMisses();
+        }
+        return result;
+    }
+
+   private:
+    /// Represents how many status codes a shard tells apart, the rest are counted as the last one
+    static constexpr size_t k_StatusSlots{16};
+
+    /// Represents how many shards there are, threads beyond that share shards
+    static constexpr size_t k_Shards{64};
+
+    /// Represents the metrics recorded by a thread
+    struct Shard final
+    {
+        /// Represents the counts of responses of a status code, claimed on first use
+        using StatusSlot = std::pair<std::atomic<uint16_t>, std::atomic<uint64_t>>;
+
+        /** Count a response
+         *
+         * @param code is the response code
+         */
+        void countStatus(const Response::Code code) noexcept
+        {
+            const auto codeValue = static_cast<uint16_t>(code);
+            for (auto& [slotCode, count] : statuses)
+            {
+                auto current = slotCode.load(std::memory_order_acquire);
+                if (current == 0 && slotCode.compare_exchange_strong(current, codeValue))
+                {
+                    current = codeValue;
+                }
+                if (current == codeValue || &count == &statuses.back().second)
+                {
+                    count.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+
+        std::atomic<uint64_t> started{0};                  ///< Represents requests
+        std::atomic<uint64_t> finished{0};                 ///< Represents finished requests
+        std::array<StatusSlot, k_StatusSlots> statuses{};  ///< Represents responses
+        std::array<Histogram, k_Phases.size()> phases;     ///< Represents latencies
+    };
+
+    /** Get the shard of the calling thread
+     *
+     * @returns the shard
+     */
+    [[nodiscard]] Shard& getShard() noexcept
+    {
+        thread_local const size_t index = s_threads.fetch_add(1, std::memory_order_relaxed);
+
+        auto& atomicShard = m_shards[index % k_Shards];
+        auto* shard = atomicShard.load(std::memory_order_acquire);
+        if (shard == nullptr)
+        {
+            // Another thread sharing the shard may get there first, in which case theirs is used
+            auto fresh = std::make_unique<Shard>();
+            if (atomicShard.compare_exchange_strong(shard, fresh.get()))
+            {
+                shard = fresh.release();
+            }
+        }
+        return *shard;
+    }
+
+    /** Add the counts of a status code
+     *
+     * @param statuses are the counts of each status code
+     * @param code is the status code
+     * @param count is the count
+     */
+    static void addStatus(std::vector<StatusCount>& statuses, const Response::Code code,
+                          const uint64_t count) noexcept
+    {
+        const auto isSame = [code](const auto& status) { return status.first == code; };
+        const auto found = std::find_if(statuses.begin(), statuses.end(), isSame);
+        if (found != statuses.end())
+        {
+            found->second += count;
+            return;
+        }
+        statuses.emplace_back(code, count);
+    }
+
+    /// Assigns every thread its own shard index
+    inline static std::atomic<size_t> s_threads{0};
+
+    /// The request method
+    const Request::Method m_requestMethod;
+
+    /// The request path
+    const std::string_view m_requestPath;
+
+    /// The shards, allocated on first use
+    std::array<std::atomic<Shard*>, k_Shards> m_shards{};
+
+    /// The concurrency limiter of the route, if it is being watched
+    const ConcurrencyLimiter* m_limiter{nullptr};
+
+    /// The rate limiter of the route, if it is being watched
+    const RateLimiter* m_rateLimiter{nullptr};
+
+    /// The response cache of the route, if it is being watched
+    const ResponseCache* m_cache{nullptr};
+};
+
+/**
+ * Measures how long a phase takes
+ *
+ * @details
+ * The measured phase is recorded when the next one starts, or when the timer goes out of scope
+ */
+class PhaseTimer final
+{
+    NOT_COPYABLE_CLASS(PhaseTimer)
+    IMMOVEABLE_CLASS(PhaseTimer)
+
+   public:
+    /// Represents the clock measuring phases
+    using Clock = std::chrono::steady_clock;
+
+    /** Constructor
+     *
+     * @param metrics are the metrics of the route
+     * @param phase is the phase being measured
+     */
+    explicit PhaseTimer(RouteMetrics& metrics, const Phase phase) noexcept
+        : m_metrics{metrics}, m_phase{phase}, m_start{Clock::now()}
+    {
+    }
+
+    /// Destructor
+    ~PhaseTimer() noexcept { m_metrics.record(m_phase, Clock::now() - m_start); }
+
+    /** Record the measured phase and start measuring the next one
+     *
+     * @param phase is the next phase
+     */
+    void next(const Phase phase) noexcept
+    {
+        const auto now = Clock::now();
+        m_metrics.record(m_phase, now - m_start);
+        m_phase = phase;
+        m_start = now;
+    }
+
+   private:
+    /// The metrics of the route
+    RouteMetrics& m_metrics;
+
+    /// The phase being measured
+    Phase m_phase;
+
+    /// When the phase started
+    Clock::time_point m_start;
+};
+
+/**
+ * The Metrics
+ *
+ * @brief
+ * The Metrics keep the metrics of every route, and write them in the Prometheus text format
+ */
+class Metrics final
+{
+    SINGLETON_CLASS(Metrics)
+
+   public:
+    /// Represents the buffer being written to
+    using Buffer = fmt::memory_buffer;
+
+    /** Add the metrics of a route
+     *
+     * @param requestMethod is the request method
+     * @param requestPath is the request path
+     * @returns the metrics of the route, which live as long as the program does
+     */
+    [[nodiscard]] RouteMetrics& addRoute(const Request::Method requestMethod,
+                                         const std::string_view requestPath) noexcept
+    {
+        const std::scoped_lock lock{m_mutex};
+        return m_routes.emplace_back(requestMethod, requestPath);
+    }
+
+    /** Get the number of requests in flight
+     *
+     * @returns the number of requests in flight across every route
+     */
+    [[nodiscard]] uint64_t getInFlight() const noexcept
+    {
+        const std::scoped_lock lock{m_mutex};
+        uint64_t result = 0;
+        for (const auto& route : m_routes)
+        {
+            result += route.getInFlight();
+        }
+        return result;
+    }
+
+    /** Write the metrics of every route in the Prometheus text format
+     *
+     * @param buffer is the buffer to append to
+     */
+    void writeTo(Buffer& buffer) const noexcept
+    {
+        std::vector<std::pair<const RouteMetrics*, RouteMetrics::Snapshot>> snapshots;
+        {
+            const std::scoped_lock lock{m_mutex};
+            for (const auto& route : m_routes)
+            {
+                snapshots.emplace_back(&route, route.snapshot());
+            }
+        }
+
+        // Samples of a metric must be written together, hence every metric loops over the routes
+        writeHeader(buffer, "pizza_requests_total", "counter", "Requests received");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            writeSample(buffer, "pizza_requests_total", *route, {}, snapshot.started);
+        }
+
+        writeHeader(buffer, "pizza_requests_in_flight", "gauge", "Requests being processed");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            // Shards are read one after the other, hence finished may be ahead of started a bit
+            const auto inFlight = snapshot.started - std::min(snapshot.started, snapshot.finished);
+            writeSample(buffer, "pizza_requests_in_flight", *route, {}, inFlight);
+        }
+
+        writeHeader(buffer, "pizza_responses_total", "counter", "Responses sent per status code");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            for (const auto& [code, count] : snapshot.statuses)
+            {
+                const auto labels = fmt::format(R"(,code="{}")", static_cast<int>(code));
+                writeSample(buffer, "pizza_responses_total", *route, labels, count);
+            }
+        }
+
+        writeHeader(buffer, "pizza_concurrency_limit", "gauge", "Adaptive concurrency limit");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            if (snapshot.concurrencyLimit != 0)
+            {
+                writeSample(buffer, "pizza_concurrency_limit", *route, {},
+                            snapshot.concurrencyLimit);
+            }
+        }
+
+        writeHeader(buffer, "pizza_requests_shed_total", "counter",
+                    "Requests shed over the concurrency limit");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            if (snapshot.concurrencyLimit != 0)
+            {
+                writeSample(buffer, "pizza_requests_shed_total", *route, {}, snapshot.shed);
+            }
+        }
+
+        writeHeader(buffer, "pizza_requests_rate_limited_total", "counter",
+                    "Requests rejected over the per-client rate limit");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            if (snapshot.rateLimited)
+            {
+                writeSample(buffer, "pizza_requests_rate_limited_total", *route, {},
+                            *snapshot.rateLimited);
+            }
+        }
+
+        writeHeader(buffer, "pizza_cache_lookups_total", "counter",
+                    "Lookups of the response cache per result");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            if (snapshot.cacheHits)
+            {
+                writeSample(buffer, "pizza_cache_lookups_total", *route, R"(,result="hit")",
+                            *snapshot.cacheHits);
+                writeSample(buffer, "pizza_cache_lookups_total", *route, R"(,result="miss")",
+                            snapshot.cacheMisses);
+            }
+        }
+
+        writeHeader(buffer, "pizza_phase_duration_seconds", "histogram",
+                    "Latency of each phase of request processing");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            for (const auto phase : RouteMetrics::k_Phases)
+            {
+                writeHistogram(buffer, *route, phase,
+                               snapshot.phases.at(static_cast<size_t>(phase)));
+            }
+        }
+
+        writeHeader(buffer, "pizza_phase_duration_quantile_seconds", "gauge",
+                    "Quantiles of the latency of each phase, with HDR precision");
+        for (const auto& [route, snapshot] : snapshots)
+        {
+            for (const auto phase : RouteMetrics::k_Phases)
+            {
+                const auto& counts = snapshot.phases.at(static_cast<size_t>(phase));
+                for (const auto quantile : k_Quantiles)
+                {
+                    const auto labels = fmt::format(R"(,phase="{}",quantile="{}")",
+                                                    toLabel(phase), quantile);
+                    writeSample(buffer, "pizza_phase_duration_quantile_seconds", *route, labels,
+                                toSeconds(counts.quantile(quantile)));
+                }
+            }
+        }
+    }
+
+   private:
+    /** Write the header of a metric
+     *
+     * @param buffer is the buffer to append to
+     * @param name is the name of the metric
+     * @param type is the type of the metric
+     * @param help is the description of the metric
+     */
+    static void writeHeader(Buffer& buffer, const std::string_view name,
+                            const std::string_view type, const std::string_view help) noexcept
+    {
+        fmt::format_to(std::back_inserter(buffer), "# HELP {} {}\n# TYPE {} {}\n", name, help,
+                       name, type);
+    }
+
+    /** Write a sample of a metric
+     *
+     * @tparam Value is the type of value
+     * @param buffer is the buffer to append to
+     * @param name is the name of the metric
+     * @param route are the metrics of the route being sampled
+     * @param labels are the labels beyond the route ones, each starting with a comma
+     * @param value is the value
+     */
+    template <typename Value>
+    static void writeSample(Buffer& buffer, const std::string_view name, const RouteMetrics& route,
+                            const std::string_view labels, const Value value) noexcept
+    {
+        fmt::format_to(std::back_inserter(buffer), R"({}{{method="{}",path="{}"{}}} {})",
+                       name, magic_enum::enum_name(route.getMethod()),
+                       escapeLabel(route.getPath()), labels, value);
+        buffer.push_back('\n');
+    }
+
+    /** Write the histogram of a phase
+     *
+     * @param buffer is the buffer to append to
+     * @param route are the metrics of the route being sampled
+     * @param phase is the phase
+     * @param counts are the counts of the histogram
+     */
+    static void writeHistogram(Buffer& buffer, const RouteMetrics& route, const Phase phase,
+                               const Histogram::Counts& counts) noexcept
+    {
+        static constexpr std::string_view k_Bucket{"pizza_phase_duration_seconds_bucket"};
+
+        // Powers of two line up with bucket boundaries, hence these buckets are exact
+        for (auto exponent = k_MinExponent; exponent <= Histogram::k_MaxExponent; ++exponent)
+        {
+            const auto labels = fmt::format(R"(,phase="{}",le="{}")", toLabel(phase),
+                                            toSeconds(1ULL << exponent));
+            writeSample(buffer, k_Bucket, route, labels, counts.below(exponent));
+        }
+
+        const auto total = counts.total();
+        const auto phaseLabel = fmt::format(R"(,phase="{}")", toLabel(phase));
+        writeSample(buffer, k_Bucket, route, fmt::format(R"({},le="+Inf")", phaseLabel), total);
+        writeSample(buffer, "pizza_phase_duration_seconds_sum", route, phaseLabel,
+                    toSeconds(counts.sum));
+        writeSample(buffer, "pizza_phase_duration_seconds_count", route, phaseLabel, total);
+    }
+
+    /** Get the label of a phase
+     *
+     * @param phase is the phase
+     * @returns the label, e.g. "validate"
+     */
+    [[nodiscard]] static std::string_view toLabel(const Phase phase) noexcept
+    {
+        static constexpr std::array<std::string_view, RouteMetrics::k_Phases.size()> k_Labels{
+            "validate", "process", "send"};
+        return k_Labels.at(static_cast<size_t>(phase));
+    }
+
+    /** Convert nanoseconds into seconds
+     *
+     * @param nanoseconds is the duration in nanoseconds
+     * @returns the duration in seconds
+     */
+    [[nodiscard]] static double_t toSeconds(const uint64_t nanoseconds) noexcept
+    {
+        return static_cast<double_t>(nanoseconds) / 1e9;
+    }
+
+    /** Escape a label value
+     *
+     * @param value is the label value
+     * @returns the escaped label value
+     */
+    [[nodiscard]] static std::string escapeLabel(const std::string_view value) noexcept
+    {
+        std::string result;
+        result.reserve(value.size());
+        for (const auto character : value)
+        {
+            if (character == '\\' || character == '"')
+            {
+                result.push_back('\\');
+            }
+            result.push_back(character);
+        }
+        return result;
+    }
+
+    /// Represents the smallest power of two of nanoseconds written as a bucket (2^10ns = 1us)
+    static constexpr size_t k_MinExponent{10};
+
+    /// Represents the quantiles being written
+    static constexpr std::array k_Quantiles{0.5, 0.9, 0.99, 0.999};
+
+    /// The mutex guarding routes
+    mutable std::mutex m_mutex;
+
+    /// The metrics of every route, which never move once added
+    std::deque<RouteMetrics> m_routes;
+};
+
+}  // namespace pizza::endpoint
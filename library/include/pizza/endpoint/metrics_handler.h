@@ -0,0 +1,59 @@
+/**
+ * @file pizza/endpoint/metrics_handler.h
+ * @brief The built-in Metrics Handler
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/handler.h>
+#include <pizza/endpoint/metrics.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Metrics Handler
+ *
+ * @brief
+ * Serves the metrics of every route on GET /metrics, in the Prometheus text format
+ *
+ * @note
+ * This handler is optional, register it like any other handler to serve it:
+ * `pizza::endpoint::addHandler<pizza::endpoint::MetricsHandler>()`
+ */
+class MetricsHandler final : public Handler
+{
+   public:
+    static constexpr std::string_view k_Name = "metrics";
+
+    static constexpr auto k_ApiDesc = std::to_array<ApiDesc>({{Request::Method::Get, "/metrics"}});
+
+    /// Constructor
+    explicit MetricsHandler() noexcept : Handler{k_Name} {}
+
+   private:
+    Outcome tryValidateRequest(const Request& /* unused */, Cake& /* unused */) const override
+    {
+        return Outcome::ok();
+    }
+
+    Outcome tryProcessRequest(const Request& /* unused */, Cake& /* unused */) const override
+    {
+        return Outcome::ok();
+    }
+
+    void sendResponse(const Cake& /* unused */, Response& response) const override
+    {
+        thread_local Metrics::Buffer buffer;
+        buffer.clear();
+        Metrics::getMetrics().writeTo(buffer);
+
+        static const auto k_MediaType =
+            Pistache::Http::Mime::MediaType::fromString("text/plain; version=0.0.4");
+        response.sendAs(Response::Code::Ok, k_MediaType, {buffer.data(), buffer.size()});
+    }
+};
+
+}  // namespace pizza::endpoint
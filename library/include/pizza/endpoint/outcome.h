@@ -0,0 +1,128 @@
+/**
+ * @file pizza/endpoint/outcome.h
+ * @brief Represents the Outcome of a phase
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/cake.h>
+#include <pizza/endpoint/response.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * Represents the outcome of a phase
+ *
+ * @details
+ * This is the exception-free counterpart of ErrorResponse. A failed outcome carries the response
+ * code together with either a Cake or a pre-serialized body, and costs no more than returning it.
+ *
+ * @note
+ * Outcomes do not own what they carry, hence the Cake must be the one handed to the phase, and the
+ * pre-serialized body must outlive the request (e.g. a `static constexpr std::string_view`)
+ */
+class Outcome final
+{
+    DEFAULT_MOVEABLE_FINAL_CLASS(Outcome)
+
+   public:
+    /** Make a successful outcome
+     *
+     * @returns the successful outcome
+     */
+    [[nodiscard]] static Outcome ok() noexcept { return Outcome{Response::Code::Ok, {}}; }
+
+    /** Make a failed outcome
+     *
+     * @param code is the response code
+     * @param body is the pre-serialized response body
+     * @returns the failed outcome
+     */
+    [[nodiscard]] static Outcome fail(const Response::Code code,
+                                      const std::string_view body) noexcept
+    {
+        return Outcome{code, body};
+    }
+
+    /** Make a failed outcome
+     *
+     * @param code is the response code
+     * @param cake is the Cake object
+     * @returns the failed outcome
+     */
+    [[nodiscard]] static Outcome fail(const Response::Code code, const Cake& cake) noexcept
+    {
+        return Outcome{code, &cake};
+    }
+
+    /** Make a failed outcome with the generic Bad Request response
+     *
+     * @returns the failed outcome
+     */
+    [[nodiscard]] static Outcome badRequest() noexcept
+    {
+        return fail(Response::Code::Bad_Request, Response::k_BadRequest);
+    }
+
+    /** Make a failed outcome with the generic Server Error response
+     *
+     * @returns the failed outcome
+     */
+    [[nodiscard]] static Outcome serverError() noexcept
+    {
+        return fail(Response::Code::Internal_Server_Error, Response::k_ServerError);
+    }
+
+    /** Is the outcome successful?
+     *
+     * @returns true if the outcome is successful, otherwise false
+     */
+    [[nodiscard]] explicit operator bool() const noexcept
+    {
+        return std::holds_alternative<std::monostate>(m_body);
+    }
+
+    /** Get the response code
+     *
+     * @returns the response code
+     */
+    [[nodiscard]] Response::Code getCode() const noexcept { return m_code; }
+
+    /** Send the failed outcome as the response
+     *
+     * @param response is the Response object
+     */
+    void sendTo(Response& response) const noexcept
+    {
+        if (const auto* const body = std::get_if<std::string_view>(&m_body))
+        {
+            return response.send(m_code, *body);
+        }
+        if (const auto* const cake = std::get_if<const Cake*>(&m_body))
+        {
+            return response.send(m_code, **cake);
+        }
+    }
+
+   private:
+    /// Represents what the outcome carries, nothing if it is successful
+    using Body = std::variant<std::monostate, std::string_view, const Cake*>;
+
+    /** Constructor
+     *
+     * @param code is the response code
+     * @param body is what the outcome carries
+     */
+    explicit Outcome(const Response::Code code, Body body) noexcept : m_code{code}, m_body{body} {}
+
+    /// The response code
+    Response::Code m_code;
+
+    /// What the outcome carries
+    Body m_body;
+};
+
+}  // namespace pizza::endpoint
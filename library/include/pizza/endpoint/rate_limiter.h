@@ -0,0 +1,296 @@
+/**
+ * @file pizza/endpoint/rate_limiter.h
+ * @brief The per-client Rate Limiter
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/pistache/all.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Rate Limiter
+ *
+ * @brief
+ * The Rate Limiter gives every client of a route a token bucket, and rejects the requests of
+ * clients whose bucket is empty. Clients are told apart by their peer address, or by a header when
+ * the route sits behind something which sets one (e.g. X-Forwarded-For)
+ *
+ * @details
+ * Buckets live in a fixed-size open-addressed table, hence memory is bounded no matter how many
+ * clients there are. Every slot packs the refill time and the tokens into a single word updated
+ * with compare-and-swap, so the table takes no locks. A bucket which has refilled up to its burst
+ * is indistinguishable from a fresh one, hence such slots of idle clients are handed over to new
+ * clients, and only when every slot nearby is busy does the least recently used one get evicted.
+ */
+class RateLimiter final
+{
+    NOT_COPYABLE_CLASS(RateLimiter)
+    IMMOVEABLE_CLASS(RateLimiter)
+
+   public:
+    /// Represents the options of the limiter
+    struct Options final
+    {
+        double_t requestsPerSecond{0.0};  ///< Represents the quota, zero disables the limiter
+        uint32_t burst{0};                ///< Represents the bucket size, zero for one second worth
+        std::string_view keyHeader{};     ///< Represents the header telling clients apart, if any
+        size_t maxClients{4096};          ///< Represents how many clients are tracked at once
+    };
+
+    /** Constructor
+     *
+     * @param options are the options of the limiter
+     */
+    explicit RateLimiter(const Options& options) noexcept
+        : m_options{options},
+          m_burst{(options.burst != 0)
+                      ? options.burst
+                      : static_cast<uint32_t>(std::ceil(options.requestsPerSecond))},
+          m_tokensPerMillisecond{options.requestsPerSecond * k_TokenScale / 1000.0},
+          m_retryAfter{fmt::format("{}", static_cast<uint64_t>(
+                                             std::ceil(1.0 / std::max(options.requestsPerSecond,
+                                                                      k_MinRequestsPerSecond))))},
+          m_epoch{Clock::now()},
+          m_slots(isEnabled() ? std::bit_ceil(std::max<size_t>(options.maxClients, k_Probes)) : 0)
+    {
+        RUNTIME_ASSERT(options.requestsPerSecond >= 0.0 && "Rate cannot be negative")
+        RUNTIME_ASSERT(m_burst <= k_MaxBurst && "Burst is too large")
+    }
+
+    /** Is the limiter enabled?
+     *
+     * @returns true if the limiter is enabled, otherwise false
+     */
+    [[nodiscard]] bool isEnabled() const noexcept { return m_options.requestsPerSecond > 0.0; }
+
+    /** Try to let a request in
+     *
+     * @param request is the Pistache::Http::Request object
+     * @returns true if the client has a token left, otherwise false
+     */
+    [[nodiscard]] bool tryAcquire(const Pistache::Http::Request& request) noexcept
+    {
+        if (!isEnabled())
+        {
+            return true;
+        }
+
+        const auto now = millisecondsSinceEpoch();
+        auto& slot = findSlot(hashClient(request), now);
+        auto state = slot.state.load(std::memory_order_relaxed);
+        while (true)
+        {
+            const auto tokens = refill(state, now);
+            if (tokens < k_TokenScale)
+            {
+                m_limited.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (slot.state.compare_exchange_weak(state, pack(now, tokens - k_TokenScale),
+                                                 std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+    }
+
+    /** Get the value of the Retry-After header of rejections
+     *
+     * @returns how many seconds it takes for a token to come back
+     */
+    [[nodiscard]] std::string_view getRetryAfter() const noexcept { return m_retryAfter; }
+
+    /** Get the number of requests rejected
+     *
+     * @returns the number of requests rejected so far
+     */
+    [[nodiscard]] uint64_t getLimited() const noexcept
+    {
+        return m_limited.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /// Represents the clock refilling buckets
+    using Clock = std::chrono::steady_clock;
+
+    /// Represents the bucket of a client
+    struct Slot final
+    {
+        std::atomic<uint64_t> client{0};  ///< Represents the hash of the client, zero if free
+        std::atomic<uint64_t> state{0};   ///< Represents the refill time and tokens, zero if full
+    };
+
+    /** Find the slot of a client, claiming one if the client has none
+     *
+     * @param client is the hash of the client
+     * @param now is the time in milliseconds
+     * @returns the slot
+     */
+    [[nodiscard]] Slot& findSlot(const uint64_t client, const uint32_t now) noexcept
+    {
+        const auto mask = m_slots.size() - 1;
+
+        // The slot of the client comes first wherever it is, otherwise a client whose bucket ran
+        // dry would be handed a fresh one nearer to its hash, and would hold several
+        for (size_t probe = 0; probe < k_Probes; ++probe)
+        {
+            auto& slot = m_slots[(client + probe) & mask];
+            if (slot.client.load(std::memory_order_acquire) == client)
+            {
+                return slot;
+            }
+        }
+
+        Slot* oldest = nullptr;
+        uint32_t oldestAge = 0;
+        for (size_t probe = 0; probe < k_Probes; ++probe)
+        {
+            auto& slot = m_slots[(client + probe) & mask];
+            auto current = slot.client.load(std::memory_order_acquire);
+            if (current == 0 && slot.client.compare_exchange_strong(current, client))
+            {
+                return slot;
+            }
+
+            // Claimed by a request of the same client in the meantime
+            if (current == client)
+            {
+                return slot;
+            }
+
+            // A full bucket is the same as a fresh one, hence it is handed over as it is
+            const auto state = slot.state.load(std::memory_order_relaxed);
+            if (refill(state, now) == m_burst * k_TokenScale &&
+                slot.client.compare_exchange_strong(current, client))
+            {
+                return slot;
+            }
+
+            const auto age = (state == 0) ? 0 : now - static_cast<uint32_t>(state >> 32U);
+            if (oldest == nullptr || age > oldestAge)
+            {
+                oldest = &slot;
+                oldestAge = age;
+            }
+        }
+
+        // Every slot nearby is busy, the least recently used client starts over
+        oldest->client.store(client, std::memory_order_release);
+        oldest->state.store(0, std::memory_order_relaxed);
+        return *oldest;
+    }
+
+    /** Hash the client of a request
+     *
+     * @param request is the Pistache::Http::Request object
+     * @returns the hash of the client, never zero
+     */
+    [[nodiscard]] uint64_t hashClient(const Pistache::Http::Request& request) const noexcept
+    {
+        if (!m_options.keyHeader.empty())
+        {
+            const auto header = request.headers().tryGetRaw(std::string{m_options.keyHeader});
+            if (!header.isEmpty())
+            {
+                return hash(header.get().value());
+            }
+        }
+        return hash(request.address().host());
+    }
+
+    /** Hash a string with FNV-1a
+     *
+     * @param string is the string
+     * @returns the hash, never zero
+     */
+    [[nodiscard]] static uint64_t hash(const std::string_view string) noexcept
+    {
+        uint64_t result = 14695981039346656037ULL;
+        for (const auto character : string)
+        {
+            result = (result ^ static_cast<u_char>(character)) * 1099511628211ULL;
+        }
+        return (result == 0) ? 1 : result;
+    }
+
+    /** Refill a bucket
+     *
+     * @param state is the state of the bucket
+     * @param now is the time in milliseconds
+     * @returns the tokens in the bucket, scaled by k_TokenScale
+     */
+    [[nodiscard]] uint32_t refill(const uint64_t state, const uint32_t now) const noexcept
+    {
+        const auto full = m_burst * k_TokenScale;
+        if (state == 0)
+        {
+            return full;
+        }
+
+        const auto elapsed = now - static_cast<uint32_t>(state >> 32U);
+        const auto tokens = static_cast<uint32_t>(state) + elapsed * m_tokensPerMillisecond;
+        return static_cast<uint32_t>(std::min(tokens, static_cast<double_t>(full)));
+    }
+
+    /** Pack the state of a bucket
+     *
+     * @param now is the time in milliseconds
+     * @param tokens are the tokens in the bucket, scaled by k_TokenScale
+     * @returns the state
+     */
+    [[nodiscard]] static uint64_t pack(const uint32_t now, const uint32_t tokens) noexcept
+    {
+        return (static_cast<uint64_t>(now) << 32U) | tokens;
+    }
+
+    /** Get the time
+     *
+     * @returns the milliseconds since the limiter was created, never zero, wrapping around
+     */
+    [[nodiscard]] uint32_t millisecondsSinceEpoch() const noexcept
+    {
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_epoch);
+        return static_cast<uint32_t>(elapsed.count()) | 1U;
+    }
+
+    /// Represents how many fractions of a token are told apart
+    static constexpr uint32_t k_TokenScale{1024};
+
+    /// Represents the largest burst the packed state can hold
+    static constexpr uint32_t k_MaxBurst{std::numeric_limits<uint32_t>::max() / k_TokenScale};
+
+    /// Represents the slowest rate Retry-After is computed for
+    static constexpr double_t k_MinRequestsPerSecond{1.0 / 3600.0};
+
+    /// Represents how many slots a client may be found in
+    static constexpr size_t k_Probes{8};
+
+    /// The options
+    const Options m_options;
+
+    /// The bucket size
+    const uint32_t m_burst;
+
+    /// The tokens refilled every millisecond, scaled by k_TokenScale
+    const double_t m_tokensPerMillisecond;
+
+    /// The value of the Retry-After header of rejections
+    const std::string m_retryAfter;
+
+    /// When the limiter was created
+    const Clock::time_point m_epoch;
+
+    /// The buckets, whose size is a power of two
+    std::vector<Slot> m_slots;
+
+    /// How many requests have been rejected
+    std::atomic<uint64_t> m_limited{0};
+};
+
+}  // namespace pizza::endpoint
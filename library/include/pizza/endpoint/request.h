@@ -8,6 +8,8 @@
 
 #include <external/cpr/all.h>
 #include <external/pistache/all.h>
+#include <pizza/endpoint/deadline.h>
+#include <pizza/endpoint/encoding.h>
 #include <pizza/support.h>
 
 namespace pizza::endpoint
@@ -26,11 +28,21 @@ class Request final
     /// Request methods
     using Method = Pistache::Http::Method;
 
+    /// Represents a decoded query, which is a key-value pair borrowed from the request
+    using QueryParameter = std::pair<std::string_view, std::string_view>;
+
     /** Constructor
      *
      * @param request is a reference to Pistache::Http::Request object
+     * @param routePath is the path of the route serving the request, which names its parameters
+     * @param deadline is the deadline of the request
      */
-    explicit Request(const Pistache::Http::Request& request) noexcept : m_request{request} {}
+    explicit Request(const Pistache::Http::Request& request,
+                     const std::string_view routePath = {},
+                     Deadline deadline = Deadline{}) noexcept
+        : m_request{request}, m_routePath{routePath}, m_deadline{std::move(deadline)}
+    {
+    }
 
     /** Get request method
      *
@@ -44,14 +56,35 @@ class Request final
 
     /** Get request path
      *
-     * @returns request path
+     * @returns request path, borrowed from the underlying request
      */
-    [[nodiscard]] std::string getPath() const noexcept
+    [[nodiscard]] std::string_view getPath() const noexcept
     {
         const auto& resource = m_request.resource();
         return resource;
     }
 
+    /** Has request path parameter?
+     *
+     * @param name is the name of the parameter, as in ":name" of the route path
+     * @returns true if the path has the given parameter, otherwise false
+     */
+    [[nodiscard]] bool hasParameter(const std::string_view name) const noexcept
+    {
+        return findParameter(name).has_value();
+    }
+
+    /** Get request path parameter
+     *
+     * @param name is the name of the parameter, as in ":name" of the route path
+     * @returns the segment of the path the parameter stands for if there is one, otherwise an
+     * empty string
+     */
+    [[nodiscard]] std::string_view getParameter(const std::string_view name) const noexcept
+    {
+        return findParameter(name).value_or(std::string_view{});
+    }
+
     /** Has request query?
      *
      * @param key is the query key
@@ -59,8 +92,7 @@ class Request final
      */
     [[nodiscard]] bool hasQuery(const std::string_view key) const noexcept
     {
-        const auto& query = m_request.query();
-        return query.has(key.data());
+        return findQuery(key) != nullptr;
     }
 
     /** Get request query
@@ -68,37 +100,255 @@ class Request final
      * @param key is the query key, can be an empty string (default: {})
      * @returns the query value if the query has the key, otherwise the whole query string if key is
      * empty, otherwise an empty string
+     *
+     * @note Queries are decoded once per request, the returned view lives as long as this object
      */
-    [[nodiscard]] std::string getQuery(const std::string_view key = {}) const noexcept
+    [[nodiscard]] std::string_view getQuery(const std::string_view key = {}) const noexcept
     {
-        const auto& query = m_request.query();
         if (key.empty())
         {
-            return query.as_str();
+            if (!m_queryString)
+            {
+                m_queryString.emplace(m_request.query().as_str());
+            }
+            return *m_queryString;
         }
 
-        const auto value = query.get(key.data());
-        if (value.isEmpty())
+        const auto* const parameter = findQuery(key);
+        if (parameter == nullptr)
         {
             return {};
         }
+        return parameter->second;
+    }
+
+    /** Get all decoded request queries
+     *
+     * @returns the decoded queries, sorted by key, which live as long as this object
+     */
+    [[nodiscard]] std::span<const QueryParameter> getQueries() const noexcept
+    {
+        if (!m_queries)
+        {
+            decodeQueries();
+        }
+        return *m_queries;
+    }
+
+    /** Has request header?
+     *
+     * @param name is the header name, case-insensitive
+     * @returns true if the request has the given header, otherwise false
+     */
+    [[nodiscard]] bool hasHeader(const std::string_view name) const noexcept
+    {
+        return findHeader(name) != nullptr;
+    }
 
-        return cpr::util::urlDecode(value.get());
+    /** Get request header
+     *
+     * @param name is the header name, case-insensitive
+     * @returns the header value if the request has the header, otherwise an empty string
+     *
+     * @note The returned view is borrowed from the underlying request
+     */
+    [[nodiscard]] std::string_view getHeader(const std::string_view name) const noexcept
+    {
+        const auto* const header = findHeader(name);
+        if (header == nullptr)
+        {
+            return {};
+        }
+        return header->value();
     }
 
+    /** Get request deadline
+     *
+     * @returns the deadline, which is not set if the request has none
+     */
+    [[nodiscard]] const Deadline& getDeadline() const noexcept { return m_deadline; }
+
     /** Get request body
      *
-     * @returns the request body
+     * @returns the request body, borrowed from the underlying request
      */
-    [[nodiscard]] std::string getBody() const noexcept
+    [[nodiscard]] std::string_view getBody() const noexcept
     {
         const auto& body = m_request.body();
         return body;
     }
 
+    /** Get the encoding of request body
+     *
+     * @returns the binary encoding named by Content-Type, otherwise JSON
+     */
+    [[nodiscard]] Encoding getBodyEncoding() const noexcept
+    {
+        return Encodings::fromContentType(getHeader("Content-Type"));
+    }
+
+    /** Get the encoding the response should have
+     *
+     * @returns the encoding preferred by Accept among the supported ones, otherwise JSON
+     */
+    [[nodiscard]] Encoding getAcceptedEncoding() const noexcept
+    {
+        return Encodings::negotiate(getHeader("Accept"));
+    }
+
+    /** Decode request body, in its encoding
+     *
+     * @returns the decoded body, or a discarded json if it is malformed
+     */
+    [[nodiscard]] nlohmann::json getBodyJson() const noexcept
+    {
+        return Encodings::decode(getBodyEncoding(), getBody());
+    }
+
+    /** Get the underlying request
+     *
+     * @returns the Pistache::Http::Request object, for requests carried in by this one to be
+     * charged to its client
+     */
+    [[nodiscard]] const Pistache::Http::Request& getUnderlying() const noexcept
+    {
+        return m_request;
+    }
+
+    /** Take the next segment off a path
+     *
+     * @param path is the path, which loses the segment
+     * @returns the segment, empty if there is none left
+     */
+    [[nodiscard]] static std::string_view takeSegment(std::string_view& path) noexcept
+    {
+        path.remove_prefix(std::min(path.find_first_not_of('/'), path.size()));
+        const auto size = std::min(path.find('/'), path.size());
+        const auto segment = path.substr(0, size);
+        path.remove_prefix(size);
+        return segment;
+    }
+
    private:
+    /// Decode the queries of the underlying request, sorted by key
+    void decodeQueries() const noexcept
+    {
+        // Only percent-encoded strings need to go through cpr, which is anything but cheap, and
+        // only they are kept by this object, the rest is borrowed from the underlying request
+        const auto decode = [this](const std::string& encoded) -> std::string_view
+        {
+            if (encoded.find('%') == std::string::npos)
+            {
+                return encoded;
+            }
+            return m_decoded.emplace_back(cpr::util::urlDecode(encoded));
+        };
+
+        const auto& query = m_request.query();
+        auto& queries = m_queries.emplace();
+        for (auto iter = query.parameters_begin(); iter != query.parameters_end(); ++iter)
+        {
+            queries.emplace_back(decode(iter->first), decode(iter->second));
+        }
+        std::sort(queries.begin(), queries.end());
+    }
+
+    /** Find a decoded query
+     *
+     * @param key is the query key
+     * @returns the query if the request has the key, otherwise nullptr
+     */
+    [[nodiscard]] const QueryParameter* findQuery(const std::string_view key) const noexcept
+    {
+        const auto queries = getQueries();
+        const auto iter = std::lower_bound(
+            queries.begin(), queries.end(), key,
+            [](const QueryParameter& parameter, const std::string_view key_)
+            { return parameter.first < key_; });
+
+        if (iter == queries.end() || iter->first != key)
+        {
+            return nullptr;
+        }
+        return &*iter;
+    }
+
+    /** Find a path parameter
+     *
+     * @param name is the name of the parameter
+     * @returns the segment of the path the parameter stands for if there is one, otherwise nothing
+     */
+    [[nodiscard]] std::optional<std::string_view> findParameter(
+        const std::string_view name) const noexcept
+    {
+        auto route = m_routePath;
+        auto path = getPath();
+        while (true)
+        {
+            auto routeSegment = takeSegment(route);
+            const auto pathSegment = takeSegment(path);
+            if (routeSegment.empty() || pathSegment.empty())
+            {
+                return std::nullopt;
+            }
+
+            // Optional parameters are marked as in ":name?"
+            if (routeSegment.ends_with('?'))
+            {
+                routeSegment.remove_suffix(1);
+            }
+            if (routeSegment.starts_with(':') && routeSegment.substr(1) == name)
+            {
+                return pathSegment;
+            }
+        }
+    }
+
+    /** Find a header
+     *
+     * @param name is the header name, case-insensitive
+     * @returns the header if the request has the header, otherwise nullptr
+     */
+    [[nodiscard]] const Pistache::Http::Header::Raw* findHeader(
+        const std::string_view name) const noexcept
+    {
+        static constexpr auto k_IsSameName = [](const std::string_view lhs,
+                                                const std::string_view rhs)
+        {
+            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                              [](const u_char lhs_, const u_char rhs_)
+                              { return std::tolower(lhs_) == std::tolower(rhs_); });
+        };
+
+        // Pistache looks headers up by std::string only, and hands them out by copy, hence its
+        // few raw headers, which are every header parsed, are gone over in place
+        for (const auto& [headerName, header] : m_request.headers().rawList())
+        {
+            if (k_IsSameName(headerName, name))
+            {
+                return &header;
+            }
+        }
+        return nullptr;
+    }
+
     /// The Request object
     const Pistache::Http::Request& m_request;
+
+    /// The path of the route serving the request
+    const std::string_view m_routePath;
+
+    /// The deadline of the request
+    const Deadline m_deadline;
+
+    /// The whole query string, built on first use
+    mutable std::optional<std::string> m_queryString;
+
+    /// The decoded queries, sorted by key, decoded on first use
+    mutable std::optional<std::vector<QueryParameter>> m_queries;
+
+    /// The queries which were percent-encoded, decoded, which stay where they are once decoded
+    mutable std::deque<std::string> m_decoded;
 };
 
 }  // namespace pizza::endpoint
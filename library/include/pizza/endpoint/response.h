@@ -8,6 +8,7 @@
 
 #include <external/pistache/all.h>
 #include <pizza/endpoint/cake.h>
+#include <pizza/endpoint/encoding.h>
 #include <pizza/support.h>
 
 namespace pizza::endpoint
@@ -16,7 +17,8 @@ namespace pizza::endpoint
 /**
  * Represents a response
  *
- * This class is an interface to Pistache::Http::ResponseWriter
+ * This class is an interface to Pistache::Http::ResponseWriter, or to a response captured in
+ * memory for requests which are handled in-process rather than over a connection
  */
 class Response final
 {
@@ -28,49 +30,185 @@ class Response final
      * @param response is a reference to Pistache::Http::ResponseWriter object
      */
     explicit Response(Pistache::Http::ResponseWriter& response) noexcept
-        : m_response{response}, m_sent{false}
+        : m_response{&response}
     {
     }
 
     /// Response codes
     using Code = Pistache::Http::Code;
 
+    /// Represents the headers of a response, as names and values
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+
+    /// Represents a response captured in memory
+    struct Captured final
+    {
+        Code code{Code::Ok};                        ///< Represents the response code
+        Pistache::Http::Mime::MediaType mediaType;  ///< Represents the media type of the body
+        std::string body;                           ///< Represents the response body
+        Headers headers;                            ///< Represents the headers set, in order
+    };
+
+    /** Constructor
+     *
+     * @param captured is where the response is captured, rather than sent
+     */
+    explicit Response(Captured& captured) noexcept : m_captured{&captured} {}
+
+    /// The generic Bad Request response body
+    static constexpr std::string_view k_BadRequest{"Bad Request"};
+
+    /// The generic Server Error response body
+    static constexpr std::string_view k_ServerError{"Server Error"};
+
+    /// The generic Gateway Timeout response body
+    static constexpr std::string_view k_GatewayTimeout{"Gateway Timeout"};
+
+    /// The generic Service Unavailable response body
+    static constexpr std::string_view k_ServiceUnavailable{"Service Unavailable"};
+
+    /// The generic Too Many Requests response body
+    static constexpr std::string_view k_TooManyRequests{"Too Many Requests"};
+
     /** Send response
      *
      * @tparam Args are the types of arguments
      * @param code is the response code
      * @param body is the response body
      * @param args are the arguments
+     *
+     * @note The body is sent as-is without being formatted if there are no arguments
      */
     template <typename... Args>
     void send(const Code code, const std::string_view body, const Args&... args) noexcept
     {
-        if (!m_sent)
+        if (!m_code)
         {
-            m_response.send(code, fmt::vformat(body, fmt::make_format_args(args...)));
-            m_sent = true;
+            if constexpr (sizeof...(Args) == 0)
+            {
+                write(code, {}, body);
+            }
+            else
+            {
+                write(code, {}, fmt::vformat(body, fmt::make_format_args(args...)));
+            }
+            m_code = code;
         }
     }
 
-    /** Send JSON response
+    /** Send Cake response
      *
      * @param code is the response code
      * @param cake is the Cake object
+     *
+     * @note The Cake is serialized straight into a per-thread buffer which is handed to Pistache,
+     * in the encoding negotiated with the client, which the response says it varies by
      */
     void send(const Code code, const Cake& cake) noexcept
     {
-        if (!m_sent)
+        if (!m_code)
+        {
+            thread_local JsonWriter::Buffer buffer;
+            buffer.clear();
+            cake.encodeTo(m_encoding, buffer);
+
+            // Caches in between cannot hand the response to clients accepting another encoding
+            setHeader("Vary", "Accept");
+
+            write(code, Encodings::getMediaType(m_encoding), {buffer.data(), buffer.size()});
+            m_code = code;
+
+            // Do not let a single large response pin its memory to the thread forever
+            if (buffer.capacity() > k_RetainedBufferSize)
+            {
+                buffer = JsonWriter::Buffer{};
+            }
+        }
+    }
+
+    /** Send response of a media type
+     *
+     * @param code is the response code
+     * @param mediaType is the media type of the body
+     * @param body is the response body, sent as-is
+     */
+    void sendAs(const Code code, const Pistache::Http::Mime::MediaType& mediaType,
+                const std::string_view body) noexcept
+    {
+        if (!m_code)
+        {
+            write(code, mediaType, body);
+            m_code = code;
+        }
+    }
+
+    /** Set a header of the response, before it is sent
+     *
+     * @param name is the name of the header
+     * @param value is the value of the header
+     */
+    void setHeader(const std::string_view name, const std::string_view value) noexcept
+    {
+        if (m_code)
         {
-            return send(code, "{}", cake.dump());
+            return;
         }
+        if (m_captured != nullptr)
+        {
+            m_captured->headers.emplace_back(name, value);
+            return;
+        }
+        m_response->headers().addRaw(
+            Pistache::Http::Header::Raw{std::string{name}, std::string{value}});
     }
 
+    /** Set the encoding of Cake responses
+     *
+     * @param encoding is the encoding, as negotiated with the client
+     */
+    void setEncoding(const Encoding encoding) noexcept { m_encoding = encoding; }
+
+    /** Get the response code
+     *
+     * @returns the response code if the response has been sent, otherwise nothing
+     */
+    [[nodiscard]] std::optional<Code> getCode() const noexcept { return m_code; }
+
    private:
-    /// The Response object
-    Pistache::Http::ResponseWriter& m_response;
+    /** Write the response to wherever it goes
+     *
+     * @param code is the response code
+     * @param mediaType is the media type of the body
+     * @param body is the response body
+     */
+    void write(const Code code, const Pistache::Http::Mime::MediaType& mediaType,
+               const std::string_view body) noexcept
+    {
+        if (m_captured != nullptr)
+        {
+            // The headers set so far stay along with the response
+            m_captured->code = code;
+            m_captured->mediaType = mediaType;
+            m_captured->body = body;
+            return;
+        }
+        m_response->send(code, body.data(), body.size(), mediaType);
+    }
+
+    /// How large the per-thread serialization buffer may stay between responses
+    static constexpr size_t k_RetainedBufferSize{1024 * 1024};
+
+    /// The Response object, unless the response is captured
+    Pistache::Http::ResponseWriter* m_response{nullptr};
+
+    /// Where the response is captured, if it is
+    Captured* m_captured{nullptr};
+
+    /// The encoding of Cake responses
+    Encoding m_encoding{Encoding::Json};
 
-    /// Indicates if the response has been sent
-    bool m_sent;
+    /// The response code, which indicates if the response has been sent
+    std::optional<Code> m_code;
 };
 
 }  // namespace pizza::endpoint
@@ -0,0 +1,369 @@
+/**
+ * @file pizza/endpoint/response_cache.h
+ * @brief The Response Cache
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/pistache/all.h>
+#include <pizza/endpoint/response.h>
+#include <pizza/endpoint/single_flight.h>
+#include <pizza/hash.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Response Cache
+ *
+ * @brief
+ * The Response Cache keeps the successful responses to GET requests of a route for a while, so
+ * that the same requests are answered without running any phase of the handler, and requests
+ * whose If-None-Match names the ETag of the response are answered with 304 Not Modified
+ *
+ * @details
+ * Responses are kept serialized, and shared by every request they are sent to. Requests are told
+ * apart by their paths, their queries regardless of the order of the parameters, and the headers
+ * the route varies on.
+ * The cache stays within a budget of bytes, evicting with the CLOCK algorithm: hits only mark
+ * their entry as referenced under a shared lock, and when room is needed the hand sweeps over
+ * the entries, giving referenced ones a second chance and evicting the first one which is not,
+ * or which has expired.
+ */
+class ResponseCache final
+{
+    NOT_COPYABLE_CLASS(ResponseCache)
+    IMMOVEABLE_CLASS(ResponseCache)
+
+   public:
+    /// Represents the options of the cache
+    struct Options final
+    {
+        std::chrono::milliseconds ttl{0};   ///< Represents how long responses stay, zero disables
+        std::string_view varyHeaders{};     ///< Represents the comma-separated headers to vary on
+        size_t maxBytes{16 * 1024 * 1024};  ///< Represents how many bytes the cache may hold
+    };
+
+    /// Represents the clock expiring responses
+    using Clock = std::chrono::steady_clock;
+
+    /// Represents a cached response
+    struct Entry final
+    {
+        Response::Captured response;  ///< Represents the response
+        std::string etag;             ///< Represents the ETag of the response, quoted
+        Clock::time_point expires;    ///< Represents when the response expires
+    };
+
+    /** Constructor
+     *
+     * @param options are the options of the cache
+     */
+    explicit ResponseCache(const Options& options) noexcept
+        : m_options{options}, m_hand{m_entries.end()}
+    {
+        forEachToken(options.varyHeaders,
+                     [this](const std::string_view name)
+                     {
+                         m_varyHeaders.emplace_back(name);
+                         return false;
+                     });
+    }
+
+    /** Is the cache enabled?
+     *
+     * @returns true if the cache is enabled, otherwise false
+     */
+    [[nodiscard]] bool isEnabled() const noexcept { return m_options.ttl.count() > 0; }
+
+    /** Is the cache enabled for a request?
+     *
+     * @param request is the Pistache::Http::Request object
+     * @returns true if the response to the request may be cached, otherwise false
+     */
+    [[nodiscard]] bool isEnabled(const Pistache::Http::Request& request) const noexcept
+    {
+        return isEnabled() && request.method() == Pistache::Http::Method::Get;
+    }
+
+    /** Make the key of a request
+     *
+     * @param request is the Pistache::Http::Request object
+     * @returns the key of the flight of the request, followed by the headers varied on
+     */
+    [[nodiscard]] std::string makeKey(const Pistache::Http::Request& request) const noexcept
+    {
+        auto key = SingleFlight::makeKey(request);
+        for (const auto& name : m_varyHeaders)
+        {
+            key.push_back('\n');
+            if (const auto header = request.headers().tryGetRaw(name); !header.isEmpty())
+            {
+                key.append(header.get().value());
+            }
+        }
+        return key;
+    }
+
+    /** Find the response of a key
+     *
+     * @param key is the key of the request
+     * @returns the response if it is cached and fresh, otherwise nullptr
+     */
+    [[nodiscard]] std::shared_ptr<const Entry> find(const std::string& key) const noexcept
+    {
+        const std::shared_lock lock{m_mutex};
+        const auto iter = m_index.find(key);
+        if (iter == m_index.end() || iter->second->entry->expires <= Clock::now())
+        {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        iter->second->isReferenced.store(true, std::memory_order_relaxed);
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return iter->second->entry;
+    }
+
+    /** Keep the response of a key
+     *
+     * @param key is the key of the request
+     * @param response is the response
+     * @returns the cached response, or nullptr if the response is not cacheable
+     *
+     * @note Responses setting a cookie, or which their handler marked no-store or private, belong
+     * to the client they were made for, hence are never cached
+     */
+    std::shared_ptr<const Entry> store(const std::string& key,
+                                       const Response::Captured& response) noexcept
+    {
+        auto size = k_EntryOverhead + key.size() + response.body.size();
+        for (const auto& [name, value] : response.headers)
+        {
+            size += name.size() + value.size();
+        }
+        if (response.code != Response::Code::Ok || size > m_options.maxBytes ||
+            !isShareable(response))
+        {
+            return nullptr;
+        }
+
+        auto etag = fmt::format("\"{}\"", pizza::hash::computeMd5Hash(response.body));
+        auto entry = std::make_shared<const Entry>(
+            Entry{response, std::move(etag), Clock::now() + m_options.ttl});
+
+        const std::scoped_lock lock{m_mutex};
+        if (const auto iter = m_index.find(key); iter != m_index.end())
+        {
+            evict(iter->second);
+        }
+        while (m_bytes + size > m_options.maxBytes)
+        {
+            evictOne();
+        }
+
+        // New entries go right behind the hand, hence they are the last ones it comes across
+        const auto slot = m_entries.emplace(m_hand, key, entry, size);
+        m_index.emplace(slot->key, slot);
+        m_bytes += size;
+        return entry;
+    }
+
+    /** Does an If-None-Match header name an ETag?
+     *
+     * @param ifNoneMatch is the value of the If-None-Match header
+     * @param etag is the ETag, quoted
+     * @returns true if the header names the ETag, or any ETag, otherwise false
+     */
+    [[nodiscard]] static bool isMatch(const std::string_view ifNoneMatch,
+                                      const std::string_view etag) noexcept
+    {
+        return forEachToken(ifNoneMatch,
+                            [etag](std::string_view tag)
+                            {
+                                // Weak comparison, as If-None-Match wants
+                                if (tag.starts_with("W/"))
+                                {
+                                    tag.remove_prefix(2);
+                                }
+                                return tag == "*" || tag == etag;
+                            });
+    }
+
+    /** Get the number of hits
+     *
+     * @returns the number of requests answered from the cache so far
+     */
+    [[nodiscard]] uint64_t getHits() const noexcept
+    {
+        return m_hits.load(std::memory_order_relaxed);
+    }
+
+    /** Get the number of misses
+     *
+     * @returns the number of requests not answered from the cache so far
+     */
+    [[nodiscard]] uint64_t getMisses() const noexcept
+    {
+        return m_misses.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /** Is a response one every client may be sent?
+     *
+     * @param response is the response
+     * @returns false if it sets a cookie, or if its Cache-Control is no-store or private,
+     * otherwise true
+     */
+    [[nodiscard]] static bool isShareable(const Response::Captured& response) noexcept
+    {
+        // Header names and directives are case-insensitive, and the given ones are lowercase
+        static constexpr auto k_IsSame = [](const std::string_view name,
+                                            const std::string_view lowercase)
+        {
+            return std::equal(name.begin(), name.end(), lowercase.begin(), lowercase.end(),
+                              [](const char left, const char right)
+                              { return std::tolower(static_cast<u_char>(left)) == right; });
+        };
+
+        return std::none_of(
+            response.headers.begin(), response.headers.end(),
+            [](const auto& header)
+            {
+                const auto& [name, value] = header;
+                if (k_IsSame(name, "set-cookie"))
+                {
+                    return true;
+                }
+                return k_IsSame(name, "cache-control") &&
+                       forEachToken(value,
+                                    [](const std::string_view directive)
+                                    {
+                                        // As in private="Set-Cookie"
+                                        const auto directiveName =
+                                            directive.substr(0, directive.find('='));
+                                        return k_IsSame(directiveName, "no-store") ||
+                                               k_IsSame(directiveName, "private");
+                                    });
+            });
+    }
+
+    /** Go over the tokens of a comma-separated list, until one is found
+     *
+     * @tparam Predicate is the type of predicate
+     * @param list is the comma-separated list
+     * @param predicate tells whether a token, without surrounding spaces, is the one to find
+     * @returns true if the token has been found, otherwise false
+     */
+    template <typename Predicate>
+    static bool forEachToken(std::string_view list, const Predicate& predicate) noexcept
+    {
+        while (!list.empty())
+        {
+            const auto size = std::min(list.find(','), list.size());
+            auto token = list.substr(0, size);
+            list.remove_prefix(std::min(size + 1, list.size()));
+
+            token.remove_prefix(std::min(token.find_first_not_of(" \t"), token.size()));
+            token.remove_suffix(token.size() - std::min(token.find_last_not_of(" \t") + 1,
+                                                        token.size()));
+            if (!token.empty() && predicate(token))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Represents a slot on the clock
+    struct Slot final
+    {
+        /** Constructor
+         *
+         * @param key_ is the key of the request
+         * @param entry_ is the response
+         * @param size_ is how many bytes the slot takes
+         */
+        explicit Slot(std::string key_, std::shared_ptr<const Entry> entry_,
+                      const size_t size_) noexcept
+            : key{std::move(key_)}, entry{std::move(entry_)}, size{size_}
+        {
+        }
+
+        const std::string key;                     ///< Represents the key of the request
+        const std::shared_ptr<const Entry> entry;  ///< Represents the response
+        const size_t size;                         ///< Represents how many bytes the slot takes
+        std::atomic<bool> isReferenced{false};     ///< Indicates if it has been hit lately
+    };
+
+    /// Represents the slots, in the order the hand goes over them
+    using Slots = std::list<Slot>;
+
+    /// Evict the first slot the hand comes across which is neither referenced nor fresh
+    void evictOne() noexcept
+    {
+        const auto now = Clock::now();
+        while (true)
+        {
+            if (m_hand == m_entries.end())
+            {
+                m_hand = m_entries.begin();
+            }
+            if (m_hand->entry->expires <= now ||
+                !m_hand->isReferenced.exchange(false, std::memory_order_relaxed))
+            {
+                return evict(m_hand);
+            }
+            ++m_hand;
+        }
+    }
+
+    /** Evict a slot
+     *
+     * @param slot is the slot
+     */
+    void evict(const Slots::iterator slot) noexcept
+    {
+        if (m_hand == slot)
+        {
+            ++m_hand;
+        }
+        m_bytes -= slot->size;
+        m_index.erase(slot->key);
+        m_entries.erase(slot);
+    }
+
+    /// Represents roughly how many bytes an entry takes besides its key and body
+    static constexpr size_t k_EntryOverhead{sizeof(Slot) + sizeof(Entry) + 64};
+
+    /// The options
+    const Options m_options;
+
+    /// The headers varied on
+    std::vector<std::string> m_varyHeaders;
+
+    /// Guards everything below but the counters
+    mutable std::shared_mutex m_mutex;
+
+    /// The slots
+    Slots m_entries;
+
+    /// The slots by the keys of their requests
+    std::unordered_map<std::string_view, Slots::iterator> m_index;
+
+    /// The hand of the clock
+    Slots::iterator m_hand;
+
+    /// How many bytes the slots take
+    size_t m_bytes{0};
+
+    /// How many requests have been answered from the cache
+    mutable std::atomic<uint64_t> m_hits{0};
+
+    /// How many requests have not been answered from the cache
+    mutable std::atomic<uint64_t> m_misses{0};
+};
+
+}  // namespace pizza::endpoint
@@ -0,0 +1,184 @@
+/**
+ * @file pizza/endpoint/route.h
+ * @brief The Route
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/concurrency_limiter.h>
+#include <pizza/endpoint/metrics.h>
+#include <pizza/endpoint/rate_limiter.h>
+#include <pizza/endpoint/request.h>
+#include <pizza/endpoint/response_cache.h>
+#include <pizza/endpoint/single_flight.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+class Handler;
+
+/**
+ * The Route
+ *
+ * @brief
+ * A Route binds a request method and path to the handler serving it, together with the state kept
+ * for the route, such as its metrics and its limiters
+ */
+class Route final
+{
+    DEFAULT_DESTRUCTIBLE_FINAL_CLASS(Route)
+
+   public:
+    /** Constructor
+     *
+     * @param handler is the handler serving the route
+     * @param requestMethod is the request method
+     * @param requestPath is the request path
+     * @param concurrencyLimit are the options of the concurrency limiter
+     * @param rateLimit are the options of the rate limiter
+     * @param singleFlight indicates whether identical GET requests share one run of the handler
+     * @param cache are the options of the response cache
+     * @param deadline is the time budget of requests, zero if they have none
+     */
+    explicit Route(Handler& handler, const Request::Method requestMethod,
+                   const std::string_view requestPath,
+                   const ConcurrencyLimiter::Options& concurrencyLimit,
+                   const RateLimiter::Options& rateLimit, const bool singleFlight,
+                   const ResponseCache::Options& cache,
+                   const std::chrono::milliseconds deadline) noexcept
+        : m_handler{handler},
+          m_requestMethod{requestMethod},
+          m_requestPath{requestPath},
+          m_metrics{Metrics::getMetrics().addRoute(requestMethod, requestPath)},
+          m_limiter{concurrencyLimit},
+          m_rateLimiter{rateLimit},
+          m_singleFlight{singleFlight},
+          m_cache{cache},
+          m_deadline{deadline}
+    {
+        m_metrics.watch(m_limiter);
+        m_metrics.watch(m_rateLimiter);
+        m_metrics.watch(m_cache);
+    }
+
+    /** Get the handler
+     *
+     * @returns the handler serving the route
+     */
+    [[nodiscard]] Handler& getHandler() const noexcept { return m_handler; }
+
+    /** Get the request method
+     *
+     * @returns the request method
+     */
+    [[nodiscard]] Request::Method getMethod() const noexcept { return m_requestMethod; }
+
+    /** Get the request path
+     *
+     * @returns the request path
+     */
+    [[nodiscard]] std::string_view getPath() const noexcept { return m_requestPath; }
+
+    /** Does the route match a request?
+     *
+     * @param requestMethod is the request method
+     * @param requestPath is the request path, without the query
+     * @returns true if the route serves the request, otherwise false
+     *
+     * @note Segments of parameters (":name") and wildcards ("*") match any segment
+     */
+    [[nodiscard]] bool matches(const Request::Method requestMethod,
+                               const std::string_view requestPath) const noexcept
+    {
+        if (requestMethod != m_requestMethod)
+        {
+            return false;
+        }
+
+        std::string_view route = m_requestPath;
+        std::string_view path = requestPath;
+        while (true)
+        {
+            const auto routeSegment = Request::takeSegment(route);
+            const auto pathSegment = Request::takeSegment(path);
+            if (routeSegment.empty() || pathSegment.empty())
+            {
+                return routeSegment.empty() && pathSegment.empty();
+            }
+
+            const auto isParameter = routeSegment.starts_with(':') || routeSegment == "*";
+            if (!isParameter && routeSegment != pathSegment)
+            {
+                return false;
+            }
+        }
+    }
+
+    /** Get the metrics
+     *
+     * @returns the metrics of the route
+     */
+    [[nodiscard]] RouteMetrics& getMetrics() const noexcept { return m_metrics; }
+
+    /** Get the concurrency limiter
+     *
+     * @returns the concurrency limiter of the route
+     */
+    [[nodiscard]] ConcurrencyLimiter& getLimiter() const noexcept { return m_limiter; }
+
+    /** Get the rate limiter
+     *
+     * @returns the rate limiter of the route
+     */
+    [[nodiscard]] RateLimiter& getRateLimiter() const noexcept { return m_rateLimiter; }
+
+    /** Get the single flight
+     *
+     * @returns the single flight of the route
+     */
+    [[nodiscard]] SingleFlight& getSingleFlight() const noexcept { return m_singleFlight; }
+
+    /** Get the response cache
+     *
+     * @returns the response cache of the route
+     */
+    [[nodiscard]] ResponseCache& getCache() const noexcept { return m_cache; }
+
+    /** Get the time budget of requests
+     *
+     * @returns the time budget of requests, zero if they have none
+     */
+    [[nodiscard]] std::chrono::milliseconds getDeadline() const noexcept { return m_deadline; }
+
+   private:
+    /// The handler serving the route
+    Handler& m_handler;
+
+    /// The request method
+    const Request::Method m_requestMethod;
+
+    /// The request path
+    const std::string_view m_requestPath;
+
+    /// The metrics of the route
+    RouteMetrics& m_metrics;
+
+    /// The concurrency limiter of the route
+    mutable ConcurrencyLimiter m_limiter;
+
+    /// The rate limiter of the route
+    mutable RateLimiter m_rateLimiter;
+
+    /// The single flight of the route
+    mutable SingleFlight m_singleFlight;
+
+    /// The response cache of the route
+    mutable ResponseCache m_cache;
+
+    /// The time budget of requests
+    const std::chrono::milliseconds m_deadline;
+};
+
+}  // namespace pizza::endpoint
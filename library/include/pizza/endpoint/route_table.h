@@ -0,0 +1,227 @@
+/**
+ * @file pizza/endpoint/route_table.h
+ * @brief The Route Table
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/endpoint/request.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Route Table
+ *
+ * @brief
+ * The Route Table maps static routes, that is (method, path) pairs without parameters, onto their
+ * targets with a perfect hash, so that a lookup costs one hash and one comparison
+ *
+ * @details
+ * This is the same hash-and-displace scheme frozen uses, except that the table is built at
+ * run-time: handlers register themselves from different translation units, hence the whole set of
+ * routes is only known once the endpoint starts serving. Keys are first hashed into buckets, then
+ * buckets are placed from the largest to the smallest, each with the first seed that puts all of
+ * its keys into free slots.
+ *
+ * @tparam Target is the type of route targets
+ */
+template <typename Target>
+class RouteTable final
+{
+    DEFAULT_MOVEABLE_FINAL_CLASS(RouteTable)
+
+   public:
+    /// Represents a static route
+    struct Route final
+    {
+        Request::Method requestMethod;  ///< Represents the request method
+        std::string_view requestPath;   ///< Represents the request path
+        Target target;                  ///< Represents the route target
+    };
+
+    /** Is the request path static?
+     *
+     * @param requestPath is the request path
+     * @returns true if the path has neither parameters nor splats, otherwise false
+     */
+    [[nodiscard]] static constexpr bool isStatic(const std::string_view requestPath) noexcept
+    {
+        return requestPath.find_first_of(":*") == std::string_view::npos;
+    }
+
+    /// Constructor
+    explicit RouteTable() noexcept = default;
+
+    /** Constructor
+     *
+     * @param routes are the static routes
+     */
+    explicit RouteTable(std::vector<Route> routes) noexcept
+        : m_seeds(std::max<size_t>(routes.size(), 1), 0),
+          m_slots(std::bit_ceil(std::max<size_t>(routes.size(), 1)))
+    {
+        // A route registered twice could never be placed, hence only the first one is kept
+        std::stable_sort(routes.begin(), routes.end(), isBefore);
+        const auto duplicates = std::unique(routes.begin(), routes.end(), isSame);
+        RUNTIME_ASSERT(duplicates == routes.end() && "Route is registered more than once")
+        routes.erase(duplicates, routes.end());
+
+        // Gather the routes into buckets
+        std::vector<std::vector<size_t>> buckets(m_seeds.size());
+        for (size_t index = 0; index < routes.size(); ++index)
+        {
+            const auto& route = routes.at(index);
+            buckets.at(mix(hash(route.requestMethod, route.requestPath), 0) % buckets.size())
+                .emplace_back(index);
+        }
+
+        std::vector<size_t> order(buckets.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&buckets](const size_t lhs, const size_t rhs)
+                  { return buckets.at(lhs).size() > buckets.at(rhs).size(); });
+
+        // Place the buckets, the largest first, as they are the hardest to place
+        std::vector<size_t> placed;
+        for (const auto bucketIndex : order)
+        {
+            const auto& bucket = buckets.at(bucketIndex);
+            for (uint64_t seed = 1; !bucket.empty(); ++seed)
+            {
+                placed.clear();
+                for (const auto index : bucket)
+                {
+                    const auto& route = routes.at(index);
+                    const auto slot = slotOf(hash(route.requestMethod, route.requestPath), seed);
+                    if (m_slots.at(slot) ||
+                        std::find(placed.begin(), placed.end(), slot) != placed.end())
+                    {
+                        break;
+                    }
+                    placed.emplace_back(slot);
+                }
+                if (placed.size() != bucket.size())
+                {
+                    continue;
+                }
+
+                m_seeds.at(bucketIndex) = seed;
+                for (size_t offset = 0; offset < bucket.size(); ++offset)
+                {
+                    m_slots.at(placed.at(offset)) = routes.at(bucket.at(offset));
+                }
+                break;
+            }
+        }
+    }
+
+    /** Find the target of a route
+     *
+     * @param requestMethod is the request method
+     * @param requestPath is the request path
+     * @returns the target if the route exists, otherwise nullptr
+     */
+    [[nodiscard]] const Target* find(const Request::Method requestMethod,
+                                     const std::string_view requestPath) const noexcept
+    {
+        if (m_slots.empty())
+        {
+            return nullptr;
+        }
+
+        const auto pathHash = hash(requestMethod, requestPath);
+        const auto bucket = mix(pathHash, 0) % m_seeds.size();
+        const auto& slot = m_slots[slotOf(pathHash, m_seeds[bucket])];
+        if (!slot || slot->requestMethod != requestMethod || slot->requestPath != requestPath)
+        {
+            return nullptr;
+        }
+        return &slot->target;
+    }
+
+    /** Get the number of routes
+     *
+     * @returns the number of routes
+     */
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return std::count_if(m_slots.begin(), m_slots.end(),
+                             [](const auto& slot) { return slot.has_value(); });
+    }
+
+   private:
+    /** Is a route ordered before another one?
+     *
+     * @param lhs is a route
+     * @param rhs is another route
+     * @returns true if lhs is ordered before rhs, otherwise false
+     */
+    [[nodiscard]] static bool isBefore(const Route& lhs, const Route& rhs) noexcept
+    {
+        return std::tie(lhs.requestMethod, lhs.requestPath) <
+               std::tie(rhs.requestMethod, rhs.requestPath);
+    }
+
+    /** Are both routes the same?
+     *
+     * @param lhs is a route
+     * @param rhs is another route
+     * @returns true if both routes have the same method and path, otherwise false
+     */
+    [[nodiscard]] static bool isSame(const Route& lhs, const Route& rhs) noexcept
+    {
+        return lhs.requestMethod == rhs.requestMethod && lhs.requestPath == rhs.requestPath;
+    }
+
+    /** Hash a route
+     *
+     * @param requestMethod is the request method
+     * @param requestPath is the request path
+     * @returns the hash, with FNV-1a
+     */
+    [[nodiscard]] static uint64_t hash(const Request::Method requestMethod,
+                                       const std::string_view requestPath) noexcept
+    {
+        uint64_t result = 14695981039346656037ULL ^ static_cast<uint64_t>(requestMethod);
+        for (const auto character : requestPath)
+        {
+            result = (result ^ static_cast<u_char>(character)) * 1099511628211ULL;
+        }
+        return result;
+    }
+
+    /** Mix a hash with a seed
+     *
+     * @param routeHash is the hash of a route
+     * @param seed is the seed
+     * @returns the mixed hash, with splitmix64, so that every seed spreads routes differently
+     */
+    [[nodiscard]] static uint64_t mix(uint64_t routeHash, const uint64_t seed) noexcept
+    {
+        routeHash += seed * 0x9E3779B97F4A7C15ULL;
+        routeHash = (routeHash ^ (routeHash >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        routeHash = (routeHash ^ (routeHash >> 27U)) * 0x94D049BB133111EBULL;
+        return routeHash ^ (routeHash >> 31U);
+    }
+
+    /** Get the slot of a route
+     *
+     * @param routeHash is the hash of the route
+     * @param seed is the seed of the bucket the route falls into
+     * @returns the slot index
+     */
+    [[nodiscard]] size_t slotOf(const uint64_t routeHash, const uint64_t seed) const noexcept
+    {
+        return mix(routeHash, seed) & (m_slots.size() - 1);
+    }
+
+    /// The seeds of each bucket
+    std::vector<uint64_t> m_seeds;
+
+    /// The slots, whose size is a power of two
+    std::vector<std::optional<Route>> m_slots;
+};
+
+}  // namespace pizza::endpoint
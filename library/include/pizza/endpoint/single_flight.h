@@ -0,0 +1,162 @@
+/**
+ * @file pizza/endpoint/single_flight.h
+ * @brief The Single Flight
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/pistache/all.h>
+#include <pizza/endpoint/encoding.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Single Flight
+ *
+ * @brief
+ * The Single Flight lets identical GET requests of a route in flight at the same time share one
+ * run of the handler: the first one leads the flight, the others join it and wait, and once the
+ * leader lands every one of them gets the response of the leader
+ *
+ * @details
+ * Requests are identical if their paths and queries are, regardless of the order of the query
+ * parameters, and if they negotiate the same encoding. Other headers are not taken into account,
+ * but for those the response cache of the route varies on, if it has one, hence only routes whose
+ * responses do not depend on any other should opt in.
+ * Flights are spread over shards by the hash of their keys, so that hot keys of different shards
+ * do not contend on the same lock.
+ */
+class SingleFlight final
+{
+    NOT_COPYABLE_CLASS(SingleFlight)
+    IMMOVEABLE_CLASS(SingleFlight)
+
+   public:
+    /// Represents the requests waiting for a flight to land
+    using Waiters = std::vector<Pistache::Http::ResponseWriter>;
+
+    /** Constructor
+     *
+     * @param isEnabled indicates whether identical requests share one run of the handler
+     */
+    explicit SingleFlight(const bool isEnabled) noexcept : m_isEnabled{isEnabled} {}
+
+    /** Is the single flight enabled for a request?
+     *
+     * @param request is the Pistache::Http::Request object
+     * @returns true if the request may share a flight, otherwise false
+     */
+    [[nodiscard]] bool isEnabled(const Pistache::Http::Request& request) const noexcept
+    {
+        return m_isEnabled && request.method() == Pistache::Http::Method::Get;
+    }
+
+    /** Make the key of a request
+     *
+     * @param request is the Pistache::Http::Request object
+     * @returns the path, followed by the query parameters sorted by key, and by the encoding
+     * negotiated for the response unless it is JSON
+     */
+    [[nodiscard]] static std::string makeKey(const Pistache::Http::Request& request) noexcept
+    {
+        const auto& query = request.query();
+        std::vector<std::pair<std::string_view, std::string_view>> parameters;
+        for (auto iter = query.parameters_begin(); iter != query.parameters_end(); ++iter)
+        {
+            parameters.emplace_back(iter->first, iter->second);
+        }
+        std::sort(parameters.begin(), parameters.end());
+
+        std::string key{request.resource()};
+        for (const auto& [name, value] : parameters)
+        {
+            key.push_back((&name == &parameters.front().first) ? '?' : '&');
+            key.append(name);
+            key.push_back('=');
+            key.append(value);
+        }
+
+        // Clients accepting different encodings get different responses
+        if (const auto accept = request.headers().tryGetRaw("Accept"); !accept.isEmpty())
+        {
+            if (const auto encoding = Encodings::negotiate(accept.get().value());
+                encoding != Encoding::Json)
+            {
+                key.push_back('\t');
+                key.append(magic_enum::enum_name(encoding));
+            }
+        }
+        return key;
+    }
+
+    /** Join the flight of a key, or lead a new one if there is none
+     *
+     * @param key is the key of the request
+     * @param response is the Pistache::Http::ResponseWriter object, which is moved into the flight
+     * if the request joins it
+     * @returns true if the request has joined a flight, otherwise false, in which case it leads a
+     * new one and must land it
+     */
+    [[nodiscard]] bool join(const std::string& key,
+                            Pistache::Http::ResponseWriter& response) noexcept
+    {
+        auto& shard = getShard(key);
+        const std::scoped_lock lock{shard.mutex};
+        const auto [iter, isNew] = shard.flights.try_emplace(key);
+        if (!isNew)
+        {
+            iter->second.emplace_back(std::move(response));
+        }
+        return !isNew;
+    }
+
+    /** Land the flight of a key
+     *
+     * @param key is the key of the request leading the flight, empty if it leads none
+     * @returns the requests which have joined the flight
+     */
+    [[nodiscard]] Waiters land(const std::string& key) noexcept
+    {
+        if (key.empty())
+        {
+            return {};
+        }
+
+        auto& shard = getShard(key);
+        const std::scoped_lock lock{shard.mutex};
+        auto node = shard.flights.extract(key);
+        return node.empty() ? Waiters{} : std::move(node.mapped());
+    }
+
+   private:
+    /// Represents the flights of some keys
+    struct Shard final
+    {
+        std::mutex mutex;                                  ///< Represents the lock
+        std::unordered_map<std::string, Waiters> flights;  ///< Represents the flights
+    };
+
+    /** Get the shard of a key
+     *
+     * @param key is the key
+     * @returns the shard
+     */
+    [[nodiscard]] Shard& getShard(const std::string& key) noexcept
+    {
+        return m_shards.at(std::hash<std::string>{}(key) % k_Shards);
+    }
+
+    /// Represents how many shards there are
+    static constexpr size_t k_Shards{16};
+
+    /// Indicates whether identical requests share one run of the handler
+    const bool m_isEnabled;
+
+    /// The shards
+    std::array<Shard, k_Shards> m_shards;
+};
+
+}  // namespace pizza::endpoint
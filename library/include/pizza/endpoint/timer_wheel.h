@@ -0,0 +1,154 @@
+/**
+ * @file pizza/endpoint/timer_wheel.h
+ * @brief The Timer Wheel
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/support.h>
+#include <pizza/thread.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Timer Wheel
+ *
+ * @brief
+ * The Timer Wheel expires the deadlines of requests, one tick at a time, on a thread of its own
+ *
+ * @details
+ * Timers are hashed into the slots of the wheel by the tick they expire on, and a timer further
+ * away than one turn of the wheel waits for as many turns as it takes. Scheduling a timer costs
+ * the lock of a single slot, and every tick only looks at the timers of the slot under the hand,
+ * hence the cost does not grow with how many requests are in flight.
+ * Expired timers are merely flagged, whoever owns them finds out by looking at the flag.
+ * The wheel does not own timers, so that a timer goes away along with the request it belongs to,
+ * rather than lingering until it expires, and the wheel lets go of it once the hand comes by.
+ */
+class TimerWheel final
+{
+    SINGLETON_CLASS(TimerWheel)
+
+   public:
+    /// Represents the clock of timers
+    using Clock = std::chrono::steady_clock;
+
+    /// Represents a timer
+    struct Timer final
+    {
+        /** Constructor
+         *
+         * @param expires_ is when the timer expires
+         */
+        explicit Timer(const Clock::time_point expires_) noexcept : expires{expires_} {}
+
+        const Clock::time_point expires;     ///< Represents when the timer expires
+        std::atomic<bool> isExpired{false};  ///< Indicates if the timer has expired
+    };
+
+    /** Schedule a timer
+     *
+     * @param timer is the timer, which is cancelled by letting go of it
+     */
+    void schedule(const std::shared_ptr<Timer>& timer) noexcept
+    {
+        // The hand may be up to a tick behind, hence one more tick keeps timers from expiring early
+        const auto delay = std::max(timer->expires - Clock::now(), Clock::duration::zero());
+        const auto ticks = static_cast<size_t>((delay + k_Tick - Clock::duration{1}) / k_Tick) + 1;
+
+        // The slot comes up within a turn, after (ticks - 1) % k_Slots + 1 ticks, then once a turn
+        const auto turns = (ticks - 1) / k_Slots;
+        while (true)
+        {
+            const auto hand = m_hand.load(std::memory_order_acquire);
+            auto& slot = m_slots.at((hand + ticks) % k_Slots);
+            const std::scoped_lock lock{slot.mutex};
+
+            // The hand moves on before it takes the lock of the slot it moves to, hence if it has
+            // not moved by now, it comes across the timer no earlier than ticks away
+            if (m_hand.load(std::memory_order_acquire) == hand)
+            {
+                slot.timers.push_back({timer, turns});
+                return;
+            }
+        }
+    }
+
+   private:
+    /// Represents a timer in a slot
+    struct Entry final
+    {
+        std::weak_ptr<Timer> timer;  ///< Represents the timer, gone if cancelled
+        size_t turns;                ///< Represents the turns left
+    };
+
+    /// Represents the timers of a slot
+    struct Slot final
+    {
+        std::mutex mutex;           ///< Represents the lock
+        std::vector<Entry> timers;  ///< Represents the timers
+    };
+
+    /** Turn the wheel until stopped
+     *
+     * @param stop tells when to stop
+     */
+    void turn(const std::stop_token& stop) noexcept
+    {
+        auto next = Clock::now() + k_Tick;
+        while (!stop.stop_requested())
+        {
+            std::this_thread::sleep_until(next);
+            next += k_Tick;
+
+            // Timers scheduled right now land on the next slot at the earliest, never on this one
+            const auto hand = (m_hand.load(std::memory_order_relaxed) + 1) % k_Slots;
+            m_hand.store(hand, std::memory_order_release);
+            expire(m_slots.at(hand));
+        }
+    }
+
+    /** Expire the timers of a slot which are due this turn, and let go of the cancelled ones
+     *
+     * @param slot is the slot
+     */
+    static void expire(Slot& slot) noexcept
+    {
+        const std::scoped_lock lock{slot.mutex};
+        std::erase_if(slot.timers,
+                      [](Entry& entry)
+                      {
+                          const auto timer = entry.timer.lock();
+                          if (timer == nullptr)
+                          {
+                              return true;
+                          }
+                          if (entry.turns > 0)
+                          {
+                              --entry.turns;
+                              return false;
+                          }
+                          timer->isExpired.store(true, std::memory_order_release);
+                          return true;
+                      });
+    }
+
+    /// Represents how long a tick is
+    static constexpr Clock::duration k_Tick{std::chrono::milliseconds{10}};
+
+    /// Represents how many slots there are, a turn of the wheel lasts a little over 5 seconds
+    static constexpr size_t k_Slots{512};
+
+    /// The slots
+    std::array<Slot, k_Slots> m_slots;
+
+    /// The slot under the hand
+    std::atomic<size_t> m_hand{0};
+
+    /// The thread turning the wheel, which goes first on destruction
+    std::jthread m_thread{makeThread([this](const std::stop_token& stop) { turn(stop); })};
+};
+
+}  // namespace pizza::endpoint
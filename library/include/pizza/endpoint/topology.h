@@ -0,0 +1,83 @@
+/**
+ * @file pizza/endpoint/topology.h
+ * @brief The CPU Topology
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/posix/all.h>
+#include <pizza/support.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * Packages together the functions inspecting and using the CPU topology
+ *
+ * This class is not meant to be constructed, but to hide some details
+ */
+class Topology final
+{
+    STATIC_CLASS(Topology)
+
+   public:
+    /** Get the cores the process may run on
+     *
+     * @returns the cores, which honor taskset and cpusets rather than counting every core
+     */
+    [[nodiscard]] static std::vector<size_t> getCores() noexcept
+    {
+        std::vector<size_t> cores;
+
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+        {
+            for (size_t core = 0; core < CPU_SETSIZE; ++core)
+            {
+                if (CPU_ISSET(core, &cpuSet))
+                {
+                    cores.emplace_back(core);
+                }
+            }
+        }
+
+        if (cores.empty())
+        {
+            cores.resize(std::max(std::thread::hardware_concurrency(), 1U));
+            std::iota(cores.begin(), cores.end(), 0);
+        }
+        return cores;
+    }
+
+    /** Pin the calling thread to a core
+     *
+     * @param core is the core
+     * @returns true if the thread is pinned, otherwise false
+     *
+     * @note Threads spawned by the calling thread from then on are pinned to the same core
+     */
+    [[nodiscard]] static bool pinTo(const size_t core) noexcept
+    {
+        return pinTo(std::span{&core, 1});
+    }
+
+    /** Pin the calling thread to some cores
+     *
+     * @param cores are the cores, e.g. those from getCores() to undo pinning to a single one
+     * @returns true if the thread is pinned, otherwise false
+     */
+    [[nodiscard]] static bool pinTo(const std::span<const size_t> cores) noexcept
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (const auto core : cores)
+        {
+            CPU_SET(core, &cpuSet);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+    }
+};
+
+}  // namespace pizza::endpoint
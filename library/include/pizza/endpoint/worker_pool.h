@@ -0,0 +1,198 @@
+/**
+ * @file pizza/endpoint/worker_pool.h
+ * @brief The Worker Pool
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/log/logger.h>
+#include <pizza/support.h>
+#include <pizza/thread.h>
+
+namespace pizza::endpoint
+{
+
+/**
+ * The Worker Pool
+ *
+ * @brief
+ * The Worker Pool runs the phases of blocking handlers away from the Pistache reactor threads, so
+ * that a slow handler would not stall every other connection served by the same reactor
+ *
+ * @note
+ * The pool grows whenever more tasks are pending than workers are idle, up to the maximum number
+ * of workers, and shrinks back down to the minimum number of workers once workers have been idle
+ * for longer than the idle timeout
+ */
+class WorkerPool final
+{
+    NOT_COPYABLE_CLASS(WorkerPool)
+    IMMOVEABLE_CLASS(WorkerPool)
+
+   public:
+    /// Represents a task to run on the pool
+    using Task = std::function<void()>;
+
+    /** Get the Worker Pool
+     *
+     * @returns the Worker Pool
+     */
+    [[nodiscard]] static WorkerPool& getWorkerPool() noexcept
+    {
+        static WorkerPool obj;
+        return obj;
+    }
+
+    /** Configure the pool
+     *
+     * @param minWorkers is the number of workers to keep even if they are idle
+     * @param maxWorkers is the number of workers the pool may grow up to
+     * @param idleTimeout is how long a worker may stay idle before it retires
+     */
+    void configure(const size_t minWorkers, const size_t maxWorkers,
+                   const std::chrono::milliseconds idleTimeout = k_IdleTimeout) noexcept
+    {
+        RUNTIME_ASSERT(maxWorkers > 0 && "Worker pool cannot have zero workers")
+        RUNTIME_ASSERT(minWorkers <= maxWorkers && "Minimum workers exceeds maximum workers")
+
+        const std::scoped_lock lock{m_mutex};
+        m_minWorkers = minWorkers;
+        m_maxWorkers = maxWorkers;
+        m_idleTimeout = idleTimeout;
+
+        while (m_workers < m_minWorkers)
+        {
+            spawnWorker();
+        }
+        m_log.info("Configured with {} to {} workers", m_minWorkers, m_maxWorkers);
+    }
+
+    /** Submit a task to the pool
+     *
+     * @param task is the task to run
+     */
+    void submit(Task task) noexcept
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_tasks.emplace_back(std::move(task));
+
+        if (m_tasks.size() > m_idle && m_workers < m_maxWorkers)
+        {
+            spawnWorker();
+            return;
+        }
+        m_hasTask.notify_one();
+    }
+
+    /** Wait for the pool to run every task submitted, including the ones the tasks submit
+     *
+     * @note Tasks may hold on to the responses of requests, hence the pool is to be joined before
+     * the endpoint shuts down
+     */
+    void join() noexcept
+    {
+        std::unique_lock lock{m_mutex};
+        m_hasFinished.wait(lock, [this] { return m_tasks.empty() && m_idle == m_workers; });
+    }
+
+   private:
+    /// Constructor
+    explicit WorkerPool() noexcept = default;
+
+    /// Destructor, lets the workers finish the remaining tasks before returning
+    ~WorkerPool() noexcept
+    {
+        std::unique_lock lock{m_mutex};
+        m_stopping = true;
+        m_hasTask.notify_all();
+        m_hasRetired.wait(lock, [this] { return m_workers == 0; });
+    }
+
+    /// Spawn a new worker, must be called with the mutex held
+    void spawnWorker() noexcept
+    {
+        ++m_workers;
+        ++m_idle;
+        makeThread([this] { work(); }).detach();
+    }
+
+    /// The worker loop
+    void work() noexcept
+    {
+        std::unique_lock lock{m_mutex};
+        while (true)
+        {
+            const auto hasTask = m_hasTask.wait_for(
+                lock, m_idleTimeout, [this] { return !m_tasks.empty() || m_stopping; });
+
+            if (m_tasks.empty() && (m_stopping || (!hasTask && m_workers > m_minWorkers)))
+            {
+                break;
+            }
+            if (m_tasks.empty())
+            {
+                continue;
+            }
+
+            auto task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            --m_idle;
+
+            lock.unlock();
+            task();
+            lock.lock();
+
+            ++m_idle;
+            if (m_tasks.empty() && m_idle == m_workers)
+            {
+                m_hasFinished.notify_all();
+            }
+        }
+
+        --m_idle;
+        --m_workers;
+        m_hasRetired.notify_all();
+    }
+
+    /// The default idle timeout of workers
+    static constexpr std::chrono::milliseconds k_IdleTimeout{std::chrono::seconds{30}};
+
+    /// The Logger
+    const pizza::log::Logger m_log{"endpoint:workers"};
+
+    /// Guards everything below
+    std::mutex m_mutex;
+
+    /// Signals that a task is available or the pool is stopping
+    std::condition_variable m_hasTask;
+
+    /// Signals that a worker has retired
+    std::condition_variable m_hasRetired;
+
+    /// Signals that every task submitted has run
+    std::condition_variable m_hasFinished;
+
+    /// The pending tasks
+    std::deque<Task> m_tasks;
+
+    /// The number of workers to keep even if they are idle
+    size_t m_minWorkers{0};
+
+    /// The number of workers the pool may grow up to
+    size_t m_maxWorkers{std::max(std::thread::hardware_concurrency(), 1U)};
+
+    /// How long a worker may stay idle before it retires
+    std::chrono::milliseconds m_idleTimeout{k_IdleTimeout};
+
+    /// The number of live workers
+    size_t m_workers{0};
+
+    /// The number of live workers waiting for a task
+    size_t m_idle{0};
+
+    /// Indicates if the pool is being destructed
+    bool m_stopping{false};
+};
+
+}  // namespace pizza::endpoint
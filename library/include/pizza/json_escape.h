@@ -0,0 +1,136 @@
+/**
+ * @file pizza/json_escape.h
+ * @brief Escapes strings into JSON
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/support.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace pizza::json_escape
+{
+
+/**
+ * Packages together the functions escaping strings into JSON, for the endpoint as well as for the
+ * logs
+ *
+ * This class is not meant to be constructed, but to hide some details
+ */
+class JsonEscape final
+{
+    STATIC_CLASS(JsonEscape)
+
+   public:
+    /// Represents the buffer being written to
+    using Buffer = fmt::memory_buffer;
+
+    /** Write a string as JSON
+     *
+     * @param buffer is the buffer to append to
+     * @param string is the string
+     */
+    static void writeString(Buffer& buffer, const std::string_view string) noexcept
+    {
+        buffer.push_back('"');
+
+        const auto* iter = string.data();
+        const auto* const end = string.data() + string.size();
+        while (iter != end)
+        {
+            // Copy everything that does not need escaping in one go
+            const auto* const special = findSpecial(iter, end);
+            buffer.append(iter, special);
+            if (special == end)
+            {
+                break;
+            }
+            writeEscaped(buffer, *special);
+            iter = special + 1;
+        }
+
+        buffer.push_back('"');
+    }
+
+   private:
+    /** Find the first character that needs escaping
+     *
+     * @param begin is where to start looking
+     * @param end is where to stop looking
+     * @returns the first character that needs escaping, or end if there's none
+     */
+    [[nodiscard]] static const char* findSpecial(const char* begin, const char* const end) noexcept
+    {
+#if defined(__SSE2__)
+        // Look at 16 characters at once, which is what makes large strings cheap to write
+        const auto quote = _mm_set1_epi8('"');
+        const auto backslash = _mm_set1_epi8('\\');
+        const auto control = _mm_set1_epi8(0x1F);
+        while (end - begin >= static_cast<ptrdiff_t>(sizeof(__m128i)))
+        {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const auto isControl = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control);
+            const auto isSpecial =
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                          _mm_cmpeq_epi8(chunk, backslash)),
+                             isControl);
+
+            const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(isSpecial));
+            if (mask != 0)
+            {
+                return begin + __builtin_ctz(mask);
+            }
+            begin += sizeof(__m128i);
+        }
+#endif
+        return std::find_if(begin, end, isSpecial);
+    }
+
+    /** Does the character need escaping?
+     *
+     * @param character is the character
+     * @returns true if the character needs escaping, otherwise false
+     */
+    [[nodiscard]] static bool isSpecial(const char character) noexcept
+    {
+        return character == '"' || character == '\\' || static_cast<u_char>(character) < 0x20;
+    }
+
+    /** Write the escape sequence of a character
+     *
+     * @param buffer is the buffer to append to
+     * @param character is the character that needs escaping
+     */
+    static void writeEscaped(Buffer& buffer, const char character) noexcept
+    {
+        /// Represents the hexadecimal digits used by escape sequences
+        static constexpr std::string_view k_Hex{"0123456789abcdef"};
+
+        switch (character)
+        {
+            case '"':
+                return buffer.append(std::string_view{"\\\""});
+            case '\\':
+                return buffer.append(std::string_view{"\\\\"});
+            case '\n':
+                return buffer.append(std::string_view{"\\n"});
+            case '\r':
+                return buffer.append(std::string_view{"\\r"});
+            case '\t':
+                return buffer.append(std::string_view{"\\t"});
+            default:
+            {
+                const auto code = static_cast<u_char>(character);
+                const std::array escaped{'\\', 'u', '0', '0', k_Hex[code >> 4U],
+                                         k_Hex[code & 0xFU]};
+                return buffer.append(escaped.data(), escaped.data() + escaped.size());
+            }
+        }
+    }
+};
+
+}  // namespace pizza::json_escape
@@ -0,0 +1,253 @@
+/**
+ * @file pizza/log/binary.h
+ * @brief The binary format of logs
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/log/lazy.h>
+#include <pizza/support.h>
+
+namespace pizza::log::details
+{
+
+/**
+ * A format string, known at compile time
+ *
+ * @tparam Size is the size of the string literal
+ *
+ * @private
+ */
+template <size_t Size>
+struct FormatString final
+{
+    /** Constructor
+     *
+     * @param format is the format string
+     * @param site is where the format string is given, which makes every call site a format string
+     * of its own, and every call site a limiter of its own
+     */
+    consteval FormatString(  // NOLINT(google-explicit-constructor)
+        const char (&format)[Size],
+        const std::source_location site = std::source_location::current()) noexcept
+        : line{site.line()}, column{site.column()}
+    {
+        std::copy_n(format, Size, text.begin());
+
+        // The end of the path tells files apart well enough, and is what gets reported
+        const std::string_view path{site.file_name()};
+        const auto end = path.substr(path.size() - std::min(path.size(), file.size() - 1));
+        std::copy(end.begin(), end.end(), file.begin());
+    }
+
+    /** Get the format string
+     *
+     * @returns the format string
+     */
+    [[nodiscard]] constexpr std::string_view view() const noexcept
+    {
+        return {text.data(), Size - 1};
+    }
+
+    /** Get the id of the format string, its FNV-1a hash
+     *
+     * @returns the id
+     */
+    [[nodiscard]] constexpr uint64_t getId() const noexcept
+    {
+        uint64_t result = 14695981039346656037ULL;
+        for (const auto character : view())
+        {
+            result = (result ^ static_cast<u_char>(character)) * 1099511628211ULL;
+        }
+        return result;
+    }
+
+    /** Get the file of the call site
+     *
+     * @returns the end of the path of the file
+     */
+    [[nodiscard]] constexpr std::string_view getFile() const noexcept { return file.data(); }
+
+    std::array<char, Size> text{};  ///< Represents the format string, along with its terminator
+    std::array<char, 64> file{};    ///< Represents the end of the path of the call site
+    uint_least32_t line{0};         ///< Represents the line of the call site
+    uint_least32_t column{0};       ///< Represents the column of the call site
+};
+
+/// Tells whether a type is a lazy argument
+/// @private
+template <typename Type>
+constexpr bool k_IsLazy{false};
+
+/// Tells whether a type is a lazy argument
+/// @private
+template <typename Function>
+constexpr bool k_IsLazy<Lazy<Function>>{true};
+
+/**
+ * The binary format of logs
+ *
+ * @brief
+ * Binary logs defer formatting until they are decoded: a log carries the id of its format string
+ * and the raw bytes of its arguments, and every format string is written once, in a record of its
+ * own, before the first log which refers to it
+ *
+ * @details
+ * Records are laid out as follows, in the byte order of the host:
+ * - the magic, once at the beginning
+ * - a format: kind, id (8), size (4), format string
+ * - a log: kind, id (8), time (8), level (1), size (2), where, count (1), arguments
+ * - an argument: type, then 1 byte for Bool and Char, 8 for Signed, Unsigned and Double, or the
+ *   size (4) and the bytes for String
+ * Arguments of any other type are formatted on the spot, and written as strings.
+ *
+ * @private
+ */
+class Binary final
+{
+    STATIC_CLASS(Binary)
+
+   public:
+    /// Represents the buffer records are written into
+    using Buffer = fmt::memory_buffer;
+
+    /// Represents the kinds of records
+    enum class Kind : uint8_t
+    {
+        Format = 'F',  ///< Represents a format string
+        Log = 'L'      ///< Represents a log
+    };
+
+    /// Represents the types of arguments
+    enum class Type : uint8_t
+    {
+        Bool = 'b',      ///< Represents a bool
+        Char = 'c',      ///< Represents a char
+        Signed = 'i',    ///< Represents a signed integer
+        Unsigned = 'u',  ///< Represents an unsigned integer
+        Double = 'd',    ///< Represents a floating point number
+        String = 's'     ///< Represents a string
+    };
+
+    /// Represents the bytes binary logs start with, along with the version of the format
+    static constexpr std::string_view k_Magic{"PIZZALOG\x01"};
+
+    /** Write a format record
+     *
+     * @param buffer is the buffer to write into
+     * @param id is the id of the format string
+     * @param format is the format string
+     */
+    static void writeFormat(Buffer& buffer, const uint64_t id,
+                            const std::string_view format) noexcept
+    {
+        writeRaw(buffer, Kind::Format);
+        writeRaw(buffer, id);
+        writeRaw(buffer, static_cast<uint32_t>(format.size()));
+        buffer.append(format.data(), format.data() + format.size());
+    }
+
+    /** Write a log record
+     *
+     * @tparam Level is the type of the log level
+     * @tparam Args are the types of arguments
+     * @param buffer is the buffer to write into
+     * @param id is the id of the format string
+     * @param time is when the log occurs
+     * @param level is the log level
+     * @param where is where the log occurs
+     * @param args are the arguments
+     */
+    template <typename Level, typename... Args>
+    static void writeLog(Buffer& buffer, const uint64_t id, const std::time_t time,
+                         const Level level, std::string_view where, const Args&... args) noexcept
+    {
+        static_assert(sizeof...(Args) <= std::numeric_limits<uint8_t>::max(),
+                      "Log has too many arguments");
+
+        where = where.substr(0, std::numeric_limits<uint16_t>::max());
+        writeRaw(buffer, Kind::Log);
+        writeRaw(buffer, id);
+        writeRaw(buffer, static_cast<int64_t>(time));
+        writeRaw(buffer, static_cast<uint8_t>(level));
+        writeRaw(buffer, static_cast<uint16_t>(where.size()));
+        buffer.append(where.data(), where.data() + where.size());
+        writeRaw(buffer, static_cast<uint8_t>(sizeof...(Args)));
+        (writeArgument(buffer, args), ...);
+    }
+
+   private:
+    /** Write the bytes of a value
+     *
+     * @tparam Value is the type of the value
+     * @param buffer is the buffer to write into
+     * @param value is the value
+     */
+    template <typename Value>
+    static void writeRaw(Buffer& buffer, const Value value) noexcept
+    {
+        const auto* const bytes = reinterpret_cast<const char*>(&value);
+        buffer.append(bytes, bytes + sizeof(Value));
+    }
+
+    /** Write an argument
+     *
+     * @tparam Arg is the type of the argument
+     * @param buffer is the buffer to write into
+     * @param arg is the argument
+     */
+    template <typename Arg>
+    static void writeArgument(Buffer& buffer, const Arg& arg) noexcept
+    {
+        if constexpr (k_IsLazy<Arg>)
+        {
+            writeArgument(buffer, arg());
+        }
+        else if constexpr (std::is_same_v<Arg, bool>)
+        {
+            writeRaw(buffer, Type::Bool);
+            writeRaw(buffer, static_cast<uint8_t>(arg));
+        }
+        else if constexpr (std::is_same_v<Arg, char>)
+        {
+            writeRaw(buffer, Type::Char);
+            writeRaw(buffer, arg);
+        }
+        else if constexpr (std::is_integral_v<Arg> && std::is_signed_v<Arg>)
+        {
+            writeRaw(buffer, Type::Signed);
+            writeRaw(buffer, static_cast<int64_t>(arg));
+        }
+        else if constexpr (std::is_integral_v<Arg>)
+        {
+            writeRaw(buffer, Type::Unsigned);
+            writeRaw(buffer, static_cast<uint64_t>(arg));
+        }
+        else if constexpr (std::is_floating_point_v<Arg>)
+        {
+            writeRaw(buffer, Type::Double);
+            writeRaw(buffer, static_cast<double>(arg));
+        }
+        else if constexpr (std::is_pointer_v<Arg> && std::is_convertible_v<Arg, std::string_view>)
+        {
+            // A null C string has nothing to view, hence is written the way printf writes it
+            writeArgument(buffer, (arg == nullptr) ? std::string_view{"(null)"}
+                                                   : std::string_view{arg});
+        }
+        else if constexpr (std::is_convertible_v<const Arg&, std::string_view>)
+        {
+            const std::string_view text = arg;
+            writeRaw(buffer, Type::String);
+            writeRaw(buffer, static_cast<uint32_t>(text.size()));
+            buffer.append(text.data(), text.data() + text.size());
+        }
+        else
+        {
+            writeArgument(buffer, fmt::format("{}", arg));
+        }
+    }
+};
+
+}  // namespace pizza::log::details
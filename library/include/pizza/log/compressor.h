@@ -0,0 +1,129 @@
+/**
+ * @file pizza/log/compressor.h
+ * @brief The compressor of rotated log files
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/zlib/all.h>
+#include <pizza/support.h>
+#include <pizza/thread.h>
+
+namespace pizza::log::details
+{
+
+/**
+ * The compressor of rotated log files
+ *
+ * @brief
+ * Gzips rotated files one after the other on a thread of its own, so that neither the threads
+ * making logs nor the thread of the backend ever wait for zlib
+ *
+ * @details
+ * A file is replaced by its gzipped copy only once the copy is whole, so that a failure or a
+ * shutdown halfway through leaves the file as it was. Files still queued on shutdown are left as
+ * they are.
+ *
+ * @private
+ */
+class Compressor final
+{
+    DEFAULT_DESTRUCTIBLE_FINAL_CLASS(Compressor)
+
+   public:
+    /// Constructor
+    explicit Compressor() noexcept = default;
+
+    /** Queue a file to be compressed
+     *
+     * @param path is the path of the file
+     */
+    void push(std::string path) noexcept
+    {
+        {
+            const std::scoped_lock lock{m_mutex};
+            m_paths.push_back(std::move(path));
+        }
+        m_isPushed.notify_one();
+    }
+
+   private:
+    /** Compress the files queued until stopped
+     *
+     * @param stop tells when to stop
+     */
+    void compress(const std::stop_token& stop) noexcept
+    {
+        while (true)
+        {
+            std::string path;
+            {
+                std::unique_lock lock{m_mutex};
+                if (!m_isPushed.wait(lock, stop, [this] { return !m_paths.empty(); }))
+                {
+                    return;
+                }
+                path = std::move(m_paths.front());
+                m_paths.pop_front();
+            }
+            compressFile(path, stop);
+        }
+    }
+
+    /** Compress a file, and remove it once compressed
+     *
+     * @param path is the path of the file
+     * @param stop tells when to give up
+     */
+    static void compressFile(const std::string& path, const std::stop_token& stop) noexcept
+    {
+        const auto compressed = path + ".gz";
+        auto* const input = std::fopen(path.c_str(), "rb");
+        if (input == nullptr)
+        {
+            return;
+        }
+        auto* const output = gzopen(compressed.c_str(), "wb");
+        if (output == nullptr)
+        {
+            std::fclose(input);
+            return;
+        }
+
+        std::vector<char> chunk(k_Chunk);
+        auto isCompressed = true;
+        while (isCompressed && !stop.stop_requested())
+        {
+            const auto read = std::fread(chunk.data(), 1, chunk.size(), input);
+            if (read == 0)
+            {
+                break;
+            }
+            isCompressed = gzwrite(output, chunk.data(), static_cast<unsigned>(read)) ==
+                           static_cast<int>(read);
+        }
+        isCompressed = isCompressed && !stop.stop_requested() && std::ferror(input) == 0;
+        isCompressed = (gzclose(output) == Z_OK) && isCompressed;
+        std::fclose(input);
+
+        ::unlink(isCompressed ? path.c_str() : compressed.c_str());
+    }
+
+    /// Represents how many bytes are compressed at once
+    static constexpr size_t k_Chunk{size_t{1} << 20};
+
+    /// Guards the files queued
+    std::mutex m_mutex;
+
+    /// Tells that a file is queued
+    std::condition_variable_any m_isPushed;
+
+    /// The files queued
+    std::deque<std::string> m_paths;
+
+    /// The thread compressing the files, which goes first on destruction
+    std::jthread m_thread{makeThread([this](const std::stop_token& stop) { compress(stop); })};
+};
+
+}  // namespace pizza::log::details
@@ -0,0 +1,355 @@
+/**
+ * @file pizza/log/decoder.h
+ * @brief The decoder of binary logs
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/log/details.h>
+
+namespace pizza::log
+{
+
+/**
+ * The decoder of binary logs
+ *
+ * @brief
+ * Turns binary logs back into the lines text logs would have been, as they come, so that logs
+ * still being written can be decoded too
+ *
+ * @details
+ * Lines ahead of the magic are text logs, written before binary output was switched on, and are
+ * passed on as they are. The magic is skipped wherever else a record could begin, so that binary
+ * logs concatenated one after the other decode as one.
+ */
+class Decoder final
+{
+    DEFAULT_DESTRUCTIBLE_FINAL_CLASS(Decoder)
+
+   public:
+    /// Constructor
+    explicit Decoder() noexcept = default;
+
+    /** Decode binary logs
+     *
+     * @tparam Output is the type of the function receiving lines
+     * @param input is the bytes following those decoded so far
+     * @param output is called with every line decoded
+     * @returns how many bytes were decoded, the rest being the beginning of a record to be given
+     * again along with the bytes following it, or nothing if the bytes are malformed
+     */
+    template <typename Output>
+    [[nodiscard]] std::optional<size_t> decode(const std::string_view input,
+                                               const Output& output) noexcept
+    {
+        size_t decoded = 0;
+        while (decoded < input.size())
+        {
+            Reader reader{input.substr(decoded)};
+            const auto record = decodeRecord(reader, output);
+            if (!record)
+            {
+                return std::nullopt;
+            }
+            if (!*record)
+            {
+                break;
+            }
+            decoded += reader.getPosition();
+        }
+        return decoded;
+    }
+
+   private:
+    using Kind = details::Binary::Kind;
+    using Type = details::Binary::Type;
+
+    /// Reads the bytes of a record, as long as there are enough of them
+    class Reader final
+    {
+       public:
+        /** Constructor
+         *
+         * @param input is the bytes
+         */
+        explicit Reader(const std::string_view input) noexcept : m_input{input} {}
+
+        /** Read the bytes of a value
+         *
+         * @tparam Value is the type of the value
+         * @param value receives the value
+         * @returns true if read, otherwise false as the bytes ran out
+         */
+        template <typename Value>
+        [[nodiscard]] bool read(Value& value) noexcept
+        {
+            if (m_input.size() - m_position < sizeof(Value))
+            {
+                return false;
+            }
+            std::memcpy(&value, m_input.data() + m_position, sizeof(Value));
+            m_position += sizeof(Value);
+            return true;
+        }
+
+        /** Read bytes as they are
+         *
+         * @param size is how many bytes to read
+         * @param bytes receives the bytes
+         * @returns true if read, otherwise false as the bytes ran out
+         */
+        [[nodiscard]] bool read(const size_t size, std::string_view& bytes) noexcept
+        {
+            if (m_input.size() - m_position < size)
+            {
+                return false;
+            }
+            bytes = m_input.substr(m_position, size);
+            m_position += size;
+            return true;
+        }
+
+        /** Get how many bytes were read
+         *
+         * @returns the count of bytes
+         */
+        [[nodiscard]] size_t getPosition() const noexcept { return m_position; }
+
+        /** Get the bytes left to read
+         *
+         * @returns the bytes
+         */
+        [[nodiscard]] std::string_view getRest() const noexcept
+        {
+            return m_input.substr(m_position);
+        }
+
+       private:
+        /// The bytes
+        std::string_view m_input;
+
+        /// How many bytes were read
+        size_t m_position{0};
+    };
+
+    /** Decode a single record
+     *
+     * @tparam Output is the type of the function receiving lines
+     * @param reader reads the bytes of the record
+     * @param output is called with the line, if the record is a log or a line of text
+     * @returns true if decoded, false if its bytes ran out, or nothing if malformed
+     */
+    template <typename Output>
+    [[nodiscard]] std::optional<bool> decodeRecord(Reader& reader, const Output& output) noexcept
+    {
+        const auto rest = reader.getRest();
+        constexpr auto k_Magic = details::Binary::k_Magic;
+        if (rest.starts_with(k_Magic))
+        {
+            std::string_view magic;
+            m_isMagicFound = reader.read(k_Magic.size(), magic);
+            return true;
+        }
+        if (k_Magic.starts_with(rest))
+        {
+            return false;
+        }
+        if (!m_isMagicFound)
+        {
+            const auto end = rest.find('\n');
+            std::string_view line;
+            if (end == std::string_view::npos || !reader.read(end + 1, line))
+            {
+                return false;
+            }
+            output(line);
+            return true;
+        }
+
+        Kind kind{};
+        if (!reader.read(kind))
+        {
+            return false;
+        }
+        switch (kind)
+        {
+            case Kind::Format:
+            {
+                return decodeFormat(reader);
+            }
+            case Kind::Log:
+            {
+                return decodeLog(reader, output);
+            }
+            default:
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    /** Decode a format record, after its kind
+     *
+     * @param reader reads the bytes of the record
+     * @returns true if decoded, otherwise false as its bytes ran out
+     */
+    [[nodiscard]] bool decodeFormat(Reader& reader) noexcept
+    {
+        uint64_t id = 0;
+        uint32_t size = 0;
+        std::string_view format;
+        if (!reader.read(id) || !reader.read(size) || !reader.read(size, format))
+        {
+            return false;
+        }
+        m_formats.insert_or_assign(id, std::string{format});
+        return true;
+    }
+
+    /** Decode a log record, after its kind
+     *
+     * @tparam Output is the type of the function receiving lines
+     * @param reader reads the bytes of the record
+     * @param output is called with the line
+     * @returns true if decoded, false if its bytes ran out, or nothing if malformed
+     */
+    template <typename Output>
+    [[nodiscard]] std::optional<bool> decodeLog(Reader& reader, const Output& output) noexcept
+    {
+        uint64_t id = 0;
+        int64_t time = 0;
+        uint8_t level = 0;
+        uint16_t size = 0;
+        std::string_view where;
+        uint8_t count = 0;
+        if (!reader.read(id) || !reader.read(time) || !reader.read(level) || !reader.read(size) ||
+            !reader.read(size, where) || !reader.read(count))
+        {
+            return false;
+        }
+
+        fmt::dynamic_format_arg_store<fmt::format_context> args;
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            const auto arg = decodeArgument(reader, args);
+            if (!arg || !*arg)
+            {
+                return arg;
+            }
+        }
+
+        const auto format = m_formats.find(id);
+        const auto message =
+            (format == m_formats.end())
+                ? fmt::format("<unknown format {:016x}>", id)
+                : formatMessage(format->second, args);
+        output(fmt::format(details::k_Log, time,
+                           magic_enum::enum_name(static_cast<details::Level>(level)), where,
+                           message));
+        return true;
+    }
+
+    /** Decode an argument
+     *
+     * @param reader reads the bytes of the argument
+     * @param args receives the argument
+     * @returns true if decoded, false if its bytes ran out, or nothing if malformed
+     */
+    [[nodiscard]] static std::optional<bool> decodeArgument(
+        Reader& reader, fmt::dynamic_format_arg_store<fmt::format_context>& args) noexcept
+    {
+        Type type{};
+        if (!reader.read(type))
+        {
+            return false;
+        }
+        switch (type)
+        {
+            case Type::Bool:
+            {
+                return decodeValue<uint8_t, bool>(reader, args);
+            }
+            case Type::Char:
+            {
+                return decodeValue<char, char>(reader, args);
+            }
+            case Type::Signed:
+            {
+                return decodeValue<int64_t, int64_t>(reader, args);
+            }
+            case Type::Unsigned:
+            {
+                return decodeValue<uint64_t, uint64_t>(reader, args);
+            }
+            case Type::Double:
+            {
+                return decodeValue<double, double>(reader, args);
+            }
+            case Type::String:
+            {
+                uint32_t size = 0;
+                std::string_view text;
+                if (!reader.read(size) || !reader.read(size, text))
+                {
+                    return false;
+                }
+                args.push_back(std::string{text});
+                return true;
+            }
+            default:
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    /** Decode an argument of a fixed size
+     *
+     * @tparam Raw is the type the argument is written as
+     * @tparam Value is the type the argument is formatted as
+     * @param reader reads the bytes of the argument
+     * @param args receives the argument
+     * @returns true if decoded, otherwise false as its bytes ran out
+     */
+    template <typename Raw, typename Value>
+    [[nodiscard]] static bool decodeValue(
+        Reader& reader, fmt::dynamic_format_arg_store<fmt::format_context>& args) noexcept
+    {
+        Raw raw{};
+        if (!reader.read(raw))
+        {
+            return false;
+        }
+        args.push_back(static_cast<Value>(raw));
+        return true;
+    }
+
+    /** Format a message
+     *
+     * @param format is the format string
+     * @param args are the arguments
+     * @returns the message, or the format string as it is if the arguments do not fit it
+     */
+    [[nodiscard]] static std::string formatMessage(
+        const std::string_view format,
+        const fmt::dynamic_format_arg_store<fmt::format_context>& args) noexcept
+    {
+        try
+        {
+            return fmt::vformat(format, args);
+        }
+        catch (const fmt::format_error&)
+        {
+            return std::string{format};
+        }
+    }
+
+    /// Indicates if the magic was found, at the beginning
+    bool m_isMagicFound{false};
+
+    /// The format strings, by id
+    std::unordered_map<uint64_t, std::string> m_formats;
+};
+
+}  // namespace pizza::log
@@ -6,7 +6,23 @@
 
 #pragma once
 
+#include <external/posix/all.h>
+#include <pizza/json_escape.h>
+#include <pizza/log/binary.h>
+#include <pizza/log/file_sink.h>
+#include <pizza/log/limiter.h>
+#include <pizza/log/ring_buffer.h>
 #include <pizza/support.h>
+#include <pizza/thread.h>
+
+/// Represents the lowest level compiled in, by name, Info unless debugging
+#ifndef PIZZA_LOG_LEVEL
+#ifdef NDEBUG
+#define PIZZA_LOG_LEVEL Info
+#else
+#define PIZZA_LOG_LEVEL Debug
+#endif
+#endif
 
 namespace pizza::log::details
 {
@@ -22,10 +38,990 @@ enum class Level
     Fatal   ///< Represents Fatal logging level
 };
 
+/// Represents the lowest level compiled in, logs below it cost nothing at all
+/// @private
+static constexpr Level k_MinLevel = Level::PIZZA_LOG_LEVEL;
+
 /// Represents the format of each log
 /// @private
 static constexpr std::string_view k_Log = "{}:{}:{}:{}\n";
 
+/// Represents the streams logs go to
+/// @private
+enum class Stream : uint32_t
+{
+    Stdout,  ///< Represents stdout
+    Stderr   ///< Represents stderr
+};
+
+/// Represents what becomes of a log which finds the ring of its thread full
+enum class Overflow
+{
+    Drop,   ///< Represents dropping the log
+    Block,  ///< Represents waiting for the ring to have room for the log
+    Count   ///< Represents dropping the log, and logging how many were dropped
+};
+
+/// Represents how logs are written out
+enum class Output
+{
+    Text,    ///< Represents lines of text, formatted by the threads making them
+    Binary,  ///< Represents binary records, formatted only once decoded, all of them to stdout
+    Json     ///< Represents JSON lines, formatted by the threads making them
+};
+
+/// Represents the options of the backend
+struct Options final
+{
+    size_t capacity{size_t{1} << 18};    ///< Represents the bytes of the ring of every thread
+    Overflow overflow{Overflow::Count};  ///< Represents what becomes of logs which do not fit
+    Level level{Level::Debug};           ///< Represents the lowest level written
+    Output output{Output::Text};         ///< Represents how logs are written out
+    Sampling sampling{};                 ///< Represents how many logs every call site writes
+    File file{};                         ///< Represents the file logs are written to, if any
+};
+
+/** Write a log as a JSON line
+ *
+ * @param buffer is the buffer to append to
+ * @param time is when the log occurs
+ * @param level is the log level
+ * @param where is where the log occurs
+ * @param message is the message
+ * @param count is how many logs the message is about, written only if any
+ *
+ * @private
+ */
+inline void writeJsonLine(fmt::memory_buffer& buffer, const std::time_t time, const Level level,
+                          const std::string_view where, const std::string_view message,
+                          const uint64_t count = 0) noexcept
+{
+    using json_escape::JsonEscape;
+
+    fmt::format_to(std::back_inserter(buffer), R"({{"time":{},"level":"{}","logger":)", time,
+                   magic_enum::enum_name(level));
+    JsonEscape::writeString(buffer, where);
+    buffer.append(std::string_view{R"(,"message":)"});
+    JsonEscape::writeString(buffer, message);
+    if (count != 0)
+    {
+        fmt::format_to(std::back_inserter(buffer), R"(,"count":{})", count);
+    }
+    buffer.append(std::string_view{"}\n"});
+}
+
+/**
+ * The logging Backend
+ *
+ * @brief
+ * The Backend takes formatted logs off the threads making them, and writes them out on a thread of
+ * its own, so that no thread making a log ever waits for stdio or for another thread
+ *
+ * @details
+ * Every thread pushes its logs into a ring of its own, without locks, and the thread of the
+ * backend drains all rings in turn, handing every record of a ring to a single writev per stream.
+ * The time logs are stamped with is kept by the thread of the backend too, which is all the
+ * precision a timestamp in seconds needs. So is the file logs are written to, if any, which is
+ * rotated without any thread making logs waiting for it.
+ * Logs are flushed on shutdown, and on every fatal log, before the process gets to go down.
+ *
+ * @private
+ */
+class Backend final
+{
+    SINGLETON_CLASS(Backend)
+
+   public:
+    /** Configure the backend
+     *
+     * @param options are the options of the backend
+     *
+     * @note The capacity applies to the rings of threads which have not logged yet
+     */
+    void configure(const Options& options) noexcept
+    {
+        m_capacity.store(options.capacity, std::memory_order_relaxed);
+        m_overflow.store(options.overflow, std::memory_order_relaxed);
+        m_level.store(options.level, std::memory_order_relaxed);
+        m_output.store(options.output, std::memory_order_relaxed);
+        m_sampling.store(options.sampling, std::memory_order_relaxed);
+        setFile(options.file);
+    }
+
+    /** Set the file logs are written to
+     *
+     * @param file is the file, whose path is empty for stdout and stderr
+     *
+     * @note The file is opened by the thread of the backend, on its next round
+     */
+    void setFile(File file) noexcept
+    {
+        {
+            const std::scoped_lock lock{m_mutex};
+            m_file = std::move(file);
+        }
+        m_isFileChanged.store(true, std::memory_order_release);
+    }
+
+    /** Set the lowest level written
+     *
+     * @param level is the level
+     */
+    void setLevel(const Level level) noexcept { m_level.store(level, std::memory_order_relaxed); }
+
+    /** Get the lowest level written
+     *
+     * @returns the level
+     */
+    [[nodiscard]] Level getLevel() const noexcept
+    {
+        return m_level.load(std::memory_order_relaxed);
+    }
+
+    /** Set how logs are written out
+     *
+     * @param output is the output
+     */
+    void setOutput(const Output output) noexcept
+    {
+        m_output.store(output, std::memory_order_relaxed);
+    }
+
+    /** Get how logs are written out
+     *
+     * @returns the output
+     */
+    [[nodiscard]] Output getOutput() const noexcept
+    {
+        return m_output.load(std::memory_order_relaxed);
+    }
+
+    /** Set how many logs every call site writes
+     *
+     * @param sampling is the sampling
+     */
+    void setSampling(const Sampling sampling) noexcept
+    {
+        m_sampling.store(sampling, std::memory_order_relaxed);
+    }
+
+    /** Get how many logs every call site writes
+     *
+     * @returns the sampling
+     */
+    [[nodiscard]] Sampling getSampling() const noexcept
+    {
+        return m_sampling.load(std::memory_order_relaxed);
+    }
+
+    /** Make the limiter of a call site, which the backend reports the suppressed logs of
+     *
+     * @param format is the format string of the call site
+     * @param file is the file of the call site
+     * @param line is the line of the call site
+     * @returns the limiter, which lives as long as the backend
+     */
+    [[nodiscard]] Limiter& makeLimiter(const std::string_view format, const std::string_view file,
+                                       const uint_least32_t line) noexcept
+    {
+        const std::scoped_lock lock{m_mutex};
+        return m_limiters.emplace_back(fmt::format("{} ({}:{})", format, file, line));
+    }
+
+    /** Find the limiter of a call site whose message is known only at run time, made on first use
+     *
+     * @param site is the call site
+     * @param message is the message, reported as the first one logged at the call site
+     * @returns the limiter, which lives as long as the backend
+     */
+    [[nodiscard]] Limiter& findLimiter(const std::source_location& site,
+                                       const std::string_view message) noexcept
+    {
+        // Looked up for every log, hence by every thread on its own first, not to contend
+        const Site key{site.line(), site.column(), site.file_name()};
+        thread_local std::map<Site, Limiter*> limiters;
+        if (const auto iter = limiters.find(key); iter != limiters.end())
+        {
+            return *iter->second;
+        }
+
+        const std::scoped_lock lock{m_mutex};
+        auto& limiter = m_siteLimiters[key];
+        if (limiter == nullptr)
+        {
+            limiter = &m_limiters.emplace_back(
+                fmt::format("{} ({}:{})", message, site.file_name(), site.line()));
+        }
+        limiters.emplace(key, limiter);
+        return *limiter;
+    }
+
+    /** Register the format string of binary logs, to be written ahead of them
+     *
+     * @param id is the id of the format string
+     * @param format is the format string
+     * @returns true if registered for the first time, otherwise false
+     */
+    bool registerFormat(const uint64_t id, const std::string_view format) noexcept
+    {
+        const std::scoped_lock lock{m_mutex};
+        if (!m_formatIds.insert(id).second)
+        {
+            return false;
+        }
+
+        if (m_formats.empty())
+        {
+            m_formats.emplace_back(Binary::k_Magic);
+        }
+        Binary::Buffer buffer;
+        Binary::writeFormat(buffer, id, format);
+        m_formats.emplace_back(buffer.data(), buffer.size());
+        return true;
+    }
+
+    /** Get the time logs are stamped with
+     *
+     * @returns the time, as of the last round of the backend
+     */
+    [[nodiscard]] std::time_t getNow() const noexcept
+    {
+        return m_now.load(std::memory_order_relaxed);
+    }
+
+    /** Push a log
+     *
+     * @param stream is the stream the log goes to
+     * @param record is the formatted log
+     */
+    void push(const Stream stream, const std::string_view record) noexcept
+    {
+        auto& ring = getRing();
+        if (record.size() > ring.getMaxRecord() && getOutput() == Output::Binary)
+        {
+            // A binary log cut short would garble every log after it
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (ring.tryPush(static_cast<uint32_t>(stream), record))
+        {
+            return;
+        }
+
+        switch (m_overflow.load(std::memory_order_relaxed))
+        {
+            case Overflow::Block:
+            {
+                while (!ring.tryPush(static_cast<uint32_t>(stream), record) &&
+                       !m_isStopping.load(std::memory_order_relaxed))
+                {
+                    std::this_thread::yield();
+                }
+                return;
+            }
+            case Overflow::Count:
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            default:
+            {
+                return;
+            }
+        }
+    }
+
+    /// Wait until every log pushed so far is written, or for a second at most
+    void flush() noexcept
+    {
+        std::vector<std::pair<std::shared_ptr<RingBuffer>, size_t>> pending;
+        {
+            const std::scoped_lock lock{m_mutex};
+            for (const auto& ring : m_rings)
+            {
+                pending.emplace_back(ring, ring->getHead());
+            }
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + k_FlushTimeout;
+        for (const auto& [ring, head] : pending)
+        {
+            while (ring->getTail() < head && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(k_Idle / 10);
+            }
+        }
+    }
+
+   private:
+    /// Represents a call site, by its line, column and file, the quickest to tell apart first
+    using Site = std::tuple<uint_least32_t, uint_least32_t, std::string_view>;
+
+    /// Represents the ring of a thread, for as long as the thread lives
+    struct Producer final
+    {
+        NOT_COPYABLE_CLASS(Producer)
+        IMMOVEABLE_CLASS(Producer)
+
+        /** Constructor, hands the ring over to the backend
+         *
+         * @param backend is the backend
+         */
+        explicit Producer(Backend& backend) noexcept
+            : ring{std::make_shared<RingBuffer>(
+                  backend.m_capacity.load(std::memory_order_relaxed))}
+        {
+            const std::scoped_lock lock{backend.m_mutex};
+            backend.m_rings.push_back(ring);
+        }
+
+        /// Destructor, the backend lets go of the ring once it is drained
+        ~Producer() noexcept { ring->abandon(); }
+
+        const std::shared_ptr<RingBuffer> ring;  ///< Represents the ring
+    };
+
+    /** Get the ring of the calling thread
+     *
+     * @returns the ring
+     */
+    [[nodiscard]] RingBuffer& getRing() noexcept
+    {
+        thread_local const Producer producer{*this};
+        return *producer.ring;
+    }
+
+    /** Drain the rings until stopped
+     *
+     * @param stop tells when to stop
+     */
+    void drain(const std::stop_token& stop) noexcept
+    {
+        while (!stop.stop_requested())
+        {
+            m_now.store(std::time(nullptr), std::memory_order_relaxed);
+            if (!drainRings())
+            {
+                std::this_thread::sleep_for(k_Idle);
+            }
+        }
+
+        // Whatever was logged up to the end
+        m_isStopping.store(true, std::memory_order_relaxed);
+        drainRings();
+    }
+
+    /** Drain every ring once
+     *
+     * @returns true if there was anything to drain, otherwise false
+     */
+    bool drainRings() noexcept
+    {
+        {
+            const std::scoped_lock lock{m_mutex};
+            m_draining.assign(m_rings.begin(), m_rings.end());
+        }
+        if (m_isFileChanged.exchange(false, std::memory_order_acquire))
+        {
+            openFile();
+        }
+
+        // Every ring is visited before anything is written, so that a round takes a single write
+        m_released.clear();
+        for (const auto& ring : m_draining)
+        {
+            // Looked at first, so that nothing pushed before the thread went away is left behind
+            const auto isAbandoned = ring->isAbandoned();
+
+            const auto position = ring->visit(
+                [this](const uint32_t stream, const std::string_view record)
+                {
+                    m_batches.at(stream).push_back(
+                        {const_cast<char*>(record.data()), record.size()});  // NOLINT
+                });
+            if (position != ring->getTail())
+            {
+                m_released.emplace_back(ring.get(), position);
+            }
+
+            // The ring lives on in m_draining until the next round, hence until released
+            if (isAbandoned)
+            {
+                const std::scoped_lock lock{m_mutex};
+                std::erase(m_rings, ring);
+            }
+        }
+
+        if (!m_released.empty())
+        {
+            writeBatches();
+            for (const auto& [ring, position] : m_released)
+            {
+                ring->release(position);
+            }
+        }
+
+        report();
+        return !m_released.empty();
+    }
+
+    /// Write the records drained, to the file if any, otherwise to stdout and stderr
+    void writeBatches() noexcept
+    {
+        auto& out = m_batches.at(static_cast<size_t>(Stream::Stdout));
+        auto& err = m_batches.at(static_cast<size_t>(Stream::Stderr));
+        if (m_sink.isOpen())
+        {
+            // Both streams go to the file, in a single batch
+            out.insert(out.end(), err.begin(), err.end());
+            err.clear();
+
+            const auto now = getNow();
+            if (m_sink.lock(now) && m_sink.isDue(now, getSize(out)))
+            {
+                rotateFile(now);
+            }
+            m_sink.unlock();
+        }
+
+        writeOut(Stream::Stdout, out);
+        writeOut(Stream::Stderr, err);
+    }
+
+    /** Write a batch of records to its stream, or to the file if any, all of it, and clear it
+     *
+     * @param stream is the stream of the records
+     * @param batch is the batch
+     */
+    void writeOut(const Stream stream, std::vector<iovec>& batch) noexcept
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+        if (m_sink.lock(getNow()))
+        {
+            // The path may have been opened anew, by a rotation of another process
+            if (m_sink.getGeneration() != m_formatsGeneration)
+            {
+                m_formatsGeneration = m_sink.getGeneration();
+                m_formatsWritten = 0;
+            }
+            writeFormats(m_sink.getDescriptor());
+            writeAll(m_sink.prepareWrite(getSize(batch)), batch);
+            m_sink.unlock();
+            return;
+        }
+
+        const auto descriptor = (stream == Stream::Stdout) ? STDOUT_FILENO : STDERR_FILENO;
+        if (stream == Stream::Stdout)
+        {
+            writeFormats(descriptor);
+        }
+        writeAll(descriptor, batch);
+    }
+
+    /// Open the file set last, in place of the one open if any
+    void openFile() noexcept
+    {
+        File file;
+        {
+            const std::scoped_lock lock{m_mutex};
+            file = m_file;
+        }
+
+        // A binary file is only readable along with the formats its logs use
+        m_formatsWritten = 0;
+        if (!m_sink.open(file, getNow()))
+        {
+            writeNotice(getNow(), fmt::format("Failed to open {}, logging to stdio", file.path), 0);
+        }
+    }
+
+    /** Rotate the file
+     *
+     * @param now is the time the file is rotated at
+     */
+    void rotateFile(const std::time_t now) noexcept
+    {
+        if (!m_sink.rotate(now))
+        {
+            writeNotice(now, fmt::format("Failed to reopen {}, logging to stdio", m_sink.getPath()),
+                        0);
+        }
+    }
+
+    /// Log how many logs were dropped, suppressed or lost, once a second, and once more at the end
+    void report() noexcept
+    {
+        const auto now = getNow();
+        if (now == m_reportedAt && !m_isStopping.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        m_reportedAt = now;
+
+        const auto dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped != 0)
+        {
+            writeNotice(now, fmt::format("{} logs dropped, rings had no room", dropped), dropped);
+        }
+
+        // Taken before written, as the notice may well fail to be written too
+        if (const auto lost = std::exchange(m_lost, 0); lost != 0)
+        {
+            writeNotice(now, fmt::format("{} bytes of logs lost, writes failed", lost), 0);
+        }
+
+        // Taken under the lock, written outside of it, not to hold up call sites coming up
+        m_suppressed.clear();
+        {
+            const std::scoped_lock lock{m_mutex};
+            for (auto& limiter : m_limiters)
+            {
+                if (const auto suppressed = limiter.takeSuppressed(); suppressed != 0)
+                {
+                    m_suppressed.emplace_back(limiter.getSite(), suppressed);
+                }
+            }
+        }
+        for (const auto& [site, suppressed] : m_suppressed)
+        {
+            writeNotice(now, fmt::format("{} logs suppressed: {}", suppressed, site), suppressed);
+        }
+    }
+
+    /** Write a log of the backend itself to stderr, or to the file if any, as text unless the
+     * output is JSON
+     *
+     * @param now is the time of the log
+     * @param message is the message
+     * @param count is how many logs the message is about
+     */
+    void writeNotice(const std::time_t now, const std::string_view message,
+                     const uint64_t count) noexcept
+    {
+        m_notice.clear();
+        if (getOutput() == Output::Json)
+        {
+            writeJsonLine(m_notice, now, Level::Warn, k_Where, message, count);
+        }
+        else
+        {
+            fmt::format_to(std::back_inserter(m_notice), k_Log, now,
+                           magic_enum::enum_name(Level::Warn), k_Where, message);
+        }
+
+        m_noticeBatch.push_back({m_notice.data(), m_notice.size()});
+        if (getOutput() == Output::Binary)
+        {
+            // Binary files are made of binary records only
+            writeAll(STDERR_FILENO, m_noticeBatch);
+            return;
+        }
+        writeOut(Stream::Stderr, m_noticeBatch);
+    }
+
+    /**
+     * Write the format strings registered since last written, ahead of the records just drained,
+     * if the output is binary
+     *
+     * @param descriptor is the file descriptor the records are written to
+     *
+     * @note Formats are registered before the logs using them are pushed, hence every format a
+     * drained log uses is there to be written by now
+     */
+    void writeFormats(const int descriptor) noexcept
+    {
+        if (getOutput() != Output::Binary)
+        {
+            return;
+        }
+        {
+            const std::scoped_lock lock{m_mutex};
+            for (; m_formatsWritten < m_formats.size(); ++m_formatsWritten)
+            {
+                auto& format = m_formats[m_formatsWritten];
+                m_formatBatch.push_back({format.data(), format.size()});
+            }
+        }
+        writeAll(descriptor, m_formatBatch);
+    }
+
+    /** Get the size of a batch of records
+     *
+     * @param batch is the batch
+     * @returns the size in bytes
+     */
+    [[nodiscard]] static size_t getSize(const std::span<const iovec> batch) noexcept
+    {
+        return std::accumulate(batch.begin(), batch.end(), size_t{0},
+                               [](const size_t size, const iovec& record)
+                               { return size + record.iov_len; });
+    }
+
+    /** Write a batch of records, all of it, and clear it
+     *
+     * @param descriptor is the file descriptor to write to
+     * @param batch is the batch
+     *
+     * @note A descriptor which is not blocking is waited for to have room, for so long at most,
+     * and whatever is left unwritten is counted as lost, to be reported
+     */
+    void writeAll(const int descriptor, std::vector<iovec>& batch) noexcept
+    {
+        auto* iter = batch.data();
+        auto count = batch.size();
+        while (count > 0)
+        {
+            const auto written =
+                ::writev(descriptor, iter, static_cast<int>(std::min(count, k_MaxBatch)));
+            if (written < 0)
+            {
+                if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+                                       waitForRoom(descriptor)))
+                {
+                    continue;
+                }
+                m_lost += getSize({iter, iter + count});
+                break;
+            }
+
+            auto left = static_cast<size_t>(written);
+            while (count > 0 && left >= iter->iov_len)
+            {
+                left -= iter->iov_len;
+                ++iter;
+                --count;
+            }
+            if (count > 0)
+            {
+                iter->iov_base = static_cast<char*>(iter->iov_base) + left;
+                iter->iov_len -= left;
+            }
+        }
+        batch.clear();
+    }
+
+    /** Wait for a descriptor which is not blocking to have room for writing
+     *
+     * @param descriptor is the file descriptor
+     * @returns true if there is room, otherwise false as it is still full after a while
+     */
+    [[nodiscard]] static bool waitForRoom(const int descriptor) noexcept
+    {
+        pollfd writable{.fd = descriptor, .events = POLLOUT, .revents = 0};
+        return ::poll(&writable, 1, static_cast<int>(k_WriteTimeout.count())) == 1;
+    }
+
+    /// Represents how long the backend sleeps for when there is nothing to drain
+    static constexpr std::chrono::milliseconds k_Idle{1};
+
+    /// Represents how long a flush waits for at most
+    static constexpr std::chrono::seconds k_FlushTimeout{1};
+
+    /// Represents how long a write waits for room at most, before giving up on a batch
+    static constexpr std::chrono::milliseconds k_WriteTimeout{100};
+
+    /// Represents how many records a single writev writes at most
+    static constexpr size_t k_MaxBatch{1024};
+
+    /// Represents where the logs of the backend itself occur
+    static constexpr std::string_view k_Where{"log"};
+
+    /// The capacity of the rings to come
+    std::atomic<size_t> m_capacity{Options{}.capacity};
+
+    /// What becomes of logs which do not fit
+    std::atomic<Overflow> m_overflow{Options{}.overflow};
+
+    /// The lowest level written
+    std::atomic<Level> m_level{Options{}.level};
+
+    /// How logs are written out
+    std::atomic<Output> m_output{Options{}.output};
+
+    /// How many logs every call site writes
+    std::atomic<Sampling> m_sampling{Options{}.sampling};
+
+    /// The time logs are stamped with
+    std::atomic<std::time_t> m_now{std::time(nullptr)};
+
+    /// The logs dropped since last reported
+    std::atomic<uint64_t> m_dropped{0};
+
+    /// The bytes of logs which could not be written since last reported, owned by the thread of
+    /// the backend
+    size_t m_lost{0};
+
+    /// When the dropped logs were last reported, owned by the thread of the backend
+    std::time_t m_reportedAt{0};
+
+    /// Indicates if the backend is draining for the last time
+    std::atomic<bool> m_isStopping{false};
+
+    /// Guards the rings, the formats, the limiters and the file
+    std::mutex m_mutex;
+
+    /// The rings of every thread which has logged, and not gone since
+    std::vector<std::shared_ptr<RingBuffer>> m_rings;
+
+    /// The rings being drained, owned by the thread of the backend
+    std::vector<std::shared_ptr<RingBuffer>> m_draining;
+
+    /// The ids of the formats registered
+    std::unordered_set<uint64_t> m_formatIds;
+
+    /// The format records registered, behind the magic, which stay where they are once registered
+    std::deque<std::string> m_formats;
+
+    /// The format records written so far, to the file or the stream being written to
+    size_t m_formatsWritten{0};
+
+    /// The generation of the file the format records were written to, owned by the thread of
+    /// the backend
+    size_t m_formatsGeneration{0};
+
+    /// The format records being written, owned by the thread of the backend
+    std::vector<iovec> m_formatBatch;
+
+    /// The limiters of every call site, which stay where they are once made
+    std::deque<Limiter> m_limiters;
+
+    /// The limiters of the call sites whose messages are known only at run time
+    std::map<Site, Limiter*> m_siteLimiters;
+
+    /// The suppressed logs being reported, owned by the thread of the backend
+    std::vector<std::pair<std::string_view, uint64_t>> m_suppressed;
+
+    /// The log of the backend itself being written, owned by the thread of the backend
+    fmt::memory_buffer m_notice;
+
+    /// The log of the backend itself, as a batch, owned by the thread of the backend
+    std::vector<iovec> m_noticeBatch;
+
+    /// The rings drained and where to release them, owned by the thread of the backend
+    std::vector<std::pair<RingBuffer*, size_t>> m_released;
+
+    /// The file set last
+    File m_file;
+
+    /// Indicates if the file was set since last opened
+    std::atomic<bool> m_isFileChanged{false};
+
+    /// The file logs are written to, owned by the thread of the backend
+    FileSink m_sink;
+
+    /// The records being written to each stream, owned by the thread of the backend
+    std::array<std::vector<iovec>, 2> m_batches;
+
+    /// The thread draining the rings, which goes first on destruction
+    std::jthread m_thread{makeThread([this](const std::stop_token& stop) { drain(stop); })};
+};
+
+/**
+ * A message known only at run time, along with where it is logged from
+ *
+ * @note Made from anything a string view is made from, right where it is logged from, as the
+ * argument of a log function
+ *
+ * @private
+ */
+struct Message final
+{
+    /** Constructor
+     *
+     * @tparam What is the type of the message
+     * @param what_ is the message
+     * @param site_ is where the message is logged from
+     */
+    template <typename What>
+        requires std::is_convertible_v<const What&, std::string_view>
+    Message(const What& what_,  // NOLINT(google-explicit-constructor)
+            const std::source_location site_ = std::source_location::current()) noexcept
+        : what{what_}, site{site_}
+    {
+    }
+
+    std::string_view what;      ///< Represents the message
+    std::source_location site;  ///< Represents where the message is logged from
+};
+
+/** Write log as text
+ *
+ * @tparam Args are the types of arguments
+ * @param stream is the stream to write to
+ * @param level is the log level
+ * @param where is where this log occurs
+ * @param what is the message to print
+ * @param args are the arguments
+ *
+ * @private
+ */
+template <typename... Args>
+void writeText(const Stream stream, const Level level, const std::string_view where,
+               const std::string_view what, const Args&... args) noexcept
+{
+    thread_local fmt::memory_buffer buffer;
+    buffer.clear();
+
+    auto& backend = Backend::getBackend();
+    fmt::format_to(std::back_inserter(buffer), "{}:{}:{}:", backend.getNow(),
+                   magic_enum::enum_name(level), where);
+    fmt::vformat_to(std::back_inserter(buffer), what, fmt::make_format_args(args...));
+    buffer.push_back('\n');
+    backend.push(stream, {buffer.data(), buffer.size()});
+}
+
+/** Write log as a JSON line
+ *
+ * @tparam Args are the types of arguments
+ * @param stream is the stream to write to
+ * @param level is the log level
+ * @param where is where this log occurs
+ * @param what is the message to print
+ * @param args are the arguments
+ *
+ * @private
+ */
+template <typename... Args>
+void writeJson(const Stream stream, const Level level, const std::string_view where,
+               const std::string_view what, const Args&... args) noexcept
+{
+    thread_local fmt::memory_buffer message;
+    message.clear();
+    fmt::vformat_to(std::back_inserter(message), what, fmt::make_format_args(args...));
+
+    thread_local fmt::memory_buffer buffer;
+    buffer.clear();
+
+    auto& backend = Backend::getBackend();
+    writeJsonLine(buffer, backend.getNow(), level, where, {message.data(), message.size()});
+    backend.push(stream, {buffer.data(), buffer.size()});
+}
+
+/** Write log as a binary record, to stdout
+ *
+ * @tparam What is the message to print
+ * @tparam Args are the types of arguments
+ * @param level is the log level
+ * @param where is where this log occurs
+ * @param args are the arguments
+ *
+ * @private
+ */
+template <FormatString What, typename... Args>
+void writeBinary(const Level level, const std::string_view where, const Args&... args) noexcept
+{
+    auto& backend = Backend::getBackend();
+
+    // Once for every message, rather than for every log
+    [[maybe_unused]] static const auto isRegistered =
+        backend.registerFormat(What.getId(), What.view());
+
+    thread_local Binary::Buffer buffer;
+    buffer.clear();
+
+    Binary::writeLog(buffer, What.getId(), backend.getNow(), level, where, args...);
+    backend.push(Stream::Stdout, {buffer.data(), buffer.size()});
+}
+
+/** Write log
+ *
+ * @tparam Args are the types of arguments
+ * @param stream is the stream to write to
+ * @param level is the log level
+ * @param where is where this log occurs
+ * @param what is the message to print
+ * @param args are the arguments
+ *
+ * @note Every call site but those of fatal logs is limited to the logs set by the sampling of the
+ * backend
+ *
+ * @note Binary logs of messages known only at run time are formatted right away
+ *
+ * @private
+ */
+template <typename... Args>
+void write(const Stream stream, const Level level, const std::string_view where,
+           const Message& what, const Args&... args) noexcept
+{
+    auto& backend = Backend::getBackend();
+    if (const auto sampling = backend.getSampling(); sampling.rate != 0 && level != Level::Fatal &&
+        !backend.findLimiter(what.site, what.what).tryAcquire(backend.getNow(), sampling))
+    {
+        return;
+    }
+
+    switch (backend.getOutput())
+    {
+        case Output::Binary:
+        {
+            break;
+        }
+        case Output::Json:
+        {
+            return writeJson(stream, level, where, what.what, args...);
+        }
+        default:
+        {
+            return writeText(stream, level, where, what.what, args...);
+        }
+    }
+
+    thread_local fmt::memory_buffer message;
+    message.clear();
+
+    fmt::vformat_to(std::back_inserter(message), what.what, fmt::make_format_args(args...));
+    writeBinary<"{}">(level, where, std::string_view{message.data(), message.size()});
+}
+
+/** Write log, of a message known at compile time
+ *
+ * @tparam What is the message to print
+ * @tparam Args are the types of arguments
+ * @param stream is the stream to write to
+ * @param level is the log level
+ * @param where is where this log occurs
+ * @param args are the arguments
+ *
+ * @note Every call site but those of fatal logs is limited to the logs set by the sampling of the
+ * backend
+ *
+ * @private
+ */
+template <FormatString What, typename... Args>
+void write(const Stream stream, const Level level, const std::string_view where,
+           const Args&... args) noexcept
+{
+    // Messages known at compile time are checked against their arguments at compile time too
+    [[maybe_unused]] constexpr fmt::format_string<const Args&...> k_Checked{What.view()};
+
+    // Every call site is a format string of its own, hence a limiter of its own
+    auto& backend = Backend::getBackend();
+    static auto& limiter = backend.makeLimiter(What.view(), What.getFile(), What.line);
+    if (level != Level::Fatal && !limiter.tryAcquire(backend.getNow(), backend.getSampling()))
+    {
+        return;
+    }
+
+    switch (backend.getOutput())
+    {
+        case Output::Binary:
+        {
+            return writeBinary<What>(level, where, args...);
+        }
+        case Output::Json:
+        {
+            return writeJson(stream, level, where, What.view(), args...);
+        }
+        default:
+        {
+            return writeText(stream, level, where, What.view(), args...);
+        }
+    }
+}
+
 /** Write log to stdout
  *
  * @tparam Args are the types of arguments
@@ -37,11 +1033,10 @@ static constexpr std::string_view k_Log = "{}:{}:{}:{}\n";
  * @private
  */
 template <typename... Args>
-void writeStdout(const Level level, const std::string_view where, const std::string_view what,
+void writeStdout(const Level level, const std::string_view where, const Message& what,
                  const Args&... args) noexcept
 {
-    fmt::print(stdout, k_Log, std::time(nullptr), magic_enum::enum_name(level), where,
-               fmt::vformat(what, fmt::make_format_args(args...)));
+    write(Stream::Stdout, level, where, what, args...);
 }
 
 /** Write log to stderr
@@ -55,11 +1050,42 @@ void writeStdout(const Level level, const std::string_view where, const std::str
  * @private
  */
 template <typename... Args>
-void writeStderr(const Level level, const std::string_view where, const std::string_view what,
+void writeStderr(const Level level, const std::string_view where, const Message& what,
                  const Args&... args) noexcept
 {
-    fmt::print(stderr, k_Log, std::time(nullptr), magic_enum::enum_name(level), where,
-               fmt::vformat(what, fmt::make_format_args(args...)));
+    write(Stream::Stderr, level, where, what, args...);
+}
+
+/** Write log to stdout, of a message known at compile time
+ *
+ * @tparam What is the message to print
+ * @tparam Args are the types of arguments
+ * @param level is the log level
+ * @param where is where this log occurs
+ * @param args are the arguments
+ *
+ * @private
+ */
+template <FormatString What, typename... Args>
+void writeStdout(const Level level, const std::string_view where, const Args&... args) noexcept
+{
+    write<What>(Stream::Stdout, level, where, args...);
+}
+
+/** Write log to stderr, of a message known at compile time
+ *
+ * @tparam What is the message to print
+ * @tparam Args are the types of arguments
+ * @param level is the log level
+ * @param where is where this log occurs
+ * @param args are the arguments
+ *
+ * @private
+ */
+template <FormatString What, typename... Args>
+void writeStderr(const Level level, const std::string_view where, const Args&... args) noexcept
+{
+    write<What>(Stream::Stderr, level, where, args...);
 }
 
 }  // namespace pizza::log::details
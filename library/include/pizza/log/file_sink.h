@@ -0,0 +1,291 @@
+/**
+ * @file pizza/log/file_sink.h
+ * @brief The file logs are written to, rotated as it grows old or large
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/posix/all.h>
+#include <pizza/log/compressor.h>
+#include <pizza/support.h>
+
+namespace pizza::log::details
+{
+
+/// Represents the file logs are written to
+struct File final
+{
+    std::string path{};                  ///< Represents the path, empty for stdout and stderr
+    size_t rotateSize{size_t{64} << 20};  ///< Represents the size rotated at, 0 for never
+    std::chrono::seconds rotateAge{0};    ///< Represents the age rotated at, 0 for never
+    bool isCompressed{false};             ///< Represents whether rotated files are gzipped
+};
+
+/**
+ * The file logs are written to
+ *
+ * @brief
+ * Owned by the thread of the backend, which hands it whole batches of records, so that logs cost
+ * the threads making them no system call at all, rotations included
+ *
+ * @details
+ * The file is opened for appending, and has its blocks allocated ahead of the writes, by the size
+ * it rotates at, without the allocated blocks counting towards its size. A rotation releases the
+ * blocks left over, renames the file after the time it rotates at, and opens the path anew. Rotated
+ * files are handed over to the compressor, if they are to be compressed.
+ * Another process may append to the same file, such as a successor taking over, hence writes hold
+ * a shared lock on the file, and rotations an exclusive one. A write finding the path renamed by a
+ * rotation of the other process opens the path anew, rather than writing to the rotated file,
+ * which is why the size is taken from the file rather than from the writes.
+ *
+ * @private
+ */
+class FileSink final
+{
+    NOT_COPYABLE_CLASS(FileSink)
+    IMMOVEABLE_CLASS(FileSink)
+
+   public:
+    /// Constructor
+    explicit FileSink() noexcept = default;
+
+    /// Destructor, closes the file
+    ~FileSink() noexcept { close(); }
+
+    /** Open a file, in place of the one open if any
+     *
+     * @param file is the file
+     * @param now is the time the file is opened at
+     * @returns true if opened, or if there is no file to open, otherwise false
+     */
+    bool open(const File& file, const std::time_t now) noexcept
+    {
+        close();
+        m_file = file;
+        if (m_file.isCompressed && !m_compressor)
+        {
+            m_compressor = std::make_unique<Compressor>();
+        }
+        return m_file.path.empty() || reopen(now);
+    }
+
+    /** Is a file open?
+     *
+     * @returns true if logs are written to the file, otherwise false
+     */
+    [[nodiscard]] bool isOpen() const noexcept { return m_descriptor >= 0; }
+
+    /** Get the descriptor of the file
+     *
+     * @returns the descriptor, negative if none is open
+     */
+    [[nodiscard]] int getDescriptor() const noexcept { return m_descriptor; }
+
+    /** Get the path of the file
+     *
+     * @returns the path
+     */
+    [[nodiscard]] const std::string& getPath() const noexcept { return m_file.path; }
+
+    /** Lock the file for writing, opening the path anew if the file was rotated by another process
+     *
+     * @param now is the time the path is opened at, if it is
+     * @returns true if locked, otherwise false as no file is open
+     */
+    [[nodiscard]] bool lock(const std::time_t now) noexcept
+    {
+        while (isOpen())
+        {
+            ::flock(m_descriptor, LOCK_SH);
+            struct stat status = {};
+            if (isCurrent(status))
+            {
+                m_size = static_cast<size_t>(status.st_size);
+                return true;
+            }
+
+            // The file is the other process's to release the blocks of, as it rotated it
+            ::close(m_descriptor);
+            m_descriptor = -1;
+            reopen(now);
+        }
+        return false;
+    }
+
+    /// Unlock the file, once written
+    void unlock() const noexcept { ::flock(m_descriptor, LOCK_UN); }
+
+    /** Get how many times the path was opened, for whatever was written ahead of the logs to be
+     * written again
+     *
+     * @returns the count
+     */
+    [[nodiscard]] size_t getGeneration() const noexcept { return m_generation; }
+
+    /** Is the file due for a rotation, before a batch is written?
+     *
+     * @param now is the time
+     * @param bytes is the size of the batch
+     * @returns true if the file is to be rotated, otherwise false
+     *
+     * @note The file is to be locked, for its size to be up to date
+     */
+    [[nodiscard]] bool isDue(const std::time_t now, const size_t bytes) const noexcept
+    {
+        if (!isOpen() || m_size == 0)
+        {
+            return false;
+        }
+        return (m_file.rotateSize != 0 && m_size + bytes > m_file.rotateSize) ||
+               (m_file.rotateAge.count() != 0 && now - m_openedAt >= m_file.rotateAge.count());
+    }
+
+    /** Rotate the file, unless the other process appending to it did so already
+     *
+     * @param now is the time the file is rotated at
+     * @returns true if rotated, otherwise false as the file could not be opened anew
+     */
+    bool rotate(const std::time_t now) noexcept
+    {
+        // Held until closed, so that no write of the other process lands in the rotated file
+        ::flock(m_descriptor, LOCK_EX);
+        struct stat status = {};
+        if (!isCurrent(status))
+        {
+            ::close(m_descriptor);
+            m_descriptor = -1;
+            return reopen(now);
+        }
+
+        // Named after the time, made unique by a count if rotated more than once a second, whether
+        // the files rotated before are compressed by now or not
+        auto rotated = fmt::format("{}.{}", m_file.path, now);
+        for (size_t i = 1; isTaken(rotated); ++i)
+        {
+            rotated = fmt::format("{}.{}.{}", m_file.path, now, i);
+        }
+        const auto isRenamed = ::rename(m_file.path.c_str(), rotated.c_str()) == 0;
+        close();
+        if (isRenamed && m_compressor)
+        {
+            m_compressor->push(std::move(rotated));
+        }
+        return reopen(now);
+    }
+
+    /** Get the descriptor a batch is written to, with room made for it
+     *
+     * @param bytes is the size of the batch
+     * @returns the descriptor
+     *
+     * @note The file is to be locked
+     */
+    [[nodiscard]] int prepareWrite(const size_t bytes) noexcept
+    {
+        if (m_size + bytes > m_allocated)
+        {
+            const auto step = std::max({m_file.rotateSize, k_Allocation, bytes});
+            if (::fallocate(m_descriptor, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_size),
+                            static_cast<off_t>(step)) == 0)
+            {
+                m_allocated = m_size + step;
+            }
+        }
+        return m_descriptor;
+    }
+
+    /// Close the file, if open, and release the blocks allocated past its end
+    void close() noexcept
+    {
+        if (!isOpen())
+        {
+            return;
+        }
+
+        // Nothing is appended while locked exclusively, hence the size is that of what was written,
+        // and releasing the blocks past it neither cuts logs short nor pads the file with zeros
+        ::flock(m_descriptor, LOCK_EX);
+        struct stat status = {};
+        if (::fstat(m_descriptor, &status) == 0)
+        {
+            ::ftruncate(m_descriptor, status.st_size);
+        }
+        ::close(m_descriptor);
+        m_descriptor = -1;
+    }
+
+   private:
+    /** Is the file open still the one at the path?
+     *
+     * @param status receives the status of the file open
+     * @returns true if so, otherwise false as it was rotated or removed
+     */
+    [[nodiscard]] bool isCurrent(struct stat& status) const noexcept
+    {
+        struct stat current = {};
+        return ::fstat(m_descriptor, &status) == 0 &&
+               ::stat(m_file.path.c_str(), &current) == 0 && current.st_dev == status.st_dev &&
+               current.st_ino == status.st_ino;
+    }
+
+    /** Is the name of a rotated file taken?
+     *
+     * @param rotated is the name
+     * @returns true if a file is there by the name, compressed or not, otherwise false
+     */
+    [[nodiscard]] static bool isTaken(const std::string& rotated) noexcept
+    {
+        std::error_code error;
+        return std::filesystem::exists(rotated, error) ||
+               std::filesystem::exists(rotated + ".gz", error);
+    }
+
+    /** Open the path anew
+     *
+     * @param now is the time the file is opened at
+     * @returns true if opened, otherwise false
+     */
+    bool reopen(const std::time_t now) noexcept
+    {
+        m_descriptor = ::open(m_file.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                              0644);  // NOLINT(hicpp-signed-bitwise)
+        if (m_descriptor < 0)
+        {
+            return false;
+        }
+
+        struct stat status = {};
+        m_size = (::fstat(m_descriptor, &status) == 0) ? static_cast<size_t>(status.st_size) : 0;
+        m_allocated = m_size;
+        m_openedAt = now;
+        ++m_generation;
+        return true;
+    }
+
+    /// Represents how many bytes are allocated at once, for files which do not rotate by size
+    static constexpr size_t k_Allocation{size_t{16} << 20};
+
+    /// The file
+    File m_file;
+
+    /// The descriptor of the file, negative if none is open
+    int m_descriptor{-1};
+
+    /// The size of the file, as of when it was last locked
+    size_t m_size{0};
+
+    /// The bytes allocated to the file
+    size_t m_allocated{0};
+
+    /// When the file was opened
+    std::time_t m_openedAt{0};
+
+    /// How many times the path was opened
+    size_t m_generation{0};
+
+    /// The compressor of rotated files, made for the first file to be compressed
+    std::unique_ptr<Compressor> m_compressor;
+};
+
+}  // namespace pizza::log::details
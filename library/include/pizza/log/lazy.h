@@ -0,0 +1,74 @@
+/**
+ * @file pizza/log/lazy.h
+ * @brief The lazy arguments of logs
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/support.h>
+
+namespace pizza::log
+{
+
+/**
+ * A lazy argument, computed only if the log it is an argument of gets written
+ *
+ * @tparam Function is the type of the function computing the argument
+ */
+template <typename Function>
+class Lazy final
+{
+   public:
+    /// Represents the type of the argument
+    using Result = std::remove_cvref_t<std::invoke_result_t<const Function&>>;
+
+    /** Constructor
+     *
+     * @param function computes the argument
+     */
+    explicit Lazy(Function function) noexcept : m_function{std::move(function)} {}
+
+    /** Compute the argument
+     *
+     * @returns the argument
+     */
+    [[nodiscard]] Result operator()() const noexcept { return m_function(); }
+
+   private:
+    /// The function computing the argument
+    Function m_function;
+};
+
+/** Make a lazy argument
+ *
+ * @tparam Function is the type of the function computing the argument
+ * @param function computes the argument
+ * @returns the lazy argument
+ *
+ * @note e.g. `m_log.debug("Content of cake is {}", lazy([&cake] { return cake.dump(); }))`
+ */
+template <typename Function>
+[[nodiscard]] Lazy<Function> lazy(Function function) noexcept
+{
+    return Lazy<Function>{std::move(function)};
+}
+
+}  // namespace pizza::log
+
+namespace fmt
+{
+
+/// Formats a lazy argument as what it computes
+template <typename Function>
+struct formatter<pizza::log::Lazy<Function>>
+    : formatter<typename pizza::log::Lazy<Function>::Result>
+{
+    template <typename FormatContext>
+    auto format(const pizza::log::Lazy<Function>& lazy, FormatContext& context)
+    {
+        return formatter<typename pizza::log::Lazy<Function>::Result>::format(lazy(), context);
+    }
+};
+
+}  // namespace fmt
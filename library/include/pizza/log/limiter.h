@@ -0,0 +1,106 @@
+/**
+ * @file pizza/log/limiter.h
+ * @brief The limiter of logs made at a call site
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/support.h>
+
+namespace pizza::log::details
+{
+
+/// Represents how many logs every call site writes, at most
+struct Sampling final
+{
+    uint32_t rate{0};   ///< Represents the logs written whole every second, 0 for no limit
+    uint32_t every{0};  ///< Represents writing one in so many logs past the rate, 0 for none
+};
+
+/**
+ * The limiter of logs made at a call site
+ *
+ * @brief
+ * Lets a call site write so many logs every second, and samples the logs past those, so that an
+ * error storm costs a bounded amount of output no matter how many requests fail
+ *
+ * @details
+ * The second and the logs made during it share a single word, so that a log takes a single
+ * compare-and-swap to be let through or not. The logs which are not are counted, for the backend
+ * to report once a second.
+ *
+ * @private
+ */
+class Limiter final
+{
+    NOT_COPYABLE_CLASS(Limiter)
+    IMMOVEABLE_CLASS(Limiter)
+
+   public:
+    /** Constructor
+     *
+     * @param site is the call site, as reported along with the logs it suppressed
+     */
+    explicit Limiter(std::string site) noexcept : m_site{std::move(site)} {}
+
+    /** Let a log through, or not
+     *
+     * @param now is the time of the log
+     * @param sampling is how many logs are let through
+     * @returns true if the log is written, otherwise false as it is suppressed
+     */
+    [[nodiscard]] bool tryAcquire(const std::time_t now, const Sampling sampling) noexcept
+    {
+        if (sampling.rate == 0)
+        {
+            return true;
+        }
+
+        const auto second = static_cast<uint32_t>(now);
+        auto window = m_window.load(std::memory_order_relaxed);
+        uint64_t next = 0;
+        do
+        {
+            next = (static_cast<uint32_t>(window >> 32U) == second)
+                       ? window + 1
+                       : (static_cast<uint64_t>(second) << 32U) + 1;
+        } while (!m_window.compare_exchange_weak(window, next, std::memory_order_relaxed));
+
+        const auto count = static_cast<uint32_t>(next);
+        if (count <= sampling.rate ||
+            (sampling.every != 0 && (count - sampling.rate) % sampling.every == 0))
+        {
+            return true;
+        }
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /** Take the count of logs suppressed so far
+     *
+     * @returns the count, which starts over from zero
+     */
+    [[nodiscard]] uint64_t takeSuppressed() noexcept
+    {
+        return m_suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    /** Get the call site
+     *
+     * @returns the call site, as reported along with the logs it suppressed
+     */
+    [[nodiscard]] std::string_view getSite() const noexcept { return m_site; }
+
+   private:
+    /// The call site, as reported along with the logs it suppressed
+    const std::string m_site;
+
+    /// The current second in the upper half, and the logs made during it in the lower half
+    std::atomic<uint64_t> m_window{0};
+
+    /// The logs suppressed since last taken
+    std::atomic<uint64_t> m_suppressed{0};
+};
+
+}  // namespace pizza::log::details
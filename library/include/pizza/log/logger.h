@@ -7,10 +7,95 @@
 #pragma once
 
 #include "details.h"
+#include "lazy.h"
 
 namespace pizza::log
 {
 
+/// Allow pizza::log::Level alias to pizza::log::details::Level
+using Level = details::Level;
+
+/// Allow pizza::log::Overflow alias to pizza::log::details::Overflow
+using Overflow = details::Overflow;
+
+/// Allow pizza::log::Output alias to pizza::log::details::Output
+using Output = details::Output;
+
+/// Allow pizza::log::Sampling alias to pizza::log::details::Sampling
+using Sampling = details::Sampling;
+
+/// Allow pizza::log::File alias to pizza::log::details::File
+using File = details::File;
+
+/// Allow pizza::log::Options alias to pizza::log::details::Options
+using Options = details::Options;
+
+/** Configure how logs are written
+ *
+ * @param options are the options
+ */
+inline void configure(const Options& options) noexcept
+{
+    details::Backend::getBackend().configure(options);
+}
+
+/** Set the lowest level written, by loggers which have no level of their own
+ *
+ * @param level is the level
+ */
+inline void setLevel(const Level level) noexcept
+{
+    details::Backend::getBackend().setLevel(level);
+}
+
+/** Set how logs are written out
+ *
+ * @param output is the output
+ *
+ * @note Logs made so far are written first, so that text and binary logs do not interleave
+ */
+inline void setOutput(const Output output) noexcept
+{
+    details::Backend::getBackend().flush();
+    details::Backend::getBackend().setOutput(output);
+}
+
+/** Set how many logs every call site writes, fatal logs aside
+ *
+ * @param sampling is the sampling
+ */
+inline void setSampling(const Sampling sampling) noexcept
+{
+    details::Backend::getBackend().setSampling(sampling);
+}
+
+/** Set the file logs are written to, instead of stdout and stderr
+ *
+ * @param file is the file, whose path is empty for stdout and stderr
+ *
+ * @note The file is opened, rotated and compressed in the background
+ */
+inline void setFile(File file) noexcept
+{
+    details::Backend::getBackend().setFile(std::move(file));
+}
+
+/** Is a level written, by loggers which have no level of their own?
+ *
+ * @param level is the level
+ * @returns true if logs of the level are written, otherwise false
+ */
+[[nodiscard]] inline bool isEnabled(const Level level) noexcept
+{
+    return level >= details::k_MinLevel && level >= details::Backend::getBackend().getLevel();
+}
+
+/// Wait until every log made so far is written
+inline void flush() noexcept
+{
+    details::Backend::getBackend().flush();
+}
+
 /** Write debug message to stdout
  *
  * @tparam Args are the types of arguments
@@ -19,9 +104,16 @@ namespace pizza::log
  * @param args are the arguments
  */
 template <typename... Args>
-void debug(const std::string_view where, const std::string_view what, const Args&... args) noexcept
+void debug(const std::string_view where, const details::Message what,
+           const Args&... args) noexcept
 {
-    details::writeStdout(details::Level::Debug, where, what, args...);
+    if constexpr (details::k_MinLevel <= Level::Debug)
+    {
+        if (isEnabled(Level::Debug))
+        {
+            details::writeStdout(Level::Debug, where, what, args...);
+        }
+    }
 }
 
 /** Write info message to stdout
@@ -32,9 +124,16 @@ void debug(const std::string_view where, const std::string_view what, const Args
  * @param args are the arguments
  */
 template <typename... Args>
-void info(const std::string_view where, const std::string_view what, const Args&... args) noexcept
+void info(const std::string_view where, const details::Message what,
+          const Args&... args) noexcept
 {
-    details::writeStdout(details::Level::Info, where, what, args...);
+    if constexpr (details::k_MinLevel <= Level::Info)
+    {
+        if (isEnabled(Level::Info))
+        {
+            details::writeStdout(Level::Info, where, what, args...);
+        }
+    }
 }
 
 /** Write warn message to stderr
@@ -45,9 +144,16 @@ void info(const std::string_view where, const std::string_view what, const Args&
  * @param args are the arguments
  */
 template <typename... Args>
-void warn(const std::string_view where, const std::string_view what, const Args&... args) noexcept
+void warn(const std::string_view where, const details::Message what,
+          const Args&... args) noexcept
 {
-    details::writeStderr(details::Level::Warn, where, what, args...);
+    if constexpr (details::k_MinLevel <= Level::Warn)
+    {
+        if (isEnabled(Level::Warn))
+        {
+            details::writeStderr(Level::Warn, where, what, args...);
+        }
+    }
 }
 
 /** Write error message to stderr
@@ -58,38 +164,94 @@ void warn(const std::string_view where, const std::string_view what, const Args&
  * @param args are the arguments
  */
 template <typename... Args>
-void error(const std::string_view where, const std::string_view what, const Args&... args) noexcept
+void error(const std::string_view where, const details::Message what,
+           const Args&... args) noexcept
 {
-    details::writeStderr(details::Level::Error, where, what, args...);
+    if constexpr (details::k_MinLevel <= Level::Error)
+    {
+        if (isEnabled(Level::Error))
+        {
+            details::writeStderr(Level::Error, where, what, args...);
+        }
+    }
 }
 
-/** Write fatal message to stderr
+/** Write fatal message to stderr, and wait until it is written
  *
  * @tparam Args are the types of arguments
  * @param where is where this log occurs
  * @param what is the message to print
  * @param args are the arguments
+ *
+ * @note Fatal messages are always written
  */
 template <typename... Args>
-void fatal(const std::string_view where, const std::string_view what, const Args&... args) noexcept
+void fatal(const std::string_view where, const details::Message what,
+           const Args&... args) noexcept
 {
-    details::writeStderr(details::Level::Fatal, where, what, args...);
+    details::writeStderr(Level::Fatal, where, what, args...);
+    flush();
 }
 
 /**
  * The logger
+ *
+ * @note Arguments which are expensive to compute can be made lazy, so that they are computed only
+ * if the log gets written, e.g. `m_log.debug("{}", lazy([&cake] { return cake.dump(); }))`
+ *
+ * @note Messages known at compile time can be given as template arguments instead, so that binary
+ * logs carry their arguments only, and are formatted once decoded, e.g. `m_log.info<"{}">(cake)`.
+ *
+ * @note Every call site is rate limited on its own, whichever way its message is given, see
+ * setSampling
  */
 class Logger final
 {
     DEFAULT_DESTRUCTIBLE_FINAL_CLASS(Logger)
 
    public:
-    /** Constructor
+    /** Constructor, of a logger which writes the levels set by setLevel
      *
      * @param where is where the logs occur
      */
     explicit Logger(const std::string_view where) noexcept : m_where{where} {}
 
+    /** Constructor, of a logger which has a level of its own
+     *
+     * @param where is where the logs occur
+     * @param level is the lowest level written
+     */
+    explicit Logger(const std::string_view where, const Level level) noexcept
+        : m_where{where}, m_level{level}
+    {
+    }
+
+    /** Set the lowest level written
+     *
+     * @param level is the level, or nothing to write the levels set by pizza::log::setLevel
+     *
+     * @note The level is not what the logger is, hence const loggers may have it set as well
+     */
+    void setLevel(const std::optional<Level> level) const noexcept
+    {
+        m_level.store(level, std::memory_order_relaxed);
+    }
+
+    /** Is a level written?
+     *
+     * @param level is the level
+     * @returns true if logs of the level are written, otherwise false
+     */
+    [[nodiscard]] bool isEnabled(const Level level) const noexcept
+    {
+        if (level < details::k_MinLevel)
+        {
+            return false;
+        }
+        const auto ownLevel = m_level.load(std::memory_order_relaxed);
+        return ownLevel ? (level >= *ownLevel) : pizza::log::isEnabled(level);
+    }
+
     /** Write debug message to stdout
      *
      * @tparam Args are the types of arguments
@@ -97,9 +259,15 @@ class Logger final
      * @param args are the arguments
      */
     template <typename... Args>
-    void debug(const std::string_view what, const Args&... args) const noexcept
+    void debug(const details::Message what, const Args&... args) const noexcept
     {
-        pizza::log::debug(m_where, what, args...);
+        if constexpr (details::k_MinLevel <= Level::Debug)
+        {
+            if (isEnabled(Level::Debug))
+            {
+                details::writeStdout(Level::Debug, m_where, what, args...);
+            }
+        }
     }
 
     /** Write info message to stdout
@@ -109,9 +277,15 @@ class Logger final
      * @param args are the arguments
      */
     template <typename... Args>
-    void info(const std::string_view what, const Args&... args) const noexcept
+    void info(const details::Message what, const Args&... args) const noexcept
     {
-        pizza::log::info(m_where, what, args...);
+        if constexpr (details::k_MinLevel <= Level::Info)
+        {
+            if (isEnabled(Level::Info))
+            {
+                details::writeStdout(Level::Info, m_where, what, args...);
+            }
+        }
     }
 
     /** Write warn message to stderr
@@ -121,9 +295,15 @@ class Logger final
      * @param args are the arguments
      */
     template <typename... Args>
-    void warn(const std::string_view what, const Args&... args) const noexcept
+    void warn(const details::Message what, const Args&... args) const noexcept
     {
-        pizza::log::warn(m_where, what, args...);
+        if constexpr (details::k_MinLevel <= Level::Warn)
+        {
+            if (isEnabled(Level::Warn))
+            {
+                details::writeStderr(Level::Warn, m_where, what, args...);
+            }
+        }
     }
 
     /** Write error message to stderr
@@ -133,23 +313,119 @@ class Logger final
      * @param args are the arguments
      */
     template <typename... Args>
-    void error(const std::string_view what, const Args&... args) const noexcept
+    void error(const details::Message what, const Args&... args) const noexcept
     {
-        pizza::log::error(m_where, what, args...);
+        if constexpr (details::k_MinLevel <= Level::Error)
+        {
+            if (isEnabled(Level::Error))
+            {
+                details::writeStderr(Level::Error, m_where, what, args...);
+            }
+        }
     }
 
-    /** Write fatal message to stderr
+    /** Write fatal message to stderr, and wait until it is written
      *
      * @tparam Args are the types of arguments
      * @param what is the message to print
      * @param args are the arguments
+     *
+     * @note Fatal messages are always written
      */
     template <typename... Args>
-    void fatal(const std::string_view what, const Args&... args) const noexcept
+    void fatal(const details::Message what, const Args&... args) const noexcept
     {
         pizza::log::fatal(m_where, what, args...);
     }
 
+    /** Write debug message to stdout, of a message known at compile time
+     *
+     * @tparam What is the message to print
+     * @tparam Args are the types of arguments
+     * @param args are the arguments
+     */
+    template <details::FormatString What, typename... Args>
+    void debug(const Args&... args) const noexcept
+    {
+        if constexpr (details::k_MinLevel <= Level::Debug)
+        {
+            if (isEnabled(Level::Debug))
+            {
+                details::writeStdout<What>(Level::Debug, m_where, args...);
+            }
+        }
+    }
+
+    /** Write info message to stdout, of a message known at compile time
+     *
+     * @tparam What is the message to print
+     * @tparam Args are the types of arguments
+     * @param args are the arguments
+     */
+    template <details::FormatString What, typename... Args>
+    void info(const Args&... args) const noexcept
+    {
+        if constexpr (details::k_MinLevel <= Level::Info)
+        {
+            if (isEnabled(Level::Info))
+            {
+                details::writeStdout<What>(Level::Info, m_where, args...);
+            }
+        }
+    }
+
+    /** Write warn message to stderr, of a message known at compile time
+     *
+     * @tparam What is the message to print
+     * @tparam Args are the types of arguments
+     * @param args are the arguments
+     */
+    template <details::FormatString What, typename... Args>
+    void warn(const Args&... args) const noexcept
+    {
+        if constexpr (details::k_MinLevel <= Level::Warn)
+        {
+            if (isEnabled(Level::Warn))
+            {
+                details::writeStderr<What>(Level::Warn, m_where, args...);
+            }
+        }
+    }
+
+    /** Write error message to stderr, of a message known at compile time
+     *
+     * @tparam What is the message to print
+     * @tparam Args are the types of arguments
+     * @param args are the arguments
+     */
+    template <details::FormatString What, typename... Args>
+    void error(const Args&... args) const noexcept
+    {
+        if constexpr (details::k_MinLevel <= Level::Error)
+        {
+            if (isEnabled(Level::Error))
+            {
+                details::writeStderr<What>(Level::Error, m_where, args...);
+            }
+        }
+    }
+
+    /** Write fatal message to stderr, of a message known at compile time, and wait until it is
+     * written
+     *
+     * @tparam What is the message to print
+     * @tparam Args are the types of arguments
+     * @param args are the arguments
+     *
+     * @note Fatal messages are always written
+     */
+    template <details::FormatString What, typename... Args>
+    void fatal(const Args&... args) const noexcept
+    {
+        details::writeStderr<What>(Level::Fatal, m_where, args...);
+        pizza::log::flush();
+    }
+
     /**
      * @returns registered name of this logger
      */
@@ -157,6 +433,9 @@ class Logger final
 
    private:
     const std::string_view m_where;
+
+    /// The lowest level written, nothing for the levels set by pizza::log::setLevel
+    mutable std::atomic<std::optional<Level>> m_level{std::nullopt};
 };
 
 }  // namespace pizza::log
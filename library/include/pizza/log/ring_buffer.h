@@ -0,0 +1,219 @@
+/**
+ * @file pizza/log/ring_buffer.h
+ * @brief The Ring Buffer of log records
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <pizza/support.h>
+
+namespace pizza::log::details
+{
+
+/**
+ * The Ring Buffer of log records
+ *
+ * @brief
+ * A ring of bytes written by a single thread and read by a single other thread, without locks:
+ * each side owns its own position, and only publishes it to the other side
+ *
+ * @details
+ * Records are laid out one after the other, every one behind a header which tells its size and
+ * the stream it goes to, and are never split by the end of the ring, so that the reader hands them
+ * to writev as they are. A record which does not fit before the end of the ring leaves a padding
+ * record behind and starts over at the beginning.
+ *
+ * @private
+ */
+class RingBuffer final
+{
+    NOT_COPYABLE_CLASS(RingBuffer)
+    IMMOVEABLE_CLASS(RingBuffer)
+
+   public:
+    /// Represents the header of a record
+    struct Header final
+    {
+        uint32_t size;    ///< Represents the size of the record, without its header
+        uint32_t stream;  ///< Represents the stream of the record, k_Padding for padding
+    };
+
+    /// Represents the stream of padding records
+    static constexpr uint32_t k_Padding{std::numeric_limits<uint32_t>::max()};
+
+    /** Constructor
+     *
+     * @param capacity is the capacity in bytes, rounded up to a power of two
+     */
+    explicit RingBuffer(const size_t capacity) noexcept
+        : m_buffer(std::bit_ceil(std::max(capacity, k_MinCapacity))), m_mask{m_buffer.size() - 1}
+    {
+    }
+
+    /** Push a record, by the writer
+     *
+     * @param stream is the stream of the record
+     * @param record is the record
+     * @returns true if pushed, otherwise false as the ring has no room for it
+     *
+     * @note Records longer than getMaxRecord are truncated, and still end with a newline
+     */
+    [[nodiscard]] bool tryPush(const uint32_t stream, std::string_view record) noexcept
+    {
+        const auto isTruncated = record.size() > getMaxRecord();
+        if (isTruncated)
+        {
+            record = record.substr(0, getMaxRecord() - 1);
+        }
+        const auto length = record.size() + (isTruncated ? 1 : 0);
+        const auto size = align(sizeof(Header) + length);
+
+        const auto head = m_head.load(std::memory_order_relaxed);
+        const auto contiguous = m_buffer.size() - (head & m_mask);
+        const auto needed = (size > contiguous) ? contiguous + size : size;
+        if (needed > m_buffer.size() - (head - m_tailCache))
+        {
+            // The cached position of the reader is stale more often than not, hence the real one
+            // is only looked at when the ring seems full
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (needed > m_buffer.size() - (head - m_tailCache))
+            {
+                return false;
+            }
+        }
+
+        auto position = head;
+        if (size > contiguous)
+        {
+            writeHeader(position, {static_cast<uint32_t>(contiguous - sizeof(Header)), k_Padding});
+            position += contiguous;
+        }
+        writeHeader(position, {static_cast<uint32_t>(length), stream});
+        auto* const bytes = &m_buffer[(position & m_mask) + sizeof(Header)];
+        std::memcpy(bytes, record.data(), record.size());
+        if (isTruncated)
+        {
+            bytes[record.size()] = '\n';
+        }
+        m_head.store(position + size, std::memory_order_release);
+        return true;
+    }
+
+    /** Get the size of the longest record pushed whole
+     *
+     * @returns the size, a quarter of the ring without the header
+     */
+    [[nodiscard]] size_t getMaxRecord() const noexcept
+    {
+        return m_buffer.size() / 4 - sizeof(Header);
+    }
+
+    /** Visit the records pushed so far, by the reader
+     *
+     * @tparam Visitor is the type of the visiting function
+     * @param visitor is called with the stream and the bytes of every record
+     * @returns the position after the last record visited, to be released once they are consumed
+     *
+     * @note The bytes of the records stay valid until they are released
+     */
+    template <typename Visitor>
+    [[nodiscard]] size_t visit(const Visitor& visitor) const noexcept
+    {
+        const auto head = m_head.load(std::memory_order_acquire);
+        auto position = m_tail.load(std::memory_order_relaxed);
+        while (position != head)
+        {
+            Header header{};
+            std::memcpy(&header, &m_buffer[position & m_mask], sizeof(Header));
+            if (header.stream != k_Padding)
+            {
+                visitor(header.stream,
+                        std::string_view{&m_buffer[(position & m_mask) + sizeof(Header)],
+                                         header.size});
+            }
+            position += align(sizeof(Header) + header.size);
+        }
+        return position;
+    }
+
+    /** Release the records visited, by the reader
+     *
+     * @param position is the position returned by visit
+     */
+    void release(const size_t position) noexcept
+    {
+        m_tail.store(position, std::memory_order_release);
+    }
+
+    /** Get the position the writer has published
+     *
+     * @returns the position after the last record pushed
+     */
+    [[nodiscard]] size_t getHead() const noexcept { return m_head.load(std::memory_order_acquire); }
+
+    /** Get the position the reader has released
+     *
+     * @returns the position after the last record released
+     */
+    [[nodiscard]] size_t getTail() const noexcept { return m_tail.load(std::memory_order_acquire); }
+
+    /// Tell the reader that the writer is gone, after its last push
+    void abandon() noexcept { m_isAbandoned.store(true, std::memory_order_release); }
+
+    /** Is the writer gone?
+     *
+     * @returns true if the writer will never push again, otherwise false
+     */
+    [[nodiscard]] bool isAbandoned() const noexcept
+    {
+        return m_isAbandoned.load(std::memory_order_acquire);
+    }
+
+   private:
+    /** Align a size to the alignment of headers
+     *
+     * @param size is the size
+     * @returns the size rounded up to the alignment of headers
+     */
+    [[nodiscard]] static constexpr size_t align(const size_t size) noexcept
+    {
+        return (size + sizeof(Header) - 1) & ~(sizeof(Header) - 1);
+    }
+
+    /** Write a header
+     *
+     * @param position is where the header goes
+     * @param header is the header
+     */
+    void writeHeader(const size_t position, const Header& header) noexcept
+    {
+        std::memcpy(&m_buffer[position & m_mask], &header, sizeof(Header));
+    }
+
+    /// Represents the smallest capacity
+    static constexpr size_t k_MinCapacity{4096};
+
+    /// Represents the size of a cache line, which the positions of either side do not share
+    static constexpr size_t k_CacheLine{64};
+
+    /// The bytes of the ring
+    std::vector<char> m_buffer;
+
+    /// The mask turning positions into indices
+    const size_t m_mask;
+
+    /// The position after the last record pushed, owned by the writer
+    alignas(k_CacheLine) std::atomic<size_t> m_head{0};
+
+    /// The position of the reader, as the writer last saw it
+    size_t m_tailCache{0};
+
+    /// The position after the last record released, owned by the reader
+    alignas(k_CacheLine) std::atomic<size_t> m_tail{0};
+
+    /// Indicates if the writer is gone
+    std::atomic<bool> m_isAbandoned{false};
+};
+
+}  // namespace pizza::log::details
@@ -0,0 +1,38 @@
+/**
+ * @file pizza/thread.h
+ * @brief Threads of the library itself
+ * @copyright Copyleft 2022 "unrealinsanity". All rights reversed.
+ */
+
+#pragma once
+
+#include <external/posix/all.h>
+#include <pizza/support.h>
+
+namespace pizza
+{
+
+/** Make a thread which no signal is ever delivered to
+ *
+ * @tparam Function is the type of the function the thread runs
+ * @param function is the function the thread runs, given a stop token if it takes one
+ * @returns the thread
+ *
+ * @details
+ * Every signal is blocked while the thread is made, hence from its very first instruction on, so
+ * that signals the process waits for with sigwait never land on a thread of the library, even one
+ * made before the process got to block them, such as by a log made during static initialization.
+ */
+template <typename Function>
+[[nodiscard]] std::jthread makeThread(Function&& function) noexcept
+{
+    sigset_t signals;
+    sigfillset(&signals);
+    sigset_t previous;
+    pthread_sigmask(SIG_SETMASK, &signals, &previous);
+    std::jthread thread{std::forward<Function>(function)};
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    return thread;
+}
+
+}  // namespace pizza